@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2022 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+#
+
+"""
+Summarize boot timelines printed by the "boot_timeline" shell command.
+
+Capture the shell output to a file, for instance with the terminal logging of the serial
+console, and run:
+
+    boot_timeline.py capture.log
+
+Lines that are not part of the CSV output, such as shell prompts and log messages, are
+ignored. For every boot stage the time since reset and the time since the previous stage are
+printed as min/mean/max over all captured boots, followed by the stage transitions sorted by
+mean duration, which are the first candidates for optimization.
+"""
+
+import argparse
+import re
+import statistics
+import sys
+
+ROW = re.compile(r'(\d+),([\w:]+),(\d+)\s*$')
+
+
+def parse(lines):
+    boots = {}
+    for line in lines:
+        match = ROW.search(line)
+        if match:
+            boot, event, time_us = match.groups()
+            boots.setdefault(int(boot), {})[event] = int(time_us)
+    return boots
+
+
+def stats(values):
+    return min(values), statistics.mean(values), max(values)
+
+
+def fmt_ms(values):
+    low, mean, high = stats(values)
+    return f'{low / 1000:10.1f} {mean / 1000:10.1f} {high / 1000:10.1f}'
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Summarize boot timelines.',
+        formatter_class=argparse.RawDescriptionHelpFormatter, epilog=__doc__)
+    parser.add_argument('capture', nargs='?', help='captured shell output, default stdin')
+    args = parser.parse_args()
+
+    if args.capture:
+        with open(args.capture, encoding='utf-8', errors='replace') as f:
+            boots = parse(f)
+    else:
+        boots = parse(sys.stdin)
+
+    if not boots:
+        sys.exit('error: no boot timeline rows found')
+
+    # Stages and modules are ordered by their mean time since reset.
+    events = {}
+    for timeline in boots.values():
+        for event, time_us in timeline.items():
+            events.setdefault(event, []).append(time_us)
+    order = sorted(events, key=lambda e: statistics.mean(events[e]))
+
+    print(f'{len(boots)} boot(s), times in ms')
+    print(f'{"event":24} {"min":>10} {"mean":>10} {"max":>10}   '
+          f'{"step min":>10} {"step mean":>10} {"step max":>10}')
+
+    steps = {}
+    previous = None
+    for event in order:
+        deltas = [t[event] - t[previous] for t in boots.values()
+                  if previous and event in t and previous in t]
+        line = f'{event:24} {fmt_ms(events[event])}'
+        if deltas:
+            line += f'   {fmt_ms(deltas)}'
+            steps[f'{previous} -> {event}'] = statistics.mean(deltas)
+        print(line)
+        previous = event
+
+    print('\nSlowest steps:')
+    for step, mean in sorted(steps.items(), key=lambda s: s[1], reverse=True)[:5]:
+        print(f'  {mean / 1000:10.1f} ms  {step}')
+
+
+if __name__ == '__main__':
+    main()
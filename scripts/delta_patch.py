@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2021 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+#
+
+"""
+Generate and apply delta patches for application FOTA.
+
+A patch rebuilds a new signed application image (app_update.bin) from the image currently
+in the MCUboot primary slot. The patch format is documented in src/fota/delta_patch.h.
+
+Create a patch between two builds:
+
+    delta_patch.py diff old/app_update.bin new/app_update.bin -o app_update.patch
+
+Verify a patch on the host:
+
+    delta_patch.py apply old/app_update.bin app_update.patch -o rebuilt.bin
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+MAGIC = b'ATDP'
+VERSION = 1
+HDR_FORMAT = '<4sB3xIIII'
+
+OP_DIFF = 0x01
+OP_INSERT = 0x02
+
+# Length of the exact match used to look up candidate source positions.
+KEY_LEN = 8
+# Minimum exact match length for starting a DIFF operation.
+MIN_MATCH = 16
+# Maximum number of source positions kept per lookup key.
+CANDIDATES_MAX = 8
+# A DIFF operation stops once the match score has dropped this far below its best value.
+SCORE_DROP_MAX = 32
+# Maximum length of a single run in the diff data encoding.
+RUN_MAX = 128
+
+
+def build_index(src):
+    index = {}
+    for i in range(len(src) - KEY_LEN + 1):
+        positions = index.setdefault(src[i:i + KEY_LEN], [])
+        if len(positions) < CANDIDATES_MAX:
+            positions.append(i)
+    return index
+
+
+def exact_match_len(src, s, tgt, t):
+    length = 0
+    limit = min(len(src) - s, len(tgt) - t)
+    step = 64
+    while length + step <= limit and src[s + length:s + length + step] == \
+            tgt[t + length:t + length + step]:
+        length += step
+    while length < limit and src[s + length] == tgt[t + length]:
+        length += 1
+    return length
+
+
+def approximate_extend(src, s, tgt, t, exact):
+    """Extend a match forward allowing mismatches, as long as bytes mostly match."""
+    limit = min(len(src) - s, len(tgt) - t)
+    i = exact
+    score = best_score = exact
+    best_len = exact
+    while i < limit:
+        if src[s + i] == tgt[t + i]:
+            run = exact_match_len(src, s + i, tgt, t + i)
+            i += run
+            score += run
+        else:
+            i += 1
+            score -= 1
+        if score > best_score:
+            best_score = score
+            best_len = i
+        elif score < best_score - SCORE_DROP_MAX:
+            break
+    return best_len
+
+
+def encode_diff(diff):
+    out = bytearray()
+    i = 0
+    while i < len(diff):
+        j = i
+        if diff[i] == 0:
+            while j < len(diff) and diff[j] == 0 and j - i < RUN_MAX:
+                j += 1
+            out.append(0x80 | (j - i - 1))
+        else:
+            # Literal run, ended by a pair of zeros which is cheaper to encode as a run.
+            while j < len(diff) and j - i < RUN_MAX:
+                if diff[j] == 0 and j + 1 < len(diff) and diff[j + 1] == 0:
+                    break
+                j += 1
+            out.append(j - i - 1)
+            out += diff[i:j]
+        i = j
+    return out
+
+
+def diff(src, tgt):
+    index = build_index(src)
+    ops = bytearray()
+    t = 0
+    insert_start = 0
+    # Source to target offset of the previous DIFF operation, tried first as code that
+    # was not changed keeps its relative position.
+    last_offset = 0
+    stats = {'diff': 0, 'insert': 0}
+
+    def flush_insert(end):
+        if end > insert_start:
+            ops.extend(struct.pack('<BI', OP_INSERT, end - insert_start))
+            ops.extend(tgt[insert_start:end])
+            stats['insert'] += end - insert_start
+
+    while t < len(tgt):
+        best_s = -1
+        best_len = 0
+        candidates = [t + last_offset] + index.get(tgt[t:t + KEY_LEN], [])
+        for s in candidates:
+            if 0 <= s < len(src):
+                length = exact_match_len(src, s, tgt, t)
+                if length > best_len:
+                    best_s, best_len = s, length
+
+        if best_len < MIN_MATCH:
+            t += 1
+            continue
+
+        flush_insert(t)
+        length = approximate_extend(src, best_s, tgt, t, best_len)
+        delta = bytes((tgt[t + i] - src[best_s + i]) & 0xFF for i in range(length))
+        ops.extend(struct.pack('<BII', OP_DIFF, best_s, length))
+        ops.extend(encode_diff(delta))
+        stats['diff'] += length
+
+        last_offset = best_s - t
+        t += length
+        insert_start = t
+
+    flush_insert(len(tgt))
+
+    hdr = struct.pack(HDR_FORMAT, MAGIC, VERSION, len(src), zlib.crc32(src),
+                      len(tgt), zlib.crc32(tgt))
+    return hdr + ops, stats
+
+
+def apply(src, patch):
+    magic, version, src_size, src_crc, tgt_size, tgt_crc = \
+        struct.unpack_from(HDR_FORMAT, patch)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError('invalid patch header')
+    if src_size > len(src) or zlib.crc32(src[:src_size]) != src_crc:
+        raise ValueError('patch was not made for this source image')
+
+    out = bytearray()
+    pos = struct.calcsize(HDR_FORMAT)
+    while pos < len(patch):
+        op = patch[pos]
+        if op == OP_DIFF:
+            s, length = struct.unpack_from('<II', patch, pos + 1)
+            pos += 9
+            end = s + length
+            while s < end:
+                ctrl = patch[pos]
+                pos += 1
+                run = (ctrl & 0x7F) + 1
+                if ctrl & 0x80:
+                    out += src[s:s + run]
+                else:
+                    out += bytes((a + b) & 0xFF for a, b in
+                                 zip(src[s:s + run], patch[pos:pos + run]))
+                    pos += run
+                s += run
+        elif op == OP_INSERT:
+            length, = struct.unpack_from('<I', patch, pos + 1)
+            pos += 5
+            out += patch[pos:pos + length]
+            pos += length
+        else:
+            raise ValueError(f'unknown operation 0x{op:02x} at offset {pos}')
+
+    if len(out) != tgt_size or zlib.crc32(out) != tgt_crc:
+        raise ValueError('rebuilt image does not match the patch')
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Generate and apply application delta patches.',
+        formatter_class=argparse.RawDescriptionHelpFormatter, epilog=__doc__)
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    diff_parser = sub.add_parser('diff', help='create a patch from two images')
+    diff_parser.add_argument('old', help='image currently running on the device')
+    diff_parser.add_argument('new', help='image to update to')
+    diff_parser.add_argument('-o', '--output', required=True, help='patch file')
+
+    apply_parser = sub.add_parser('apply', help='rebuild an image from a patch')
+    apply_parser.add_argument('old', help='source image')
+    apply_parser.add_argument('patch', help='patch file')
+    apply_parser.add_argument('-o', '--output', required=True, help='rebuilt image')
+
+    args = parser.parse_args()
+
+    with open(args.old, 'rb') as f:
+        src = f.read()
+
+    if args.command == 'diff':
+        with open(args.new, 'rb') as f:
+            tgt = f.read()
+        patch, stats = diff(src, tgt)
+        # Verify before writing, a broken patch would be rejected by the device anyway.
+        apply(src, patch)
+        with open(args.output, 'wb') as f:
+            f.write(patch)
+        print(f'{args.output}: {len(patch)} bytes, {100 * len(patch) / len(tgt):.1f}% of '
+              f'{len(tgt)} bytes ({stats["diff"]} bytes diffed, '
+              f'{stats["insert"]} bytes inserted)')
+    else:
+        with open(args.patch, 'rb') as f:
+            patch = f.read()
+        try:
+            out = apply(src, patch)
+        except ValueError as e:
+            sys.exit(f'error: {e}')
+        with open(args.output, 'wb') as f:
+            f.write(out)
+        print(f'{args.output}: {len(out)} bytes')
+
+
+if __name__ == '__main__':
+    main()
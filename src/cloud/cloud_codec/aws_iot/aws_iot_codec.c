@@ -505,6 +505,14 @@ exit:
 	return err;
 }
 
+int cloud_codec_encode_impact_windows(struct cloud_codec_data *output,
+				      const uint8_t *window_buf,
+				      size_t window_buf_len)
+{
+	/* Encoding of impact waveforms is not defined for this cloud. */
+	return -ENOTSUP;
+}
+
 int cloud_codec_encode_batch_data(struct cloud_codec_data *output,
 				  struct cloud_data_gnss *gnss_buf,
 				  struct cloud_data_sensors *sensor_buf,
@@ -35,6 +35,8 @@
 #define DATA_MODEM_DYNAMIC  "roam"
 #define DATA_MODEM_STATIC   "dev"
 #define DATA_BATTERY	    "bat"
+#define DATA_BATTERY_SOC    "soc"
+#define DATA_BATTERY_LIFE   "life"
 #define DATA_TEMPERATURE    "temp"
 #define DATA_HUMIDITY	    "hum"
 #define DATA_PRESSURE       "atmp"
@@ -44,6 +46,10 @@
 #define DATA_CONFIG	    "cfg"
 #define DATA_VERSION	    "version"
 #define DATA_IMPACT	    "impact"
+#define DATA_IMPACT_DURATION "dur"
+#define DATA_IMPACT_ENERGY   "en"
+#define DATA_IMPACT_TYPE     "type"
+#define DATA_IMPACT_WINDOW   "wid"
 
 #define DATA_MOVEMENT   "acc"
 #define DATA_MOVEMENT_X "x"
@@ -34,6 +34,12 @@ struct cloud_data_battery {
 	uint16_t bat;
 	/** Battery data timestamp. UNIX milliseconds. */
 	int64_t bat_ts;
+	/** State of charge in percent, valid if est is set. */
+	uint8_t soc;
+	/** Remaining battery life in hours, 0 if not known. Valid if est is set. */
+	uint16_t rem_h;
+	/** Flag signifying that the entry carries a state of charge estimate. */
+	bool est : 1;
 	/** Flag signifying that the data entry is to be encoded. */
 	bool queued : 1;
 };
@@ -99,12 +105,37 @@ struct cloud_data_cfg {
 	struct cloud_data_no_data no_data;
 };
 
+/** Flags identifying the fields of @ref cloud_data_cfg, used to signal which fields of a
+ *  configuration have changed.
+ */
+enum cloud_data_cfg_field {
+	CLOUD_DATA_CFG_ACTIVE_MODE			= BIT(0),
+	CLOUD_DATA_CFG_LOCATION_TIMEOUT			= BIT(1),
+	CLOUD_DATA_CFG_ACTIVE_WAIT_TIMEOUT		= BIT(2),
+	CLOUD_DATA_CFG_MOVEMENT_RESOLUTION		= BIT(3),
+	CLOUD_DATA_CFG_MOVEMENT_TIMEOUT			= BIT(4),
+	CLOUD_DATA_CFG_ACC_ACT_THRESHOLD		= BIT(5),
+	CLOUD_DATA_CFG_ACC_INACT_THRESHOLD		= BIT(6),
+	CLOUD_DATA_CFG_ACC_INACT_TIMEOUT		= BIT(7),
+	CLOUD_DATA_CFG_NO_DATA_GNSS			= BIT(8),
+	CLOUD_DATA_CFG_NO_DATA_NEIGHBOR_CELL		= BIT(9),
+	CLOUD_DATA_CFG_ALL				= BIT_MASK(10),
+};
+
 /** Structure containing the magnitude of an impact event detected by the high-G Accelerometer. */
 struct cloud_data_impact {
 	/** Impact timestamp. UNIX milliseconds. */
 	int64_t ts;
 	/** Impact magnitude in G. */
 	double magnitude;
+	/** Impact duration in microseconds. 0 if the impact waveform was not captured. */
+	uint32_t duration_us;
+	/** Impact energy in g2 * ms. */
+	uint32_t energy;
+	/** Impact classification, 0 if unknown, 1 for a collision and 2 for a drop. */
+	uint8_t type;
+	/** ID of the stored waveform window of the impact, 0 if no window was stored. */
+	uint16_t window_id;
 	/** Flag signifying that the data entry is to be published. */
 	bool queued : 1;
 };
@@ -160,8 +191,10 @@ struct cloud_data_modem_dynamic {
 	uint32_t cell;
 	/** Reference Signal Received Power. */
 	int16_t rsrp;
-	/** Internet Protocol Address. */
-	char ip[INET6_ADDRSTRLEN];
+	/** Internet Protocol Address, an IPv4 and an IPv6 address separated by a space for
+	 *  dual stack connections.
+	 */
+	char ip[INET_ADDRSTRLEN + INET6_ADDRSTRLEN];
 	/** Access Point Name. */
 	char apn[CONFIG_CLOUD_CODEC_APN_LEN_MAX];
 	/* Mobile Country Code*/
@@ -413,6 +446,23 @@ int cloud_codec_encode_ui_data(struct cloud_codec_data *output,
 int cloud_codec_encode_impact_data(struct cloud_codec_data *output,
 				   struct cloud_data_impact *impact_buf);
 
+/**
+ * @brief Encode a batch of stored impact waveform windows.
+ *
+ * @param[out] output string buffer for encoding result
+ * @param[in] window_buf windows to encode, each a struct ext_sensor_impact_window_hdr
+ *			 followed by the encoded samples
+ * @param[in] window_buf_len length of the windows in bytes
+ *
+ * @retval 0 on success
+ * @retval -EINVAL if the data is invalid
+ * @retval -ENOMEM if codec couldn't allocate memory
+ * @retval -ENOTSUP if the function is not supported by the encoding backend
+ */
+int cloud_codec_encode_impact_windows(struct cloud_codec_data *output,
+				      const uint8_t *window_buf,
+				      size_t window_buf_len);
+
 /**
  * @brief Encode a batch of cloud buffer data.
  *
@@ -524,6 +524,34 @@ int json_common_impact_data_add(cJSON *parent,
 		goto exit;
 	}
 
+	if (data->duration_us > 0) {
+		err = json_add_number(impact_obj, DATA_IMPACT_DURATION, data->duration_us);
+		if (err) {
+			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
+			goto exit;
+		}
+
+		err = json_add_number(impact_obj, DATA_IMPACT_ENERGY, data->energy);
+		if (err) {
+			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
+			goto exit;
+		}
+
+		err = json_add_number(impact_obj, DATA_IMPACT_TYPE, data->type);
+		if (err) {
+			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
+			goto exit;
+		}
+	}
+
+	if (data->window_id > 0) {
+		err = json_add_number(impact_obj, DATA_IMPACT_WINDOW, data->window_id);
+		if (err) {
+			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
+			goto exit;
+		}
+	}
+
 	err = op_code_handle(parent, op, object_label, impact_obj, parent_ref);
 	if (err) {
 		goto exit;
@@ -887,6 +915,23 @@ int json_common_battery_data_add(cJSON *parent,
 		goto exit;
 	}
 
+	if (data->est) {
+		err = json_add_number(battery_obj, DATA_BATTERY_SOC, data->soc);
+		if (err) {
+			LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
+			goto exit;
+		}
+
+		if (data->rem_h) {
+			err = json_add_number(battery_obj, DATA_BATTERY_LIFE, data->rem_h);
+			if (err) {
+				LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__,
+					__LINE__);
+				goto exit;
+			}
+		}
+	}
+
 	err = json_add_number(battery_obj, DATA_TIMESTAMP, data->bat_ts);
 	if (err) {
 		LOG_ERR("Encoding error: %d returned at %s:%d", err, __FILE__, __LINE__);
@@ -26,6 +26,8 @@
 
 #define APP_ID_BUTTON	   "BUTTON"
 #define APP_ID_VOLTAGE	   "VOLTAGE"
+#define APP_ID_BATTERY	   "BATTERY"
+#define APP_ID_BAT_LIFE    "BAT_LIFE"
 #define APP_ID_DEVICE      "DEVICE"
 #define APP_ID_GNSS	   "GNSS"
 #define APP_ID_HUMIDITY	   "HUMID"
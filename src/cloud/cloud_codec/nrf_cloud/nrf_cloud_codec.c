@@ -756,6 +756,41 @@ static int add_batch_data(cJSON *array, enum batch_data_type type, void *buf, si
 			char voltage[5];
 			struct cloud_data_battery *data = (struct cloud_data_battery *)buf;
 
+			/* With a battery estimate, the state of charge and the remaining life are
+			 * sent instead of the voltage.
+			 */
+			if (data[i].est) {
+				char soc[4];
+				char life[6];
+
+				len = snprintk(soc, sizeof(soc), "%d", data[i].soc);
+				if ((len < 0) || (len >= sizeof(soc))) {
+					LOG_ERR("Cannot convert SoC to string, buffer too small");
+					return -ENOMEM;
+				}
+
+				err = add_data(array, NULL, APP_ID_BATTERY, soc, &data[i].bat_ts,
+					       data[i].queued, NULL, true);
+				if (err && err != -ENODATA) {
+					return err;
+				}
+
+				if (data[i].rem_h) {
+					(void)snprintk(life, sizeof(life), "%d", data[i].rem_h);
+
+					/* Timestamp has been converted by the previous entry. */
+					err = add_data(array, NULL, APP_ID_BAT_LIFE, life,
+						       &data[i].bat_ts, data[i].queued, NULL,
+						       false);
+					if (err && err != -ENODATA) {
+						return err;
+					}
+				}
+
+				data[i].queued = false;
+				break;
+			}
+
 			len = snprintk(voltage, sizeof(voltage), "%d", data[i].bat);
 			if ((len < 0) || (len >= sizeof(voltage))) {
 				LOG_ERR("Cannot convert voltage to string, buffer too small");
@@ -1104,6 +1139,14 @@ exit:
 	return err;
 }
 
+int cloud_codec_encode_impact_windows(struct cloud_codec_data *output,
+				      const uint8_t *window_buf,
+				      size_t window_buf_len)
+{
+	/* Encoding of impact waveforms is not defined for this cloud. */
+	return -ENOTSUP;
+}
+
 int cloud_codec_encode_batch_data(struct cloud_codec_data *output,
 				  struct cloud_data_gnss *gnss_buf,
 				  struct cloud_data_sensors *sensor_buf,
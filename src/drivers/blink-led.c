@@ -1,11 +1,13 @@
 #include "blink-led.h"
 
 #include <zephyr/kernel.h>
+#include <string.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/counter.h>
 
 // zephyr驱动未提供的nordic独有功能，需要使用nrfxlib实现
 #include <hal/nrf_timer.h>
+#include <hal/nrf_rtc.h>
 
 #include <debug/ppi_trace.h>
 #include <helpers/nrfx_gppi.h>
@@ -38,14 +40,387 @@ struct blink_led_config {
     const struct gpio_dt_spec *led;
 
     // timer
+    // Either a TIMER driven by the counter driver, or an RTC used directly through the HAL.
+    // The RTC runs from the LFCLK, so the HFCLK is not kept on while a pattern is playing.
     const struct device *dev_timer;
     int blink_period;
     NRF_TIMER_Type *timer_base;
+    NRF_RTC_Type *rtc_base;
 
     // ppi
     const struct device *dev_dppi;
 };
 
+// The counter driver uses compare channels 0 and 1, pattern steps use the following ones.
+#define BLINK_LED_CC_FIRST 2
+// TIMER0 to TIMER2 on nRF9160 have 6 compare channels.
+BUILD_ASSERT(BLINK_LED_CC_FIRST + BLINK_LED_PATTERN_STEPS_MAX <= 6,
+             "Not enough timer compare channels for the pattern steps");
+// RTC0 and RTC1 on nRF9160 have 4 compare channels, all of them are used for pattern steps.
+BUILD_ASSERT(BLINK_LED_PATTERN_STEPS_MAX <= 4,
+             "Not enough RTC compare channels for the pattern steps");
+
+// Runtime state of a blink-leds device
+struct blink_led_data {
+    const struct device *dev;
+
+    // (D)PPI channels that turn the LEDs of the pattern on and off
+    uint8_t ppi_channel_on;
+    uint8_t ppi_channel_off;
+    // RTC only: the RTC has no shorts, the last step publishes to this channel, which clears
+    // the RTC and toggles the LEDs if the first step has a different state than the last one.
+    uint8_t ppi_channel_wrap;
+
+    // Copy of the pattern being played
+    struct blink_led_step steps[BLINK_LED_PATTERN_STEPS_MAX];
+    struct blink_led_pattern pattern;
+    bool playing;
+    // Pattern was stopped by PM suspend and is restarted on resume
+    bool suspended;
+
+    // LEDs started with the fixed blink period through start() and start_all()
+    uint32_t started_mask;
+
+    // Stops a pattern with a finite repeat count, the only CPU wakeup during playback
+    struct k_timer repeat_timer;
+    struct k_spinlock lock;
+};
+
+static uint32_t step_event_address_get(const struct blink_led_config *config, size_t step)
+{
+    if (config->rtc_base) {
+        return nrf_rtc_event_address_get(config->rtc_base, nrf_rtc_compare_event_get(step));
+    }
+
+    return nrf_timer_event_address_get(config->timer_base,
+                                       nrf_timer_compare_event_get(BLINK_LED_CC_FIRST + step));
+}
+
+static uint32_t step_ticks_get(const struct blink_led_config *config, uint64_t us)
+{
+    if (config->rtc_base) {
+        // Prescaler 0, 32768 Hz
+        return (uint32_t)((us * 32768 + USEC_PER_SEC / 2) / USEC_PER_SEC);
+    }
+
+    return counter_us_to_ticks(config->dev_timer, us);
+}
+
+// Stop the timer, detach the LEDs from the (D)PPI channels and turn them off.
+// Called with the lock held.
+static void pattern_halt(const struct device *dev)
+{
+    const struct blink_led_config *config = (struct blink_led_config*)(dev->config);
+    struct blink_led_data *data = (struct blink_led_data *)(dev->data);
+
+    if (!data->playing) {
+        return;
+    }
+
+    if (config->rtc_base) {
+        nrf_rtc_task_trigger(config->rtc_base, NRF_RTC_TASK_STOP);
+        nrfx_gppi_task_endpoint_clear(data->ppi_channel_wrap,
+            nrf_rtc_task_address_get(config->rtc_base, NRF_RTC_TASK_CLEAR));
+    } else {
+        counter_stop(config->dev_timer);
+    }
+
+    for (size_t i = 0; i < data->pattern.step_count; i++) {
+        nrfx_gppi_event_endpoint_clear(data->ppi_channel_on, step_event_address_get(config, i));
+
+        if (config->rtc_base) {
+            nrf_rtc_event_disable(config->rtc_base, RTC_EVTEN_COMPARE0_Msk << i);
+        } else {
+            nrf_timer_shorts_disable(config->timer_base,
+                nrf_timer_short_compare_clear_get(BLINK_LED_CC_FIRST + i));
+        }
+    }
+
+    for (size_t i = 0; i < config->num_leds; i++) {
+        uint32_t pin = config->led[i].pin;
+
+        if (!(data->pattern.led_mask & BIT(i))) {
+            continue;
+        }
+
+#if defined(DPPI_PRESENT)
+        nrfx_gppi_task_endpoint_clear(data->ppi_channel_on, nrfx_gpiote_set_task_addr_get(pin));
+        nrfx_gppi_task_endpoint_clear(data->ppi_channel_off, nrfx_gpiote_clr_task_addr_get(pin));
+        if (config->rtc_base) {
+            nrfx_gppi_task_endpoint_clear(data->ppi_channel_wrap,
+                                          nrfx_gpiote_out_task_addr_get(pin));
+        }
+#else
+        nrfx_gppi_task_endpoint_clear(data->ppi_channel_on, nrfx_gpiote_out_task_addr_get(pin));
+#endif
+        nrfx_gpiote_clr_task_trigger(pin);
+    }
+
+#if !defined(DPPI_PRESENT)
+    if (config->rtc_base) {
+        nrfx_gppi_event_endpoint_clear(data->ppi_channel_wrap, step_event_address_get(config, 0));
+    }
+#endif
+
+    data->playing = false;
+}
+
+// Start the timer from zero. Called with the lock held.
+static void timer_restart(const struct blink_led_config *config)
+{
+    if (config->rtc_base) {
+        nrf_rtc_task_trigger(config->rtc_base, NRF_RTC_TASK_CLEAR);
+        nrf_rtc_task_trigger(config->rtc_base, NRF_RTC_TASK_START);
+    } else {
+        nrf_timer_task_trigger(config->timer_base, NRF_TIMER_TASK_CLEAR);
+        counter_start(config->dev_timer);
+    }
+}
+
+#if defined(DPPI_PRESENT)
+
+// Program the compare channels and (D)PPI endpoints for the pattern in data->pattern and
+// start the timer. Called with the lock held.
+static void pattern_start(const struct device *dev)
+{
+    const struct blink_led_config *config = (struct blink_led_config*)(dev->config);
+    struct blink_led_data *data = (struct blink_led_data *)(dev->data);
+    const struct blink_led_pattern *pattern = &data->pattern;
+    const size_t last = pattern->step_count - 1;
+    // With the RTC, the LEDs are toggled on wrap-around when the first and last states differ
+    const bool wrap_toggle = (pattern->steps[0].on != pattern->steps[last].on);
+    uint64_t end_us = 0;
+
+    if (config->rtc_base) {
+        nrf_rtc_task_trigger(config->rtc_base, NRF_RTC_TASK_STOP);
+        nrf_rtc_prescaler_set(config->rtc_base, 0);
+    }
+
+    // Compare channel k ends step k and applies the state of the next step. The last one
+    // restarts the pattern from the first step.
+    for (size_t i = 0; i <= last; i++) {
+        const struct blink_led_step *next = &pattern->steps[(i + 1) % pattern->step_count];
+        uint32_t ticks;
+        uint8_t channel;
+
+        end_us += (uint64_t)pattern->steps[i].duration_ms * USEC_PER_MSEC;
+        ticks = step_ticks_get(config, end_us);
+
+        if (config->rtc_base) {
+            nrf_rtc_cc_set(config->rtc_base, i, ticks);
+            nrf_rtc_event_clear(config->rtc_base, nrf_rtc_compare_event_get(i));
+            nrf_rtc_event_enable(config->rtc_base, RTC_EVTEN_COMPARE0_Msk << i);
+        } else {
+            nrf_timer_cc_set(config->timer_base,
+                             (nrf_timer_cc_channel_t)(BLINK_LED_CC_FIRST + i), ticks);
+        }
+
+        if (config->rtc_base && (i == last)) {
+            channel = data->ppi_channel_wrap;
+        } else {
+            channel = next->on ? data->ppi_channel_on : data->ppi_channel_off;
+        }
+
+        nrfx_gppi_event_endpoint_setup(channel, step_event_address_get(config, i));
+    }
+
+    if (config->rtc_base) {
+        nrfx_gppi_task_endpoint_setup(data->ppi_channel_wrap,
+            nrf_rtc_task_address_get(config->rtc_base, NRF_RTC_TASK_CLEAR));
+    } else {
+        nrf_timer_shorts_enable(config->timer_base,
+            nrf_timer_short_compare_clear_get(BLINK_LED_CC_FIRST + last));
+    }
+
+    for (size_t i = 0; i < config->num_leds; i++) {
+        uint32_t pin = config->led[i].pin;
+
+        if (!(pattern->led_mask & BIT(i))) {
+            continue;
+        }
+
+        nrfx_gppi_task_endpoint_setup(data->ppi_channel_on, nrfx_gpiote_set_task_addr_get(pin));
+        nrfx_gppi_task_endpoint_setup(data->ppi_channel_off, nrfx_gpiote_clr_task_addr_get(pin));
+        if (config->rtc_base && wrap_toggle) {
+            nrfx_gppi_task_endpoint_setup(data->ppi_channel_wrap,
+                                          nrfx_gpiote_out_task_addr_get(pin));
+        }
+
+        if (pattern->steps[0].on) {
+            nrfx_gpiote_set_task_trigger(pin);
+        } else {
+            nrfx_gpiote_clr_task_trigger(pin);
+        }
+    }
+
+    timer_restart(config);
+    data->playing = true;
+
+    if (pattern->repeat != BLINK_LED_REPEAT_FOREVER) {
+        k_timer_start(&data->repeat_timer,
+                      K_USEC(end_us * pattern->repeat), K_NO_WAIT);
+    }
+}
+#else
+// A PPI channel has a single event endpoint, so steps cannot share the on and off channels.
+// Patterns of two steps of equal length, one on and one off, are played as in toggle mode:
+// the first compare toggles the LEDs and clears the timer.
+static bool pattern_is_toggle(const struct blink_led_pattern *pattern)
+{
+    return (pattern->step_count == 2) && (pattern->steps[0].on != pattern->steps[1].on) &&
+           (pattern->steps[0].duration_ms == pattern->steps[1].duration_ms);
+}
+
+// Program the first compare channel and the PPI endpoints for the toggle pattern in
+// data->pattern and start the timer. Called with the lock held.
+static void pattern_start(const struct device *dev)
+{
+    const struct blink_led_config *config = (struct blink_led_config*)(dev->config);
+    struct blink_led_data *data = (struct blink_led_data *)(dev->data);
+    const struct blink_led_pattern *pattern = &data->pattern;
+    uint64_t half_us = (uint64_t)pattern->steps[0].duration_ms * USEC_PER_MSEC;
+    uint32_t ticks = step_ticks_get(config, half_us);
+
+    if (config->rtc_base) {
+        nrf_rtc_task_trigger(config->rtc_base, NRF_RTC_TASK_STOP);
+        nrf_rtc_prescaler_set(config->rtc_base, 0);
+        nrf_rtc_cc_set(config->rtc_base, 0, ticks);
+        nrf_rtc_event_clear(config->rtc_base, nrf_rtc_compare_event_get(0));
+        nrf_rtc_event_enable(config->rtc_base, RTC_EVTEN_COMPARE0_Msk);
+
+        // The RTC has no shorts, it is cleared by a second channel on the same event
+        nrfx_gppi_event_endpoint_setup(data->ppi_channel_wrap, step_event_address_get(config, 0));
+        nrfx_gppi_task_endpoint_setup(data->ppi_channel_wrap,
+            nrf_rtc_task_address_get(config->rtc_base, NRF_RTC_TASK_CLEAR));
+    } else {
+        nrf_timer_cc_set(config->timer_base, (nrf_timer_cc_channel_t)BLINK_LED_CC_FIRST, ticks);
+        nrf_timer_shorts_enable(config->timer_base,
+            nrf_timer_short_compare_clear_get(BLINK_LED_CC_FIRST));
+    }
+
+    nrfx_gppi_event_endpoint_setup(data->ppi_channel_on, step_event_address_get(config, 0));
+
+    for (size_t i = 0; i < config->num_leds; i++) {
+        uint32_t pin = config->led[i].pin;
+
+        if (!(pattern->led_mask & BIT(i))) {
+            continue;
+        }
+
+        nrfx_gppi_task_endpoint_setup(data->ppi_channel_on, nrfx_gpiote_out_task_addr_get(pin));
+
+        if (pattern->steps[0].on) {
+            nrfx_gpiote_set_task_trigger(pin);
+        } else {
+            nrfx_gpiote_clr_task_trigger(pin);
+        }
+    }
+
+    timer_restart(config);
+    data->playing = true;
+
+    if (pattern->repeat != BLINK_LED_REPEAT_FOREVER) {
+        k_timer_start(&data->repeat_timer,
+                      K_USEC(2 * half_us * pattern->repeat), K_NO_WAIT);
+    }
+}
+#endif // DPPI_PRESENT
+
+static void repeat_timer_handler(struct k_timer *timer)
+{
+    struct blink_led_data *data = CONTAINER_OF(timer, struct blink_led_data, repeat_timer);
+    k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+    pattern_halt(data->dev);
+    k_spin_unlock(&data->lock, key);
+}
+
+// Replace the current pattern. Called with the lock held.
+static void pattern_play(const struct device *dev, const struct blink_led_pattern *pattern)
+{
+    struct blink_led_data *data = (struct blink_led_data *)(dev->data);
+
+    pattern_halt(dev);
+
+    memcpy(data->steps, pattern->steps, pattern->step_count * sizeof(pattern->steps[0]));
+    data->pattern = *pattern;
+    data->pattern.steps = data->steps;
+    data->suspended = false;
+
+    pattern_start(dev);
+}
+
+static int blink_play(const struct device *dev, const struct blink_led_pattern *pattern)
+{
+    const struct blink_led_config *config = (struct blink_led_config*)(dev->config);
+    struct blink_led_data *data = (struct blink_led_data *)(dev->data);
+    k_spinlock_key_t key;
+
+    if ((pattern == NULL) || (pattern->steps == NULL) || (pattern->step_count == 0) ||
+        (pattern->step_count > BLINK_LED_PATTERN_STEPS_MAX) || (pattern->led_mask == 0) ||
+        (pattern->led_mask & ~BIT_MASK(config->num_leds))) {
+        return -EINVAL;
+    }
+
+    for (size_t i = 0; i < pattern->step_count; i++) {
+        if (pattern->steps[i].duration_ms == 0) {
+            return -EINVAL;
+        }
+    }
+
+#if !defined(DPPI_PRESENT)
+    if (!pattern_is_toggle(pattern)) {
+        return -ENOTSUP;
+    }
+#endif
+
+    k_timer_stop(&data->repeat_timer);
+
+    key = k_spin_lock(&data->lock);
+    pattern_play(dev, pattern);
+    k_spin_unlock(&data->lock, key);
+
+    return 0;
+}
+
+// Update the LEDs started with start() or start_all(), and play the fixed blink period from
+// devicetree on them.
+static int blink_started_update(const struct device *dev, uint32_t set, uint32_t clear)
+{
+    const struct blink_led_config *config = (struct blink_led_config*)(dev->config);
+    struct blink_led_data *data = (struct blink_led_data *)(dev->data);
+    // 用toggle模式，周期变一半
+    const struct blink_led_step steps[] = {
+        { .on = true, .duration_ms = config->blink_period / 2 },
+        { .on = false, .duration_ms = config->blink_period / 2 },
+    };
+    struct blink_led_pattern pattern = {
+        .steps = steps,
+        .step_count = ARRAY_SIZE(steps),
+        .repeat = BLINK_LED_REPEAT_FOREVER,
+    };
+    k_spinlock_key_t key;
+
+    if (steps[0].duration_ms == 0) {
+        return -EINVAL;
+    }
+
+    k_timer_stop(&data->repeat_timer);
+
+    key = k_spin_lock(&data->lock);
+    data->started_mask = (data->started_mask | set) & ~clear;
+    pattern.led_mask = data->started_mask;
+
+    if (pattern.led_mask == 0) {
+        pattern_halt(dev);
+        data->suspended = false;
+    } else {
+        pattern_play(dev, &pattern);
+    }
+    k_spin_unlock(&data->lock, key);
+
+    return 0;
+}
 
 /**
  * @brief 初始化函数 
@@ -53,6 +428,7 @@ struct blink_led_config {
 static int blink_led_init(const struct device *dev)
 {
     const struct blink_led_config *config = (struct blink_led_config*)(dev->config);
+    struct blink_led_data *data = (struct blink_led_data *)(dev->data);
     int err = 0;
 
     // 配置GPIO
@@ -105,115 +481,109 @@ static int blink_led_init(const struct device *dev)
 	}
 
     // 配置timer
-    const struct device *timer_dev = config->dev_timer;
-    NRF_TIMER_Type *timer_base = (NRF_TIMER_Type *)config->timer_base;
-    if(device_is_ready(timer_dev)){
-
-        // 由于prj.conf中启用了Timer0，所以timer0已经被counter驱动初始化完成
-        // 直接使用counter驱动即可
-        struct counter_alarm_cfg alarm_cfg = {
-            .flags = 0,
-            .ticks = counter_us_to_ticks(timer_dev, 1000 * config->blink_period / 2), // 用toggle模式，周期变一半
-            .callback = NULL,
-            .user_data = &alarm_cfg
-        };
-        err = counter_set_channel_alarm(timer_dev, 0, &alarm_cfg); // 此处channel id为0，底层驱动转为Compare时ID+2
-        
-        // zephyr counter驱动不包含nordic nrf short寄存器设置，
-        // 故此处需要使用nrfx API来打补丁，启用short寄存器
-        // 连接channel 0 compare event 和 定时器 clear task
-        // Note
-        uint32_t short_bit_mask = nrf_timer_short_compare_clear_get(2);
-        nrf_timer_shorts_enable(timer_base, short_bit_mask); // CC为2
-
-    } else {
-        LOG_ERR("%s: Timer[%s] device not ready", dev->name, timer_dev->name);
-		err = -ENODEV;
+    // The timer is already initialized by the counter driver, as Timer0 is enabled in prj.conf.
+    // Compare values and shorts are set by the HAL when a pattern is played.
+    // An RTC is used through the HAL only and is not bound to a driver.
+    if (!config->rtc_base && !device_is_ready(config->dev_timer)) {
+        LOG_ERR("%s: Timer[%s] device not ready", dev->name, config->dev_timer->name);
+        return -ENODEV;
     }
 
     // 配置PPI
     // Zephyr没有ppi驱动，故只能使用nrfx驱动
-    uint8_t ppi_channel;
-    err = nrfx_gppi_channel_alloc(&ppi_channel);
-	if (err != NRFX_SUCCESS) {
-		LOG_ERR("nrfx_gppi_channel_alloc error: 0x%08X", err);
-		return err;
-	}
-    // 配置PPI event端点
-    nrfx_gppi_event_endpoint_setup(ppi_channel,
-        nrf_timer_event_address_get(timer_base,NRF_TIMER_EVENT_COMPARE2)); // channl0是Compare2
-    // 配置PPI task端点
-    // 9160是分布式PPI，可分配多个端点
-    for (size_t i = 0; i < config->num_leds; i++) {
-        nrfx_gppi_task_endpoint_setup(ppi_channel,
-            nrfx_gpiote_out_task_addr_get(config->led[i].pin));
+    // One channel turns the LEDs on and one turns them off. Every step boundary publishes its
+    // timer compare event to one of them, which is only possible with DPPI. Without DPPI, the
+    // "on" channel toggles the LEDs and the "off" channel is unused.
+    err = nrfx_gppi_channel_alloc(&data->ppi_channel_on);
+    if (err != NRFX_SUCCESS) {
+        LOG_ERR("nrfx_gppi_channel_alloc error: 0x%08X", err);
+        return -EBUSY;
+    }
+
+    err = nrfx_gppi_channel_alloc(&data->ppi_channel_off);
+    if (err != NRFX_SUCCESS) {
+        LOG_ERR("nrfx_gppi_channel_alloc error: 0x%08X", err);
+        return -EBUSY;
     }
-    nrfx_gppi_channels_enable(BIT(ppi_channel));
 
-	return err;
+    nrfx_gppi_channels_enable(BIT(data->ppi_channel_on) | BIT(data->ppi_channel_off));
+
+    if (config->rtc_base) {
+        err = nrfx_gppi_channel_alloc(&data->ppi_channel_wrap);
+        if (err != NRFX_SUCCESS) {
+            LOG_ERR("nrfx_gppi_channel_alloc error: 0x%08X", err);
+            return -EBUSY;
+        }
+
+        nrfx_gppi_channels_enable(BIT(data->ppi_channel_wrap));
+    }
+
+    data->dev = dev;
+    k_timer_init(&data->repeat_timer, repeat_timer_handler, NULL);
+
+	return 0;
 }
 
 static int blink_start_all(const struct device *dev)
 {
     const struct blink_led_config *config = (struct blink_led_config*)(dev->config);
-    const struct device *timer_dev = config->dev_timer;
 
-    for (size_t i = 0; i < config->num_leds; i++) {
-		const struct gpio_dt_spec *led = &config->led[i];
-        nrfx_gpiote_out_task_enable(led->pin);
-    }
-    counter_start(timer_dev);
-    return 0;
+    return blink_started_update(dev, BIT_MASK(config->num_leds), 0);
 }
 
 static int blink_stop_all(const struct device *dev)
 {
     const struct blink_led_config *config = (struct blink_led_config*)(dev->config);
-    const struct device *timer_dev = config->dev_timer;
 
-    counter_stop(timer_dev);
-    
-    for (size_t i = 0; i < config->num_leds; i++) {
-		const struct gpio_dt_spec *led = &config->led[i];
-        nrfx_gpiote_out_task_disable(led->pin);
-        nrfx_gpiote_clr_task_trigger(led->pin);
-    }
-    return 0;
+    return blink_started_update(dev, 0, BIT_MASK(config->num_leds));
 }
 
 static int blink_start(const struct device *dev, uint32_t idx)
 {
     const struct blink_led_config *config = (struct blink_led_config*)(dev->config);
-    const struct device *timer_dev = config->dev_timer;
-    const struct gpio_dt_spec *led = &config->led[idx];
-    nrfx_gpiote_out_task_enable(led->pin);
-    counter_start(timer_dev);
-    return 0;
+
+    if (idx >= config->num_leds) {
+        return -EINVAL;
+    }
+
+    return blink_started_update(dev, BIT(idx), 0);
 }
 
 static int blink_stop(const struct device *dev, uint32_t idx)
 {
     const struct blink_led_config *config = (struct blink_led_config*)(dev->config);
-    const struct device *timer_dev = config->dev_timer;
-    const struct gpio_dt_spec *led = &config->led[idx];
-    counter_stop(timer_dev);
-    nrfx_gpiote_out_task_disable(led->pin);
-    nrfx_gpiote_clr_task_trigger(led->pin);
-    return 0;
+
+    if (idx >= config->num_leds) {
+        return -EINVAL;
+    }
+
+    return blink_started_update(dev, 0, BIT(idx));
 }
 
 // power saving when CPU idle
 #ifdef CONFIG_PM_DEVICE
 static int jayant_blink_led_pm_action(const struct device *dev, enum pm_device_action action)
 {
+    struct blink_led_data *data = (struct blink_led_data *)(dev->data);
+    k_spinlock_key_t key;
     int ret = 0;
     switch (action) {
     case PM_DEVICE_ACTION_RESUME:
-        ret = blink_start_all(dev);
+        // Restart the pattern that was playing when the device was suspended
+        key = k_spin_lock(&data->lock);
+        if (data->suspended) {
+            data->suspended = false;
+            pattern_start(dev);
+        }
+        k_spin_unlock(&data->lock, key);
         LOG_INF("blink resume");
         break;
     case PM_DEVICE_ACTION_SUSPEND:
-        ret = blink_stop_all(dev);
+        k_timer_stop(&data->repeat_timer);
+        key = k_spin_lock(&data->lock);
+        data->suspended = data->playing;
+        pattern_halt(dev);
+        k_spin_unlock(&data->lock, key);
         LOG_INF("blink suspend");
         break;
     default:
@@ -231,6 +601,7 @@ static const struct blink_led_api blink_api= {
     .stop_all = blink_stop_all,
     .start = blink_start,
     .stop = blink_stop,
+    .play = blink_play,
 };                                                                                      
 
 // 代码模板，用于批量定义device结构体并赋值config
@@ -244,8 +615,14 @@ static const struct blink_led_api blink_api= {
 // 一个反例是，ppi虽然在dts中有定义，但它不是zephyr标准设备
 // 所以zephyr/driver中并不存在给ppi创建device结构体实例的代码
 // 所以此处无论如何都无法用 DEVICE_DT_GET() 来获取到ppi的 device 结构体
+#define BLINK_LED_TIMER_NODE(i) DT_PHANDLE_BY_IDX(DT_DRV_INST(i), timer, 0)
+#define BLINK_LED_TIMER_IS_RTC(i) DT_NODE_HAS_COMPAT(BLINK_LED_TIMER_NODE(i), nordic_nrf_rtc)
+
 #define BLINK_LED_DEVICE(i)                                                     \
                                                                                 \
+BUILD_ASSERT(!DT_SAME_NODE(BLINK_LED_TIMER_NODE(i), DT_NODELABEL(rtc1)),        \
+             "RTC1 is used by the system timer");                               \
+                                                                                \
 static const struct gpio_dt_spec gpios_dt_spec_##i[] = {		                \
     DT_INST_FOREACH_CHILD_SEP_VARGS(i, GPIO_DT_SPEC_GET, (,), my_gpios) \
 };                                                                              \
@@ -254,14 +631,19 @@ static const struct blink_led_config blink_led_config_##i = {
     .num_leds	= ARRAY_SIZE(gpios_dt_spec_##i),                               \
     .led = gpios_dt_spec_##i,                                                  \
     .blink_period = DT_PROP(DT_DRV_INST(i), blink_period),                      \
-    .dev_timer = DEVICE_DT_GET(DT_PHANDLE_BY_IDX(DT_DRV_INST(i), timer, 0)),    \
-    .timer_base = (NRF_TIMER_Type *)                                            \
-                DT_REG_ADDR(DT_PHANDLE_BY_IDX(DT_DRV_INST(i), timer,0)),        \
+    .dev_timer = COND_CODE_1(BLINK_LED_TIMER_IS_RTC(i), (NULL),                 \
+                (DEVICE_DT_GET(BLINK_LED_TIMER_NODE(i)))),                      \
+    .timer_base = COND_CODE_1(BLINK_LED_TIMER_IS_RTC(i), (NULL),                \
+                ((NRF_TIMER_Type *)DT_REG_ADDR(BLINK_LED_TIMER_NODE(i)))),      \
+    .rtc_base = COND_CODE_1(BLINK_LED_TIMER_IS_RTC(i),                          \
+                ((NRF_RTC_Type *)DT_REG_ADDR(BLINK_LED_TIMER_NODE(i))), (NULL)),\
 };                                                                              \
                                                                                 \
+static struct blink_led_data blink_led_data_##i;                                \
+                                                                                \
 PM_DEVICE_DT_INST_DEFINE(i,jayant_blink_led_pm_action);		                    \
 DEVICE_DT_INST_DEFINE(i, &blink_led_init, PM_DEVICE_DT_INST_GET(i),		        \
-		      NULL, &blink_led_config_##i,		                                \
+		      &blink_led_data_##i, &blink_led_config_##i,		                \
 		      POST_KERNEL, CONFIG_JAYANT_BLINK_LED_PRIORITY,	                \
 		      &blink_api);                               
                             
@@ -3,13 +3,43 @@
 
 #include <zephyr/device.h>
 
+#include <stdbool.h>
 #include <stdint.h>
 
+/* Maximum number of steps in a pattern, one timer compare channel is used per step. */
+#define BLINK_LED_PATTERN_STEPS_MAX 4
+
+/* Repeat a pattern until it is stopped or replaced. */
+#define BLINK_LED_REPEAT_FOREVER 0
+
+struct blink_led_step {
+    /* LED state during the step. */
+    bool on;
+    /* Duration of the step in milliseconds. */
+    uint16_t duration_ms;
+};
+
+/* LED pattern played by the timer and (D)PPI, without CPU involvement between steps.
+ * All LEDs in led_mask are driven in sync.
+ */
+struct blink_led_pattern {
+    const struct blink_led_step *steps;
+    /* Number of steps, at most BLINK_LED_PATTERN_STEPS_MAX. */
+    uint8_t step_count;
+    /* Number of times the pattern is played, or BLINK_LED_REPEAT_FOREVER. The LEDs are
+     * turned off when the last repetition has ended.
+     */
+    uint16_t repeat;
+    /* Bitmask of LED indexes, in devicetree child node order. */
+    uint32_t led_mask;
+};
+
 __subsystem struct blink_led_api {
 	int (*start)(const struct device*, uint32_t idx);
     int (*stop)(const struct device*, uint32_t idx);
     int (*start_all)(const struct device*);
     int (*stop_all)(const struct device*);
+    int (*play)(const struct device*, const struct blink_led_pattern *pattern);
 };
 
 #endif // !_BLINK_LEDS
@@ -4,6 +4,7 @@
 #include <zephyr/drivers/adc.h>
 
 #include <zephyr/sys/util.h>
+#include <zephyr/sys/atomic.h>
 
 // 判断电压表device tree node是否存在
 #if !DT_NODE_EXISTS(DT_PATH(my_voltage_sensor))|| \
@@ -21,6 +22,116 @@ LOG_MODULE_REGISTER(voltage_sensor,CONFIG_JAYANT_VOLTAGE_SENSOR_LOG_LEVEL);
 static const struct adc_dt_spec adc_channel_vdd = \
                 ADC_DT_SPEC_GET_BY_IDX(DT_PATH(my_voltage_sensor), 0);
 
+// One reading is a sequence of CONFIG_JAYANT_VOLTAGE_SENSOR_SAMPLES samplings, written by the
+// SAADC EasyDMA one after another. Each sampling is averaged in hardware over
+// 2^CONFIG_JAYANT_VOLTAGE_SENSOR_OVERSAMPLING conversions (burst mode).
+static int16_t samples[CONFIG_JAYANT_VOLTAGE_SENSOR_SAMPLES];
+
+static const struct adc_sequence_options sequence_options = {
+    .interval_us = CONFIG_JAYANT_VOLTAGE_SENSOR_SAMPLE_INTERVAL_US,
+    .extra_samplings = CONFIG_JAYANT_VOLTAGE_SENSOR_SAMPLES - 1,
+};
+
+// Asynchronous reading: the ADC raises the poll signal when the sequence is done, and the
+// triggered work item processes the samples on the system workqueue.
+static struct k_poll_signal async_signal;
+static struct k_poll_event async_event;
+static struct k_work_poll async_work;
+static voltage_sensor_callback_t async_callback;
+static void *async_user_data;
+static atomic_t busy;
+
+// Exponential moving average of the median voltage, in mV << CONFIG_JAYANT_VOLTAGE_SENSOR_EMA_SHIFT
+static int32_t ema_acc;
+static bool ema_valid;
+static struct k_spinlock ema_lock;
+
+static void sequence_init(struct adc_sequence *sequence)
+{
+    *sequence = (struct adc_sequence) {
+        .options = &sequence_options,
+        .buffer = samples,
+        .buffer_size = sizeof(samples), // buf单元的大小
+    };
+    (void)adc_sequence_init_dt(&adc_channel_vdd, sequence);
+    sequence->oversampling = CONFIG_JAYANT_VOLTAGE_SENSOR_OVERSAMPLING;
+}
+
+/**
+ * @brief median of the samples in millivolts, filtered with the moving average
+ */
+static int32_t samples_process(void)
+{
+    int16_t sorted[ARRAY_SIZE(samples)];
+    k_spinlock_key_t key;
+    int32_t volt_mv;
+    int err;
+
+    // Insertion sort, the sequence is short
+    for (size_t i = 0; i < ARRAY_SIZE(samples); i++) {
+        size_t j = i;
+
+        while ((j > 0) && (sorted[j - 1] > samples[i])) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = samples[i];
+    }
+
+    // 自动根据device tree中配置的基准电压进行转换
+    volt_mv = sorted[ARRAY_SIZE(sorted) / 2];
+    err = adc_raw_to_millivolts_dt(&adc_channel_vdd, &volt_mv);
+    if (err < 0) {
+        LOG_ERR("ADC raw value in mV is not available");
+        return -1;
+    }
+
+    key = k_spin_lock(&ema_lock);
+
+    if (!ema_valid) {
+        ema_acc = volt_mv << CONFIG_JAYANT_VOLTAGE_SENSOR_EMA_SHIFT;
+        ema_valid = true;
+    } else {
+        ema_acc += volt_mv - (ema_acc >> CONFIG_JAYANT_VOLTAGE_SENSOR_EMA_SHIFT);
+    }
+
+    LOG_DBG("Median %d mV, filtered %d mV", volt_mv,
+            ema_acc >> CONFIG_JAYANT_VOLTAGE_SENSOR_EMA_SHIFT);
+    volt_mv = ema_acc >> CONFIG_JAYANT_VOLTAGE_SENSOR_EMA_SHIFT;
+
+    k_spin_unlock(&ema_lock, key);
+
+    return volt_mv;
+}
+
+static void async_work_fn(struct k_work *work)
+{
+    voltage_sensor_callback_t callback = async_callback;
+    void *user_data = async_user_data;
+    unsigned int signaled;
+    int32_t volt_mv;
+    int result;
+
+    k_poll_signal_check(&async_signal, &signaled, &result);
+    k_poll_signal_reset(&async_signal);
+
+    if (!signaled || (result < 0)) {
+        LOG_ERR("Could not read ADC Channel, reason: (%d)", result);
+        volt_mv = -EIO;
+    } else {
+        volt_mv = samples_process();
+        if (volt_mv < 0) {
+            volt_mv = -EIO;
+        }
+    }
+
+    atomic_clear(&busy);
+
+    if (callback) {
+        callback(volt_mv, user_data);
+    }
+}
+
 /**
  * @brief init voltage sensor
  */
@@ -38,48 +149,87 @@ static inline int voltage_sensor_setup()
         return -1;
     }
 
+    k_poll_signal_init(&async_signal);
+    k_poll_event_init(&async_event, K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, &async_signal);
+    k_work_poll_init(&async_work, async_work_fn);
+
     LOG_INF("Init success.");
     return 0;
 }
 
 /**
- * @brief start ADC sampling
+ * @brief start ADC sampling and wait for the result
  */
 static inline int32_t voltage_sensor_sampling()
 {   
-    int16_t buf;
+    struct adc_sequence sequence;
+
+    if (atomic_set(&busy, 1)) {
+        LOG_WRN("Sampling already ongoing");
+        return -1;
+    }
 
     LOG_INF("Start sampling.");
 
     // 配置一次采样序列
-	struct adc_sequence sequence = {
-		.buffer = &buf,
-		.buffer_size = sizeof(buf), // buf单元的大小
-	};
-    (void)adc_sequence_init_dt(&adc_channel_vdd, &sequence);
+    sequence_init(&sequence);
 
     // 执行采样序列
     int err = adc_read(adc_channel_vdd.dev, &sequence);
     if (err < 0) {
         LOG_ERR("Could not read ADC Channel, reason: (%d)\n", err);
+        atomic_clear(&busy);
         return -1;
     } 
 
-    // 自动根据device tree中配置的基准电压进行转换
-    int32_t volt_mv = buf;
-    err = adc_raw_to_millivolts_dt(&adc_channel_vdd, &volt_mv);
-    if (err < 0) {
-        LOG_ERR("ADC raw value in mV is not available");
-        return -1;
-    }
+    int32_t volt_mv = samples_process();
+
+    atomic_clear(&busy);
 
     LOG_INF("Sampling Finished.");
 
     return volt_mv;
 }
 
+/**
+ * @brief start ADC sampling, the callback is called from the system workqueue
+ */
+static int voltage_sensor_sampling_async(voltage_sensor_callback_t callback, void *user_data)
+{
+    struct adc_sequence sequence;
+    int err;
+
+    if (atomic_set(&busy, 1)) {
+        return -EBUSY;
+    }
+
+    async_callback = callback;
+    async_user_data = user_data;
+    k_poll_signal_reset(&async_signal);
+
+    err = k_work_poll_submit(&async_work, &async_event, 1, K_FOREVER);
+    if (err) {
+        LOG_ERR("k_work_poll_submit, error: %d", err);
+        atomic_clear(&busy);
+        return err;
+    }
+
+    sequence_init(&sequence);
+
+    err = adc_read_async(adc_channel_vdd.dev, &sequence, &async_signal);
+    if (err < 0) {
+        LOG_ERR("Could not start ADC sampling, reason: (%d)", err);
+        (void)k_work_poll_cancel(&async_work);
+        atomic_clear(&busy);
+        return err;
+    }
+
+    return 0;
+}
+
 static const struct voltage_sensor_api voltage_sensor_api = {
     .voltage_get = voltage_sensor_sampling,
+    .voltage_get_async = voltage_sensor_sampling_async,
 };
 
 DEVICE_DT_DEFINE(DT_PATH(my_voltage_sensor),         \
@@ -6,8 +6,16 @@
 
 #include <stdint.h>
 
+/* Called from the system workqueue when an asynchronous reading has completed.
+ * volt_mv is the filtered voltage in millivolts, or a negative error code.
+ */
+typedef void (*voltage_sensor_callback_t)(int32_t volt_mv, void *user_data);
+
 __subsystem struct voltage_sensor_api {
+    /* Blocking reading, returns the filtered voltage in millivolts or -1 on error. */
     int32_t (*voltage_get)(void);
+    /* Start a reading and return immediately. Returns -EBUSY if a reading is ongoing. */
+    int (*voltage_get_async)(voltage_sensor_callback_t callback, void *user_data);
 };
 
 
@@ -90,6 +90,13 @@ enum app_module_data_type {
 struct app_module_bat_data {
     uint16_t vdd_mv;
     int64_t timestamp;
+    /** State of charge in percent, valid if has_estimate is set. */
+    uint8_t soc;
+    /** Remaining battery life in hours, 0 if not known yet. */
+    uint16_t remaining_h;
+    bool has_estimate;
+    /** Set if the reading has changed enough to be published. */
+    bool publish;
 };
 
 //自定义云端命令消息
@@ -97,6 +104,8 @@ struct app_module_custom_cloud_cmd_data {
     uint8_t *buf;
     size_t len;
     bool is_allocated;
+    /** Function used to release allocated data. heap_tracker_free() is used if NULL. */
+    void (*release)(uint8_t *ptr);
 };
 
 /** @brief Application module event. */
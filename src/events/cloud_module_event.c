@@ -44,6 +44,8 @@ static char *get_evt_type_str(enum cloud_module_event_type type)
 		return "CLOUD_EVT_FOTA_DONE";
 	case CLOUD_EVT_FOTA_ERROR:
 		return "CLOUD_EVT_FOTA_ERROR";
+	case CLOUD_EVT_AGPS_DATA_PROCESSED:
+		return "CLOUD_EVT_AGPS_DATA_PROCESSED";
 	case CLOUD_EVT_ERROR:
 		return "CLOUD_EVT_ERROR";
     case CLOUD_EVT_CUSTOM_CMD:
@@ -79,6 +79,9 @@ enum cloud_module_event_type {
 	/** An error occurred during a FOTA update. */
 	CLOUD_EVT_FOTA_ERROR,
 
+	/** A-GPS data received from cloud has been written to the GNSS module. */
+	CLOUD_EVT_AGPS_DATA_PROCESSED,
+
 	/** Sending data to cloud using QoS library.
 	 *  The payload associated with this event is of type @ref qos_data (message).
 	 *
@@ -120,6 +123,8 @@ struct cloud_module_custom_cmd {
     size_t len;
     /** indicate if the data is allocated*/
     bool is_allocated;
+    /** Function used to release allocated data. heap_tracker_free() is used if NULL. */
+    void (*release)(uint8_t *ptr);
 };
 
 /** @brief Cloud module event. */
@@ -82,13 +82,14 @@ enum data_module_event_type {
 
 	/** Send the initial device configuration.
 	 *  The event has an associated payload of type @ref cloud_data_cfg in
-	 *  the `data.cfg` member.
+	 *  the `data.cfg` member. All fields are flagged in `data.cfg_changed`.
 	 */
 	DATA_EVT_CONFIG_INIT,
 
 	/** Send the updated device configuration.
 	 *  The event has an associated payload of type @ref cloud_data_cfg in
-	 *  the `data.cfg` member.
+	 *  the `data.cfg` member. The fields that have changed are flagged with
+	 *  @ref cloud_data_cfg_field values in `data.cfg_changed`.
 	 */
 	DATA_EVT_CONFIG_READY,
 
@@ -138,8 +139,12 @@ struct data_module_event {
 	union {
 		/** Variable that carries a pointer to data encoded by the module. */
 		struct data_module_data_buffers buffer;
-		/** Variable that carries the current device configuration. */
-		struct cloud_data_cfg cfg;
+		struct {
+			/** Variable that carries the current device configuration. */
+			struct cloud_data_cfg cfg;
+			/** Bitmask of the configuration fields that have changed. */
+			uint32_t cfg_changed;
+		};
 		/** Module ID, used when acknowledging shutdown requests. */
 		uint32_t id;
 		/** Code signifying the cause of error. */
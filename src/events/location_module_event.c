@@ -18,6 +18,8 @@ static char *get_evt_type_str(enum location_module_event_type type)
 		return "LOCATION_MODULE_EVT_DATA_NOT_READY";
 	case LOCATION_MODULE_EVT_NEIGHBOR_CELLS_DATA_READY:
 		return "LOCATION_MODULE_EVT_NEIGHBOR_CELLS_DATA_READY";
+	case LOCATION_MODULE_EVT_NEIGHBOR_CELLS_DATA_UNCHANGED:
+		return "LOCATION_MODULE_EVT_NEIGHBOR_CELLS_DATA_UNCHANGED";
 	case LOCATION_MODULE_EVT_TIMEOUT:
 		return "LOCATION_MODULE_EVT_TIMEOUT";
 	case LOCATION_MODULE_EVT_ACTIVE:
@@ -46,6 +46,12 @@ enum location_module_event_type {
 	 */
 	LOCATION_MODULE_EVT_NEIGHBOR_CELLS_DATA_READY,
 
+	/** Neighbor cell measurements have been gathered, but the cell set matches one that
+	 *  was reported recently and the measurements are not forwarded.
+	 *  The event has no associated payload.
+	 */
+	LOCATION_MODULE_EVT_NEIGHBOR_CELLS_DATA_UNCHANGED,
+
 	/** The location search timed out without acquiring location.
 	 *  The event has associated payload of the type ``struct location_module_data`` in
 	 *  the event struct member ``data.location``.
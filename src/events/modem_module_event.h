@@ -22,6 +22,11 @@
 extern "C" {
 #endif
 
+/** Size of the IP address string. A dual stack PDN context has an IPv4 and an IPv6 address,
+ *  separated by a space.
+ */
+#define MODEM_IP_ADDRESS_LEN_MAX (INET_ADDRSTRLEN + INET6_ADDRSTRLEN)
+
 /** @brief Modem event types submitted by Modem module. */
 enum modem_module_event_type {
 	/** Event signalling that the modem library and AT command library
@@ -176,7 +181,7 @@ struct modem_module_dynamic_modem_data {
 	int16_t rsrp;
 	uint16_t mcc;
 	uint16_t mnc;
-	char ip_address[INET6_ADDRSTRLEN];
+	char ip_address[MODEM_IP_ADDRESS_LEN_MAX];
 	char apn[CONFIG_MODEM_APN_LEN_MAX];
 	char mccmnc[7];
 	uint8_t band;
@@ -88,6 +88,14 @@ struct sensor_module_impact_data {
 	int64_t timestamp;
 	/** Acceleration on impact, measured in G. */
 	double magnitude;
+	/** Impact duration in microseconds, 0 if not captured. */
+	uint32_t duration_us;
+	/** Impact energy in g2 * ms, 0 if not captured. */
+	uint32_t energy;
+	/** Impact classification, 0 if unknown, 1 for a collision and 2 for a drop. */
+	uint8_t type;
+	/** ID of the stored waveform window, 0 if none. */
+	uint16_t window_id;
 };
 
 /** @brief Sensor module event. */
@@ -15,6 +15,14 @@
 #include "ext_sensors_bsec.h"
 #endif
 
+#if defined(CONFIG_EXTERNAL_SENSORS_ACCEL_STREAM)
+#include "ext_sensors_accel_stream.h"
+#endif
+
+#if defined(CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE)
+#include "ext_sensors_impact_capture.h"
+#endif
+
 #include "ext_sensors.h"
 
 #include <zephyr/logging/log.h>
@@ -142,6 +150,13 @@ static void impact_trigger_handler(const struct device *dev,
 
 	switch (trig->type) {
 	case SENSOR_TRIG_THRESHOLD:
+#if defined(CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE)
+		/* The impact is reported once the post-trigger part of the waveform has
+		 * been captured.
+		 */
+		ext_sensors_impact_capture_trigger();
+		break;
+#endif
 		if (sensor_sample_fetch(dev) < 0) {
 			LOG_ERR("Sample fetch error");
 			return;
@@ -153,13 +168,13 @@ static void impact_trigger_handler(const struct device *dev,
 			return;
 		}
 
-		evt.value = sqrt(pow(sensor_ms2_to_g(&data[0]), 2.0) +
-				 pow(sensor_ms2_to_g(&data[1]), 2.0) +
-				 pow(sensor_ms2_to_g(&data[2]), 2.0));
+		evt.impact.magnitude = sqrt(pow(sensor_ms2_to_g(&data[0]), 2.0) +
+					    pow(sensor_ms2_to_g(&data[1]), 2.0) +
+					    pow(sensor_ms2_to_g(&data[2]), 2.0));
 
-		LOG_DBG("Detected impact of %6.2f g\n", evt.value);
+		LOG_DBG("Detected impact of %6.2f g\n", evt.impact.magnitude);
 
-		if (evt.value > 0.0) {
+		if (evt.impact.magnitude > 0.0) {
 			evt.type = EXT_SENSOR_EVT_ACCELEROMETER_IMPACT_TRIGGER;
 			evt_handler(&evt);
 		}
@@ -215,6 +230,14 @@ int ext_sensors_init(ext_sensor_handler_t handler)
 		evt_handler(&evt);
 	}
 
+#if defined(CONFIG_EXTERNAL_SENSORS_ACCEL_STREAM)
+	if (device_is_ready(accel_sensor_lp.dev) && ext_sensors_accel_stream_init(handler)) {
+		LOG_ERR("Accelerometer streaming could not be initialized");
+		evt.type = EXT_SENSOR_EVT_ACCELEROMETER_ERROR;
+		evt_handler(&evt);
+	}
+#endif
+
 #if defined(CONFIG_EXTERNAL_SENSORS_IMPACT_DETECTION)
 	if (!device_is_ready(accel_sensor_hg.dev)) {
 		LOG_ERR("High-G accelerometer device is not ready");
@@ -226,8 +249,18 @@ int ext_sensors_init(ext_sensor_handler_t handler)
 			.type = SENSOR_TRIG_THRESHOLD
 		};
 
-		int err = sensor_trigger_set(accel_sensor_hg.dev,
-					     &trig, impact_trigger_handler);
+#if defined(CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE)
+		int err = ext_sensors_impact_capture_init(handler);
+
+		if (err) {
+			LOG_ERR("ext_sensors_impact_capture_init, error: %d", err);
+			return err;
+		}
+#else
+		int err;
+#endif
+
+		err = sensor_trigger_set(accel_sensor_hg.dev, &trig, impact_trigger_handler);
 		if (err) {
 			LOG_ERR("Could not set trigger for device %s, error: %d",
 				accel_sensor_hg.dev->name, err);
@@ -238,6 +271,67 @@ int ext_sensors_init(ext_sensor_handler_t handler)
 	return 0;
 }
 
+int ext_sensors_environment_get(struct ext_sensors_environment *env)
+{
+	int err;
+	struct env_sensor *sensors[] = { &temp_sensor, &humid_sensor, &press_sensor };
+	const enum ext_sensor_evt_type errors[] = {
+		EXT_SENSOR_EVT_TEMPERATURE_ERROR,
+		EXT_SENSOR_EVT_HUMIDITY_ERROR,
+		EXT_SENSOR_EVT_PRESSURE_ERROR,
+	};
+	struct sensor_value data[ARRAY_SIZE(sensors)];
+	struct ext_sensor_evt evt = {0};
+
+	if (env == NULL) {
+		return -EINVAL;
+	}
+
+#if defined(CONFIG_EXTERNAL_SENSORS_BME680_BSEC)
+	return ext_sensors_bsec_environment_get(&env->temperature, &env->humidity,
+						&env->pressure, &env->air_quality);
+#endif
+
+	for (size_t i = 0; i < ARRAY_SIZE(sensors); i++) {
+		bool fetched = false;
+
+		/* All channels of a sensor are read out in the same fetch. */
+		for (size_t j = 0; j < i; j++) {
+			if (sensors[j]->dev == sensors[i]->dev) {
+				fetched = true;
+				break;
+			}
+		}
+
+		if (!fetched) {
+			err = sensor_sample_fetch_chan(sensors[i]->dev, SENSOR_CHAN_ALL);
+			if (err) {
+				LOG_ERR("Failed to fetch data from %s, error: %d",
+					sensors[i]->dev->name, err);
+				evt.type = errors[i];
+				evt_handler(&evt);
+				return -ENODATA;
+			}
+		}
+
+		err = sensor_channel_get(sensors[i]->dev, sensors[i]->channel, &data[i]);
+		if (err) {
+			LOG_ERR("Failed to fetch data from %s, error: %d",
+				sensors[i]->dev->name, err);
+			evt.type = errors[i];
+			evt_handler(&evt);
+			return -ENODATA;
+		}
+	}
+
+	env->temperature = sensor_value_to_double(&data[0]);
+	env->humidity = sensor_value_to_double(&data[1]);
+	env->pressure = sensor_value_to_double(&data[2]);
+	env->air_quality = UINT16_MAX;
+
+	return 0;
+}
+
 int ext_sensors_temperature_get(double *ext_temp)
 {
 	int err;
@@ -461,3 +555,29 @@ error:
 	evt_handler(&evt);
 	return err;
 }
+
+int ext_sensors_accelerometer_stream_set(bool enable)
+{
+#if defined(CONFIG_EXTERNAL_SENSORS_ACCEL_STREAM)
+	int err = ext_sensors_accel_stream_enable(enable);
+
+	if (err) {
+		struct ext_sensor_evt evt = {
+			.type = EXT_SENSOR_EVT_ACCELEROMETER_ERROR
+		};
+
+		evt_handler(&evt);
+	}
+
+	return err;
+#endif
+	return -ENOTSUP;
+}
+
+int ext_sensors_impact_window_get(uint8_t *buf, size_t buf_len)
+{
+#if defined(CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE)
+	return ext_sensors_impact_capture_window_get(buf, buf_len);
+#endif
+	return -ENOTSUP;
+}
@@ -33,6 +33,8 @@ enum ext_sensor_evt_type {
 	EXT_SENSOR_EVT_ACCELEROMETER_INACT_TRIGGER,
 	/** ADXL372 high-G accelerometer */
 	EXT_SENSOR_EVT_ACCELEROMETER_IMPACT_TRIGGER,
+	/** Block of samples drained from the low-power accelerometer FIFO. */
+	EXT_SENSOR_EVT_ACCELEROMETER_BLOCK,
 
 	/** Event propagated when an error has occurred with any of the accelerometers. */
 	EXT_SENSOR_EVT_ACCELEROMETER_ERROR,
@@ -46,6 +48,89 @@ enum ext_sensor_evt_type {
 	EXT_SENSOR_EVT_BME680_BSEC_ERROR
 };
 
+/** @brief Structure containing a block of accelerometer samples and its features. */
+struct ext_sensor_accel_block {
+	/** Samples in mg, only valid during the callback. */
+	const int16_t (*samples)[ACCELEROMETER_CHANNELS];
+	/** Number of samples. */
+	size_t count;
+	/** RMS of the acceleration with the block mean (gravity) removed, in m/s2. */
+	double rms;
+	/** Peak of the acceleration with the block mean (gravity) removed, in m/s2. */
+	double peak;
+	/** Pitch in degrees, derived from the block mean. */
+	double pitch;
+	/** Roll in degrees, derived from the block mean. */
+	double roll;
+};
+
+/** @brief Impact classification. */
+enum ext_sensor_impact_type {
+	/** No sample in the captured window exceeded the capture threshold. */
+	EXT_SENSOR_IMPACT_TYPE_UNKNOWN,
+	/** Impact without a preceding free fall. */
+	EXT_SENSOR_IMPACT_TYPE_COLLISION,
+	/** Impact preceded by a free fall. */
+	EXT_SENSOR_IMPACT_TYPE_DROP,
+};
+
+/** @brief Structure containing impact data. Only the magnitude is provided unless impact
+ *	   capture is enabled.
+ */
+struct ext_sensor_impact {
+	/** Peak acceleration in G. */
+	double magnitude;
+	/** Peak acceleration in mg. */
+	uint32_t peak_mg;
+	/** Time the acceleration stayed above the capture threshold, in microseconds. */
+	uint32_t duration_us;
+	/** Integral of the squared acceleration over the impact, in g2 * ms. */
+	uint32_t energy;
+	/** Impact classification. */
+	enum ext_sensor_impact_type type;
+	/** ID of the stored waveform window, 0 if no window was stored. */
+	uint16_t window_id;
+};
+
+/** @brief Header of a stored impact waveform window, followed by len bytes of samples.
+ *	   Each sample is an X, Y, Z set in units of 100 mg. Every axis is stored as the
+ *	   difference to the previous sample of the same axis (starting from 0), zigzag
+ *	   encoded as a little endian base 128 varint.
+ */
+struct ext_sensor_impact_window_hdr {
+	/** Window ID. */
+	uint16_t id;
+	/** Length of the encoded samples in bytes. */
+	uint16_t len;
+	/** Number of XYZ samples. */
+	uint16_t sample_count;
+	/** Index of the first sample above the capture threshold. */
+	uint16_t trigger_index;
+	/** Sample rate in Hz. */
+	uint16_t odr_hz;
+	/** Impact classification, @ref ext_sensor_impact_type. */
+	uint8_t type;
+	uint8_t reserved;
+	/** Peak acceleration in mg. */
+	uint32_t peak_mg;
+	/** Impact duration in microseconds. */
+	uint32_t duration_us;
+	/** Impact energy in g2 * ms. */
+	uint32_t energy;
+} __packed;
+
+/** Maximum number of XYZ samples in an impact waveform window, the ADXL372 FIFO holds 512
+ *  entries.
+ */
+#define EXT_SENSOR_IMPACT_WINDOW_SAMPLES_MAX (512 / ACCELEROMETER_CHANNELS)
+
+/** Maximum size of a stored impact waveform window. Each axis of a sample takes at most two
+ *  bytes.
+ */
+#define EXT_SENSOR_IMPACT_WINDOW_SIZE_MAX					\
+	(sizeof(struct ext_sensor_impact_window_hdr) +				\
+	 EXT_SENSOR_IMPACT_WINDOW_SAMPLES_MAX * ACCELEROMETER_CHANNELS * 2)
+
 /** @brief Structure containing external sensor data. */
 struct ext_sensor_evt {
 	/** Sensor type. */
@@ -56,9 +141,25 @@ struct ext_sensor_evt {
 		double value_array[ACCELEROMETER_CHANNELS];
 		/** Single external sensor value. */
 		double value;
+		/** Impact data. */
+		struct ext_sensor_impact impact;
+		/** Accelerometer sample block. */
+		struct ext_sensor_accel_block accel_block;
 	};
 };
 
+/** @brief Structure containing one sample of all environmental sensors. */
+struct ext_sensors_environment {
+	/** Temperature in celsius. */
+	double temperature;
+	/** Humidity in percentage. */
+	double humidity;
+	/** Atmospheric pressure in kilopascal. */
+	double pressure;
+	/** Air quality in Indoor-Air-Quality (IAQ). UINT16_MAX if not available. */
+	uint16_t air_quality;
+};
+
 /** @brief External sensors library asynchronous event handler.
  *
  *  @param[in] evt The event and any associated parameters.
@@ -75,6 +176,16 @@ typedef void (*ext_sensor_handler_t)(
  */
 int ext_sensors_init(ext_sensor_handler_t handler);
 
+/**
+ * @brief Get temperature, humidity, pressure and air quality from a single sensor fetch.
+ *	  Sensors that provide several channels are only fetched once.
+ *
+ * @param[out] env Pointer to structure that is filled with the readings.
+ *
+ * @return 0 on success or negative error value on failure.
+ */
+int ext_sensors_environment_get(struct ext_sensors_environment *env);
+
 /**
  * @brief Get temperature from library.
  *
@@ -150,6 +261,32 @@ int ext_sensors_inactivity_timeout_set(double inact_time);
  */
 int ext_sensors_accelerometer_trigger_callback_set(bool enable);
 
+/**
+ * @brief Enable or disable streaming of accelerometer sample blocks. When enabled, the
+ *	  accelerometer FIFO is drained on its watermark interrupt and each block is delivered
+ *	  in an EXT_SENSOR_EVT_ACCELEROMETER_BLOCK event.
+ *
+ * @param[in] enable Flag that enables or disables streaming.
+ *
+ * @return 0 on success or negative error value on failure.
+ * @retval -ENOTSUP if streaming is not supported.
+ */
+int ext_sensors_accelerometer_stream_set(bool enable);
+
+/**
+ * @brief Get the oldest stored impact waveform window and remove it from the buffer.
+ *
+ * @param[out] buf Buffer for the window, a struct ext_sensor_impact_window_hdr followed by
+ *		   the encoded samples.
+ * @param[in] buf_len Size of the buffer.
+ *
+ * @return Length of the window on success or negative error value on failure.
+ * @retval -ENODATA if no window is stored.
+ * @retval -ENOMEM if the buffer is too small for the window.
+ * @retval -ENOTSUP if impact capture is not supported.
+ */
+int ext_sensors_impact_window_get(uint8_t *buf, size_t buf_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/sys/byteorder.h>
+#include <math.h>
+#include <string.h>
+
+#include "ext_sensors_accel_stream.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(ext_sensors, CONFIG_EXTERNAL_SENSORS_LOG_LEVEL);
+
+/* The ADXL362 driver does not expose the hardware FIFO. The FIFO registers are accessed
+ * directly on the same SPI device, while the driver keeps handling activity and inactivity
+ * detection. The FIFO watermark is routed to INT1 alongside the activity interrupts.
+ */
+#define ACCEL_NODE DT_ALIAS(accelerometer)
+
+#define ADXL362_CMD_WRITE_REG		0x0A
+#define ADXL362_CMD_READ_REG		0x0B
+#define ADXL362_CMD_READ_FIFO		0x0D
+
+#define ADXL362_REG_FIFO_ENTRIES_L	0x0C
+#define ADXL362_REG_FIFO_CONTROL	0x28
+#define ADXL362_REG_FIFO_SAMPLES	0x29
+#define ADXL362_REG_INTMAP1		0x2A
+
+#define ADXL362_FIFO_MODE_DISABLED	0x00
+#define ADXL362_FIFO_MODE_STREAM	0x02
+/* Bit 8 of the watermark. */
+#define ADXL362_FIFO_CONTROL_AH		BIT(3)
+#define ADXL362_INTMAP_FIFO_WATERMARK	BIT(2)
+
+#define ADXL362_FIFO_ENTRIES_MAX	512
+#define ADXL362_FIFO_ENTRIES_MASK	0x3FF
+
+/* Each FIFO entry is a 16-bit word with an axis tag in the upper two bits and 12-bit data
+ * sign extended to 14 bits.
+ */
+#define ADXL362_FIFO_ENTRY_AXIS(entry)	((entry) >> 14)
+#define ADXL362_FIFO_ENTRY_DATA(entry)	((int16_t)((entry) << 2) >> 2)
+
+#if IS_ENABLED(CONFIG_ADXL362_ACCEL_RANGE_2G)
+#define ADXL362_MG_PER_LSB 1
+#elif IS_ENABLED(CONFIG_ADXL362_ACCEL_RANGE_4G)
+#define ADXL362_MG_PER_LSB 2
+#elif IS_ENABLED(CONFIG_ADXL362_ACCEL_RANGE_8G)
+#define ADXL362_MG_PER_LSB 4
+#else
+#error "Unsupported ADXL362 range"
+#endif
+
+#if IS_ENABLED(CONFIG_ADXL362_ACCEL_ODR_12_5)
+#define ADXL362_ODR_MHZ 12500
+#elif IS_ENABLED(CONFIG_ADXL362_ACCEL_ODR_25)
+#define ADXL362_ODR_MHZ 25000
+#elif IS_ENABLED(CONFIG_ADXL362_ACCEL_ODR_50)
+#define ADXL362_ODR_MHZ 50000
+#elif IS_ENABLED(CONFIG_ADXL362_ACCEL_ODR_100)
+#define ADXL362_ODR_MHZ 100000
+#elif IS_ENABLED(CONFIG_ADXL362_ACCEL_ODR_200)
+#define ADXL362_ODR_MHZ 200000
+#elif IS_ENABLED(CONFIG_ADXL362_ACCEL_ODR_400)
+#define ADXL362_ODR_MHZ 400000
+#else
+#error "Unsupported ADXL362 output data rate"
+#endif
+
+#define BLOCK_SIZE		CONFIG_EXTERNAL_SENSORS_ACCEL_STREAM_BLOCK_SIZE
+#define WATERMARK_ENTRIES	(BLOCK_SIZE * ACCELEROMETER_CHANNELS)
+#define BLOCK_COUNT_MAX		(ADXL362_FIFO_ENTRIES_MAX / ACCELEROMETER_CHANNELS)
+
+BUILD_ASSERT(WATERMARK_ENTRIES < ADXL362_FIFO_ENTRIES_MAX, "Block does not fit in the FIFO");
+BUILD_ASSERT(DT_NODE_HAS_PROP(ACCEL_NODE, int1_gpios), "Accelerometer INT1 is not connected");
+
+/* Time to fill the FIFO to the watermark. If no watermark interrupt has been seen within
+ * twice this time, for instance because the edge was lost while the driver had the pin
+ * interrupt disabled, the FIFO is drained anyway.
+ */
+#define BLOCK_TIME_MS ((BLOCK_SIZE * MSEC_PER_SEC * 1000) / ADXL362_ODR_MHZ)
+#define DRAIN_BACKSTOP_TIMEOUT K_MSEC(2 * BLOCK_TIME_MS)
+
+#define MG_TO_MS2(mg) ((mg) * (SENSOR_G / 1000000.0) / 1000.0)
+#define RAD_TO_DEG(rad) ((rad) * 180.0 / 3.14159265358979323846)
+
+static const struct spi_dt_spec spi = SPI_DT_SPEC_GET(ACCEL_NODE,
+						      SPI_WORD_SET(8) | SPI_TRANSFER_MSB, 0);
+static const struct gpio_dt_spec int1 = GPIO_DT_SPEC_GET(ACCEL_NODE, int1_gpios);
+static struct gpio_callback int1_cb;
+
+static ext_sensor_handler_t evt_handler;
+static atomic_t enabled;
+
+static uint8_t fifo_buf[ADXL362_FIFO_ENTRIES_MAX * sizeof(uint16_t)];
+/* Samples of the last block in mg, valid during the EXT_SENSOR_EVT_ACCELEROMETER_BLOCK
+ * callback.
+ */
+static int16_t samples[BLOCK_COUNT_MAX][ACCELEROMETER_CHANNELS];
+
+static void drain_work_fn(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(drain_work, drain_work_fn);
+
+static int reg_read(uint8_t reg, uint8_t *data, size_t len)
+{
+	uint8_t cmd[] = { ADXL362_CMD_READ_REG, reg };
+	const struct spi_buf tx_buf = { .buf = cmd, .len = sizeof(cmd) };
+	const struct spi_buf_set tx = { .buffers = &tx_buf, .count = 1 };
+	struct spi_buf rx_buf[] = {
+		{ .buf = NULL, .len = sizeof(cmd) },
+		{ .buf = data, .len = len },
+	};
+	const struct spi_buf_set rx = { .buffers = rx_buf, .count = ARRAY_SIZE(rx_buf) };
+
+	return spi_transceive_dt(&spi, &tx, &rx);
+}
+
+static int reg_write(uint8_t reg, uint8_t value)
+{
+	uint8_t cmd[] = { ADXL362_CMD_WRITE_REG, reg, value };
+	const struct spi_buf tx_buf = { .buf = cmd, .len = sizeof(cmd) };
+	const struct spi_buf_set tx = { .buffers = &tx_buf, .count = 1 };
+
+	return spi_write_dt(&spi, &tx);
+}
+
+static int reg_update(uint8_t reg, uint8_t mask, uint8_t value)
+{
+	uint8_t current;
+	int err = reg_read(reg, &current, 1);
+
+	if (err) {
+		return err;
+	}
+
+	return reg_write(reg, (current & ~mask) | (value & mask));
+}
+
+static int fifo_read(uint8_t *data, size_t len)
+{
+	uint8_t cmd = ADXL362_CMD_READ_FIFO;
+	const struct spi_buf tx_buf = { .buf = &cmd, .len = sizeof(cmd) };
+	const struct spi_buf_set tx = { .buffers = &tx_buf, .count = 1 };
+	struct spi_buf rx_buf[] = {
+		{ .buf = NULL, .len = sizeof(cmd) },
+		{ .buf = data, .len = len },
+	};
+	const struct spi_buf_set rx = { .buffers = rx_buf, .count = ARRAY_SIZE(rx_buf) };
+
+	return spi_transceive_dt(&spi, &tx, &rx);
+}
+
+/* Assemble XYZ sample sets from FIFO entries using the axis tags, so that a set split by a
+ * FIFO overrun is dropped rather than mixed with the next one.
+ */
+static size_t samples_unpack(size_t entries)
+{
+	size_t count = 0;
+	uint8_t axes_seen = 0;
+	int16_t xyz[ACCELEROMETER_CHANNELS];
+
+	for (size_t i = 0; i < entries; i++) {
+		uint16_t entry = sys_get_le16(&fifo_buf[i * sizeof(uint16_t)]);
+		uint8_t axis = ADXL362_FIFO_ENTRY_AXIS(entry);
+
+		if (axis >= ACCELEROMETER_CHANNELS) {
+			/* Temperature entry. */
+			continue;
+		}
+
+		if (axis == 0) {
+			axes_seen = 0;
+		}
+
+		xyz[axis] = ADXL362_FIFO_ENTRY_DATA(entry) * ADXL362_MG_PER_LSB;
+		axes_seen |= BIT(axis);
+
+		if ((axis == (ACCELEROMETER_CHANNELS - 1)) &&
+		    (axes_seen == BIT_MASK(ACCELEROMETER_CHANNELS))) {
+			memcpy(samples[count++], xyz, sizeof(xyz));
+		}
+	}
+
+	return count;
+}
+
+/* The block mean approximates gravity and gives the orientation. RMS and peak are computed
+ * on the remaining dynamic acceleration.
+ */
+static void features_compute(struct ext_sensor_accel_block *block)
+{
+	int32_t mean[ACCELEROMETER_CHANNELS];
+	int64_t sum[ACCELEROMETER_CHANNELS] = {0};
+	int64_t sum_sq = 0;
+	int32_t peak_sq = 0;
+
+	for (size_t i = 0; i < block->count; i++) {
+		for (size_t axis = 0; axis < ACCELEROMETER_CHANNELS; axis++) {
+			sum[axis] += samples[i][axis];
+		}
+	}
+
+	for (size_t axis = 0; axis < ACCELEROMETER_CHANNELS; axis++) {
+		mean[axis] = (int32_t)(sum[axis] / (int64_t)block->count);
+	}
+
+	for (size_t i = 0; i < block->count; i++) {
+		int32_t mag_sq = 0;
+
+		for (size_t axis = 0; axis < ACCELEROMETER_CHANNELS; axis++) {
+			int32_t dynamic = samples[i][axis] - mean[axis];
+
+			mag_sq += dynamic * dynamic;
+		}
+
+		sum_sq += mag_sq;
+		peak_sq = MAX(peak_sq, mag_sq);
+	}
+
+	block->rms = MG_TO_MS2(sqrt((double)sum_sq / block->count));
+	block->peak = MG_TO_MS2(sqrt((double)peak_sq));
+	block->pitch = RAD_TO_DEG(atan2(-mean[0], sqrt((double)mean[1] * mean[1] +
+							(double)mean[2] * mean[2])));
+	block->roll = RAD_TO_DEG(atan2(mean[1], mean[2]));
+}
+
+static void drain_work_fn(struct k_work *work)
+{
+	int err;
+	uint8_t buf[2];
+	size_t entries;
+	struct ext_sensor_evt evt = {
+		.type = EXT_SENSOR_EVT_ACCELEROMETER_BLOCK,
+	};
+
+	ARG_UNUSED(work);
+
+	if (!atomic_get(&enabled)) {
+		return;
+	}
+
+	k_work_reschedule(&drain_work, DRAIN_BACKSTOP_TIMEOUT);
+
+	err = reg_read(ADXL362_REG_FIFO_ENTRIES_L, buf, sizeof(buf));
+	if (err) {
+		LOG_ERR("Failed to read FIFO entries, error: %d", err);
+		return;
+	}
+
+	entries = sys_get_le16(buf) & ADXL362_FIFO_ENTRIES_MASK;
+
+	/* INT1 is shared with the activity interrupts, wait for a full block. */
+	if (entries < WATERMARK_ENTRIES) {
+		return;
+	}
+
+	/* Read whole sample sets to stay aligned with the X axis. */
+	entries -= entries % ACCELEROMETER_CHANNELS;
+
+	err = fifo_read(fifo_buf, entries * sizeof(uint16_t));
+	if (err) {
+		LOG_ERR("Failed to read FIFO, error: %d", err);
+		return;
+	}
+
+	evt.accel_block.samples = (const int16_t (*)[ACCELEROMETER_CHANNELS])samples;
+	evt.accel_block.count = samples_unpack(entries);
+
+	if (evt.accel_block.count == 0) {
+		return;
+	}
+
+	features_compute(&evt.accel_block);
+
+	LOG_DBG("Block of %d samples, RMS: %.3f m/s2, peak: %.3f m/s2, pitch: %.1f, roll: %.1f",
+		evt.accel_block.count, evt.accel_block.rms, evt.accel_block.peak,
+		evt.accel_block.pitch, evt.accel_block.roll);
+
+	evt_handler(&evt);
+}
+
+static void int1_handler(const struct device *port, struct gpio_callback *cb, uint32_t pins)
+{
+	ARG_UNUSED(port);
+	ARG_UNUSED(cb);
+	ARG_UNUSED(pins);
+
+	if (atomic_get(&enabled)) {
+		k_work_reschedule(&drain_work, K_NO_WAIT);
+	}
+}
+
+int ext_sensors_accel_stream_init(ext_sensor_handler_t handler)
+{
+	int err;
+
+	if (!spi_is_ready(&spi) || !device_is_ready(int1.port)) {
+		LOG_ERR("Accelerometer SPI bus or INT1 port is not ready");
+		return -ENODEV;
+	}
+
+	evt_handler = handler;
+
+	/* The driver has its own callback on the same pin, both are called on each edge. */
+	gpio_init_callback(&int1_cb, int1_handler, BIT(int1.pin));
+
+	err = gpio_add_callback(int1.port, &int1_cb);
+	if (err) {
+		LOG_ERR("gpio_add_callback, error: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+int ext_sensors_accel_stream_enable(bool enable)
+{
+	int err;
+	uint8_t fifo_control = enable ? ADXL362_FIFO_MODE_STREAM : ADXL362_FIFO_MODE_DISABLED;
+
+	if (evt_handler == NULL) {
+		return -ENODEV;
+	}
+
+	atomic_set(&enabled, enable);
+
+	if (!enable) {
+		(void)k_work_cancel_delayable(&drain_work);
+	}
+
+	if (WATERMARK_ENTRIES > UINT8_MAX) {
+		fifo_control |= ADXL362_FIFO_CONTROL_AH;
+	}
+
+	err = reg_write(ADXL362_REG_FIFO_SAMPLES, WATERMARK_ENTRIES & UINT8_MAX);
+	if (err) {
+		goto error;
+	}
+
+	/* Changing the FIFO mode also clears the FIFO. */
+	err = reg_write(ADXL362_REG_FIFO_CONTROL, fifo_control);
+	if (err) {
+		goto error;
+	}
+
+	err = reg_update(ADXL362_REG_INTMAP1, ADXL362_INTMAP_FIFO_WATERMARK,
+			 enable ? ADXL362_INTMAP_FIFO_WATERMARK : 0);
+	if (err) {
+		goto error;
+	}
+
+	if (enable) {
+		err = gpio_pin_interrupt_configure_dt(&int1, GPIO_INT_EDGE_TO_ACTIVE);
+		if (err) {
+			goto error;
+		}
+
+		k_work_reschedule(&drain_work, DRAIN_BACKSTOP_TIMEOUT);
+	}
+
+	LOG_DBG("Accelerometer streaming %s, %d samples per block",
+		enable ? "enabled" : "disabled", BLOCK_SIZE);
+
+	return 0;
+
+error:
+	LOG_ERR("Failed to configure accelerometer FIFO, error: %d", err);
+	atomic_set(&enabled, false);
+	return err;
+}
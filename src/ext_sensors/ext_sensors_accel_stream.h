@@ -0,0 +1,11 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "ext_sensors.h"
+
+int ext_sensors_accel_stream_init(ext_sensor_handler_t handler);
+
+int ext_sensors_accel_stream_enable(bool enable);
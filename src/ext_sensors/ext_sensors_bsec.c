@@ -51,6 +51,16 @@ float temp_offset = (CONFIG_EXTERNAL_SENSORS_BSEC_TEMPERATURE_OFFSET / (float)10
 #define BSEC_STACK_SIZE CONFIG_EXTERNAL_SENSORS_BSEC_THREAD_STACK_SIZE
 K_THREAD_STACK_DEFINE(thread_stack, BSEC_STACK_SIZE);
 
+/* State is written to flash from a low priority work queue, so that flash erase does not
+ * delay BSEC sampling.
+ */
+K_THREAD_STACK_DEFINE(save_stack, CONFIG_EXTERNAL_SENSORS_BSEC_SAVE_STACK_SIZE);
+
+/* Named so that the queue shows up in thread statistics. */
+static const struct k_work_queue_config save_work_q_cfg = {
+	.name = "bsec_save",
+};
+
 struct config {
 	/* Variable used to reference the I2C device where BME680 is connected to. */
 	const struct device *i2c_master;
@@ -70,10 +80,28 @@ struct ctx {
 	/* Internal BSEC thread metadata value. */
 	struct k_thread thread;
 
-	/* Buffer used to maintain the BSEC library state. */
+	/* Buffer used to maintain the BSEC library state. Holds the state last stored to
+	 * flash.
+	 */
 	uint8_t state_buffer[BSEC_MAX_STATE_BLOB_SIZE];
 	int32_t state_buffer_len;
 
+	/* Double buffer for state waiting to be stored. The BSEC thread fills
+	 * save_buffer[save_fill] while the save work stores the other one.
+	 */
+	struct k_spinlock save_lock;
+	uint8_t save_buffer[2][BSEC_MAX_STATE_BLOB_SIZE];
+	uint32_t save_buffer_len[2];
+	uint8_t save_fill;
+	bool save_pending;
+
+	struct k_work_q save_work_q;
+	struct k_work save_work;
+
+	/* Duration of flash writes of the state. */
+	uint32_t save_time_last_ms;
+	uint32_t save_time_max_ms;
+	uint32_t save_count;
 };
 
 static const struct config config = {
@@ -184,19 +212,94 @@ static uint32_t state_load(uint8_t *state_buffer, uint32_t n_buffer)
 	return 0;
 }
 
-static void state_save(const uint8_t *state_buffer, uint32_t length)
+/* Number of bytes that differ from the state stored in flash. */
+static size_t state_diff_get(const uint8_t *state_buffer, uint32_t length)
 {
-	LOG_INF("Storing state to flash");
-	if (length > sizeof(ctx.state_buffer)) {
-		LOG_ERR("State buffer too big to save: %d", length);
+	size_t diff = 0;
+
+	if (length != (uint32_t)ctx.state_buffer_len) {
+		return length;
+	}
+
+	for (size_t i = 0; i < length; i++) {
+		if (state_buffer[i] != ctx.state_buffer[i]) {
+			diff++;
+		}
+	}
+
+	return diff;
+}
+
+static void state_save_work_fn(struct k_work *work)
+{
+	uint8_t *state_buffer;
+	uint32_t length;
+	size_t diff;
+	int64_t start;
+	uint32_t duration;
+
+	k_spinlock_key_t key = k_spin_lock(&ctx.save_lock);
+
+	if (!ctx.save_pending) {
+		k_spin_unlock(&ctx.save_lock, key);
+		return;
+	}
+
+	/* Swap buffers, the BSEC thread continues in the other one. */
+	state_buffer = ctx.save_buffer[ctx.save_fill];
+	length = ctx.save_buffer_len[ctx.save_fill];
+	ctx.save_fill ^= 1;
+	ctx.save_pending = false;
+
+	k_spin_unlock(&ctx.save_lock, key);
+
+	diff = state_diff_get(state_buffer, length);
+	if (diff < CONFIG_EXTERNAL_SENSORS_BSEC_STATE_SAVE_MIN_DIFF) {
+		LOG_DBG("State changed in %d bytes, not stored", diff);
 		return;
 	}
 
+	LOG_INF("Storing state to flash");
+
+	start = k_uptime_get();
+
 	int err = settings_save_one(SETTINGS_BSEC_STATE, state_buffer, length);
 
+	duration = (uint32_t)(k_uptime_get() - start);
+
 	if (err) {
 		LOG_ERR("Storing state to flash failed");
+		return;
 	}
+
+	memcpy(ctx.state_buffer, state_buffer, length);
+	ctx.state_buffer_len = length;
+
+	ctx.save_count++;
+	ctx.save_time_last_ms = duration;
+	ctx.save_time_max_ms = MAX(ctx.save_time_max_ms, duration);
+
+	LOG_INF("State stored, %d bytes changed, write took %d ms (max %d ms, %d writes)",
+		diff, duration, ctx.save_time_max_ms, ctx.save_count);
+}
+
+/* Called from the BSEC thread. The state is only copied, it is stored by the save work. */
+static void state_save(const uint8_t *state_buffer, uint32_t length)
+{
+	if (length > sizeof(ctx.state_buffer)) {
+		LOG_ERR("State buffer too big to save: %d", length);
+		return;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&ctx.save_lock);
+
+	memcpy(ctx.save_buffer[ctx.save_fill], state_buffer, length);
+	ctx.save_buffer_len[ctx.save_fill] = length;
+	ctx.save_pending = true;
+
+	k_spin_unlock(&ctx.save_lock, key);
+
+	k_work_submit_to_queue(&ctx.save_work_q, &ctx.save_work);
 }
 
 static uint32_t config_load(uint8_t *config_buffer, uint32_t n_buffer)
@@ -264,6 +367,24 @@ int ext_sensors_bsec_air_quality_get(uint16_t *air_quality)
 	return 0;
 }
 
+int ext_sensors_bsec_environment_get(double *temperature, double *humidity, double *pressure,
+				     uint16_t *air_quality)
+{
+	if ((temperature == NULL) || (humidity == NULL) || (pressure == NULL) ||
+	    (air_quality == NULL)) {
+		return -EINVAL;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&ctx.sensor_read_lock);
+
+	*temperature = ctx.temperature_latest;
+	*humidity = ctx.humidity_latest;
+	*pressure = ctx.pressure_latest;
+	*air_quality = ctx.air_quality_latest;
+	k_spin_unlock(&ctx.sensor_read_lock, key);
+	return 0;
+}
+
 int ext_sensors_bsec_init(void)
 {
 	int err;
@@ -297,6 +418,10 @@ int ext_sensors_bsec_init(void)
 		return -EIO;
 	}
 
+	k_work_queue_start(&ctx.save_work_q, save_stack, K_THREAD_STACK_SIZEOF(save_stack),
+			   K_LOWEST_APPLICATION_THREAD_PRIO, &save_work_q_cfg);
+	k_work_init(&ctx.save_work, state_save_work_fn);
+
 	k_thread_create(&ctx.thread,
 			thread_stack,
 			BSEC_STACK_SIZE,
@@ -12,4 +12,7 @@ int ext_sensors_bsec_pressure_get(double *pressure);
 
 int ext_sensors_bsec_air_quality_get(uint16_t *air_quality);
 
+int ext_sensors_bsec_environment_get(double *temperature, double *humidity, double *pressure,
+				     uint16_t *air_quality);
+
 int ext_sensors_bsec_init(void);
@@ -0,0 +1,435 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/spi.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <string.h>
+
+#include "ext_sensors_impact_capture.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(ext_sensors, CONFIG_EXTERNAL_SENSORS_LOG_LEVEL);
+
+/* The ADXL372 driver only reads single peak samples. The FIFO is switched to streaming XYZ
+ * samples and read directly on the same SPI device, so that it always holds the most recent
+ * waveform. The driver keeps handling the threshold interrupt.
+ */
+#define IMPACT_NODE DT_ALIAS(impact_sensor)
+
+BUILD_ASSERT(DT_ON_BUS(IMPACT_NODE, spi), "Impact capture requires the ADXL372 on SPI");
+
+#define ADXL372_SPI_READ(reg)		(((reg) << 1) | 1)
+#define ADXL372_SPI_WRITE(reg)		((reg) << 1)
+
+#define ADXL372_REG_FIFO_ENTRIES_2	0x06
+#define ADXL372_REG_FIFO_SAMPLES	0x39
+#define ADXL372_REG_FIFO_CTL		0x3A
+#define ADXL372_REG_POWER_CTL		0x3F
+#define ADXL372_REG_FIFO_DATA		0x42
+
+#define ADXL372_FIFO_CTL_FORMAT_XYZ	(0 << 3)
+#define ADXL372_FIFO_CTL_MODE_STREAMED	(1 << 1)
+#define ADXL372_FIFO_CTL_SAMPLES_MSB	BIT(0)
+#define ADXL372_POWER_CTL_MODE_MASK	0x03
+#define ADXL372_POWER_CTL_STANDBY	0x00
+
+#define ADXL372_FIFO_ENTRIES_MAX	512
+#define ADXL372_FIFO_ENTRIES_MASK	0x3FF
+#define ADXL372_MG_PER_LSB		100
+
+/* FIFO samples are 12-bit, big endian and left justified. */
+#define ADXL372_FIFO_SAMPLE(buf)	((int16_t)sys_get_be16(buf) >> 4)
+
+#if IS_ENABLED(CONFIG_ADXL372_ODR_400HZ)
+#define ADXL372_ODR_HZ 400
+#elif IS_ENABLED(CONFIG_ADXL372_ODR_800HZ)
+#define ADXL372_ODR_HZ 800
+#elif IS_ENABLED(CONFIG_ADXL372_ODR_1600HZ)
+#define ADXL372_ODR_HZ 1600
+#elif IS_ENABLED(CONFIG_ADXL372_ODR_3200HZ)
+#define ADXL372_ODR_HZ 3200
+#else
+#define ADXL372_ODR_HZ 6400
+#endif
+
+#define AXES			ACCELEROMETER_CHANNELS
+#define WINDOW_SAMPLES_MAX	EXT_SENSOR_IMPACT_WINDOW_SAMPLES_MAX
+#define SAMPLE_PERIOD_US	(USEC_PER_SEC / ADXL372_ODR_HZ)
+
+#define POST_TRIGGER_SAMPLES	CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE_POST_TRIGGER_SAMPLES
+#define POST_TRIGGER_DELAY	K_USEC(POST_TRIGGER_SAMPLES * SAMPLE_PERIOD_US)
+
+/* Thresholds in LSB, compared against squared magnitudes. */
+#define THRESHOLD_LSB \
+	(CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE_THRESHOLD_MG / ADXL372_MG_PER_LSB)
+#define FREEFALL_LSB \
+	(CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE_FREEFALL_MG / ADXL372_MG_PER_LSB)
+
+BUILD_ASSERT(POST_TRIGGER_SAMPLES < WINDOW_SAMPLES_MAX, "Post-trigger exceeds FIFO");
+
+/* Zigzag varints of 12-bit deltas take at most two bytes. */
+#define PAYLOAD_SIZE_MAX	(WINDOW_SAMPLES_MAX * AXES * 2)
+#define WINDOW_SIZE_MAX		EXT_SENSOR_IMPACT_WINDOW_SIZE_MAX
+
+BUILD_ASSERT(WINDOW_SAMPLES_MAX == ADXL372_FIFO_ENTRIES_MAX / AXES,
+	     "Impact window does not match the FIFO size");
+
+BUILD_ASSERT(CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE_BUFFER_SIZE >= WINDOW_SIZE_MAX,
+	     "Impact window buffer cannot hold a single window");
+
+static const struct spi_dt_spec spi = SPI_DT_SPEC_GET(IMPACT_NODE,
+						      SPI_WORD_SET(8) | SPI_TRANSFER_MSB, 0);
+
+static ext_sensor_handler_t evt_handler;
+static atomic_t capture_pending;
+static uint16_t window_id;
+
+static uint8_t fifo_buf[ADXL372_FIFO_ENTRIES_MAX * sizeof(uint16_t)];
+static int16_t samples[WINDOW_SAMPLES_MAX][AXES];
+static uint8_t payload[PAYLOAD_SIZE_MAX];
+
+/* Compressed windows waiting to be uploaded, oldest first. */
+RING_BUF_DECLARE(window_buf, CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE_BUFFER_SIZE);
+static K_MUTEX_DEFINE(window_buf_lock);
+
+static void capture_work_fn(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(capture_work, capture_work_fn);
+
+static int reg_read(uint8_t reg, uint8_t *data, size_t len)
+{
+	uint8_t cmd = ADXL372_SPI_READ(reg);
+	const struct spi_buf tx_buf = { .buf = &cmd, .len = sizeof(cmd) };
+	const struct spi_buf_set tx = { .buffers = &tx_buf, .count = 1 };
+	struct spi_buf rx_buf[] = {
+		{ .buf = NULL, .len = sizeof(cmd) },
+		{ .buf = data, .len = len },
+	};
+	const struct spi_buf_set rx = { .buffers = rx_buf, .count = ARRAY_SIZE(rx_buf) };
+
+	return spi_transceive_dt(&spi, &tx, &rx);
+}
+
+static int reg_write(uint8_t reg, uint8_t value)
+{
+	uint8_t cmd[] = { ADXL372_SPI_WRITE(reg), value };
+	const struct spi_buf tx_buf = { .buf = cmd, .len = sizeof(cmd) };
+	const struct spi_buf_set tx = { .buffers = &tx_buf, .count = 1 };
+
+	return spi_write_dt(&spi, &tx);
+}
+
+/* The FIFO can only be configured in standby. */
+static int fifo_configure(void)
+{
+	int err;
+	uint8_t power_ctl;
+
+	err = reg_read(ADXL372_REG_POWER_CTL, &power_ctl, 1);
+	if (err) {
+		return err;
+	}
+
+	err = reg_write(ADXL372_REG_POWER_CTL, power_ctl & ~ADXL372_POWER_CTL_MODE_MASK);
+	if (err) {
+		return err;
+	}
+
+	/* The watermark is not used, the FIFO is read after each impact. */
+	err = reg_write(ADXL372_REG_FIFO_SAMPLES, 0xFF);
+	if (err) {
+		return err;
+	}
+
+	err = reg_write(ADXL372_REG_FIFO_CTL, ADXL372_FIFO_CTL_FORMAT_XYZ |
+					      ADXL372_FIFO_CTL_MODE_STREAMED |
+					      ADXL372_FIFO_CTL_SAMPLES_MSB);
+	if (err) {
+		return err;
+	}
+
+	return reg_write(ADXL372_REG_POWER_CTL, power_ctl);
+}
+
+static size_t fifo_read(void)
+{
+	int err;
+	uint8_t buf[2];
+	size_t entries;
+	uint8_t cmd = ADXL372_SPI_READ(ADXL372_REG_FIFO_DATA);
+	const struct spi_buf tx_buf = { .buf = &cmd, .len = sizeof(cmd) };
+	const struct spi_buf_set tx = { .buffers = &tx_buf, .count = 1 };
+	struct spi_buf rx_buf[] = {
+		{ .buf = NULL, .len = sizeof(cmd) },
+		{ .buf = fifo_buf, .len = 0 },
+	};
+	const struct spi_buf_set rx = { .buffers = rx_buf, .count = ARRAY_SIZE(rx_buf) };
+
+	err = reg_read(ADXL372_REG_FIFO_ENTRIES_2, buf, sizeof(buf));
+	if (err) {
+		LOG_ERR("Failed to read FIFO entries, error: %d", err);
+		return 0;
+	}
+
+	entries = sys_get_be16(buf) & ADXL372_FIFO_ENTRIES_MASK;
+
+	/* Whole XYZ sets only, the FIFO always starts a set with the X axis. */
+	entries -= entries % AXES;
+	rx_buf[1].len = entries * sizeof(uint16_t);
+
+	err = spi_transceive_dt(&spi, &tx, &rx);
+	if (err) {
+		LOG_ERR("Failed to read FIFO, error: %d", err);
+		return 0;
+	}
+
+	for (size_t i = 0; i < entries / AXES; i++) {
+		for (size_t axis = 0; axis < AXES; axis++) {
+			samples[i][axis] =
+				ADXL372_FIFO_SAMPLE(&fifo_buf[((i * AXES) + axis) * sizeof(uint16_t)]);
+		}
+	}
+
+	return entries / AXES;
+}
+
+static uint32_t isqrt(uint32_t value)
+{
+	uint32_t root = 0;
+	uint32_t bit = BIT(30);
+
+	while (bit > value) {
+		bit >>= 2;
+	}
+
+	while (bit) {
+		if (value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+
+		bit >>= 2;
+	}
+
+	return root;
+}
+
+static uint32_t magnitude_sq(const int16_t *sample)
+{
+	uint32_t sum = 0;
+
+	for (size_t axis = 0; axis < AXES; axis++) {
+		sum += (int32_t)sample[axis] * sample[axis];
+	}
+
+	return sum;
+}
+
+/* All features are computed in LSB with integer math. The impact spans from the first to
+ * the last sample above the threshold. An impact preceded by a run of samples below the
+ * free-fall threshold is classified as a drop.
+ */
+static void features_compute(size_t count, struct ext_sensor_impact *impact,
+			     struct ext_sensor_impact_window_hdr *hdr)
+{
+	size_t first = count;
+	size_t last = 0;
+	size_t freefall_run = 0;
+	size_t freefall_run_max = 0;
+	uint32_t peak_sq = 0;
+	uint64_t energy_sq = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		uint32_t mag_sq = magnitude_sq(samples[i]);
+
+		peak_sq = MAX(peak_sq, mag_sq);
+
+		if (mag_sq >= (THRESHOLD_LSB * THRESHOLD_LSB)) {
+			first = MIN(first, i);
+			last = i;
+		}
+
+		if (first == count) {
+			freefall_run = (mag_sq <= (FREEFALL_LSB * FREEFALL_LSB)) ?
+				       freefall_run + 1 : 0;
+			freefall_run_max = MAX(freefall_run_max, freefall_run);
+		}
+	}
+
+	for (size_t i = first; i <= last && i < count; i++) {
+		energy_sq += magnitude_sq(samples[i]);
+	}
+
+	impact->peak_mg = isqrt(peak_sq) * ADXL372_MG_PER_LSB;
+	impact->magnitude = impact->peak_mg / 1000.0;
+
+	if (first == count) {
+		impact->duration_us = 0;
+		impact->energy = 0;
+		impact->type = EXT_SENSOR_IMPACT_TYPE_UNKNOWN;
+	} else {
+		impact->duration_us = (last - first + 1) * SAMPLE_PERIOD_US;
+		/* One LSB squared is 0.01 g2, the energy is reported in g2 * ms. */
+		impact->energy = (uint32_t)((energy_sq * SAMPLE_PERIOD_US) /
+					    (100 * USEC_PER_MSEC));
+		impact->type = (freefall_run_max >=
+				CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE_FREEFALL_SAMPLES) ?
+			       EXT_SENSOR_IMPACT_TYPE_DROP : EXT_SENSOR_IMPACT_TYPE_COLLISION;
+	}
+
+	hdr->sample_count = count;
+	hdr->trigger_index = (first == count) ? 0 : first;
+	hdr->odr_hz = ADXL372_ODR_HZ;
+	hdr->peak_mg = impact->peak_mg;
+	hdr->duration_us = impact->duration_us;
+	hdr->energy = impact->energy;
+	hdr->type = impact->type;
+}
+
+/* Each axis is delta encoded against the previous sample and stored as a zigzag varint.
+ * Between impacts the deltas are mostly within +-63 LSB, which takes a single byte.
+ */
+static size_t window_compress(size_t count)
+{
+	size_t len = 0;
+	int16_t prev[AXES] = {0};
+
+	for (size_t i = 0; i < count; i++) {
+		for (size_t axis = 0; axis < AXES; axis++) {
+			int32_t delta = samples[i][axis] - prev[axis];
+			uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+
+			prev[axis] = samples[i][axis];
+
+			while (zigzag >= 0x80) {
+				payload[len++] = (zigzag & 0x7F) | 0x80;
+				zigzag >>= 7;
+			}
+
+			payload[len++] = zigzag;
+		}
+	}
+
+	return len;
+}
+
+/* Store a window, dropping the oldest windows if the buffer is full. */
+static void window_store(struct ext_sensor_impact_window_hdr *hdr)
+{
+	size_t size = sizeof(*hdr) + hdr->len;
+
+	k_mutex_lock(&window_buf_lock, K_FOREVER);
+
+	while (ring_buf_space_get(&window_buf) < size) {
+		struct ext_sensor_impact_window_hdr oldest;
+
+		(void)ring_buf_get(&window_buf, (uint8_t *)&oldest, sizeof(oldest));
+		(void)ring_buf_get(&window_buf, NULL, oldest.len);
+
+		LOG_WRN("Impact window buffer full, window %d dropped", oldest.id);
+	}
+
+	(void)ring_buf_put(&window_buf, (uint8_t *)hdr, sizeof(*hdr));
+	(void)ring_buf_put(&window_buf, payload, hdr->len);
+
+	k_mutex_unlock(&window_buf_lock);
+}
+
+static void capture_work_fn(struct k_work *work)
+{
+	size_t count;
+	struct ext_sensor_impact_window_hdr hdr = { 0 };
+	struct ext_sensor_evt evt = {
+		.type = EXT_SENSOR_EVT_ACCELEROMETER_IMPACT_TRIGGER,
+	};
+
+	ARG_UNUSED(work);
+
+	count = fifo_read();
+
+	atomic_set(&capture_pending, false);
+
+	if (count == 0) {
+		return;
+	}
+
+	/* Window ID 0 means that no window was stored. */
+	window_id = (window_id == UINT16_MAX) ? 1 : window_id + 1;
+	hdr.id = window_id;
+
+	features_compute(count, &evt.impact, &hdr);
+
+	hdr.len = window_compress(count);
+	window_store(&hdr);
+
+	evt.impact.window_id = hdr.id;
+
+	LOG_DBG("Impact window %d: %d samples, %d bytes, peak: %d mg, duration: %d us, "
+		"energy: %d g2ms, type: %d", hdr.id, count, hdr.len, evt.impact.peak_mg,
+		evt.impact.duration_us, evt.impact.energy, evt.impact.type);
+
+	evt_handler(&evt);
+}
+
+void ext_sensors_impact_capture_trigger(void)
+{
+	/* Threshold interrupts during the post-trigger time belong to the same window. */
+	if (atomic_cas(&capture_pending, false, true)) {
+		k_work_schedule(&capture_work, POST_TRIGGER_DELAY);
+	}
+}
+
+int ext_sensors_impact_capture_window_get(uint8_t *buf, size_t buf_len)
+{
+	int err;
+	struct ext_sensor_impact_window_hdr hdr;
+	size_t size;
+
+	k_mutex_lock(&window_buf_lock, K_FOREVER);
+
+	if (ring_buf_peek(&window_buf, (uint8_t *)&hdr, sizeof(hdr)) != sizeof(hdr)) {
+		err = -ENODATA;
+		goto exit;
+	}
+
+	size = sizeof(hdr) + hdr.len;
+
+	if (buf_len < size) {
+		err = -ENOMEM;
+		goto exit;
+	}
+
+	err = ring_buf_get(&window_buf, buf, size);
+
+exit:
+	k_mutex_unlock(&window_buf_lock);
+	return err;
+}
+
+int ext_sensors_impact_capture_init(ext_sensor_handler_t handler)
+{
+	int err;
+
+	if (!spi_is_ready(&spi)) {
+		LOG_ERR("High-G accelerometer SPI bus is not ready");
+		return -ENODEV;
+	}
+
+	err = fifo_configure();
+	if (err) {
+		LOG_ERR("Failed to configure high-G accelerometer FIFO, error: %d", err);
+		return err;
+	}
+
+	evt_handler = handler;
+
+	return 0;
+}
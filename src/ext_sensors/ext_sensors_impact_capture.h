@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "ext_sensors.h"
+
+int ext_sensors_impact_capture_init(ext_sensor_handler_t handler);
+
+void ext_sensors_impact_capture_trigger(void);
+
+int ext_sensors_impact_capture_window_get(uint8_t *buf, size_t buf_len);
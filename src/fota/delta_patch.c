@@ -0,0 +1,438 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include <dfu/dfu_target.h>
+#include <dfu/dfu_target_mcuboot.h>
+#include <pm_config.h>
+#include <string.h>
+
+#include "delta_patch.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(delta_patch, CONFIG_FOTA_MANAGER_LOG_LEVEL);
+
+#define SOURCE_CACHE_SIZE	256
+#define OUT_BUF_SIZE		256
+
+enum patch_state {
+	STATE_HDR,
+	STATE_OP,
+	STATE_OP_ARGS,
+	STATE_DIFF_CTRL,
+	STATE_DIFF_LITERAL,
+	STATE_INSERT,
+	STATE_DONE,
+	STATE_ERROR,
+};
+
+static struct {
+	enum patch_state state;
+	uint8_t op;
+
+	/* Accumulates fixed size fields that may be split between chunks. */
+	uint8_t args[DELTA_PATCH_HDR_SIZE];
+	size_t args_len;
+	size_t args_needed;
+
+	bool target_initialized;
+
+	uint32_t source_size;
+	uint32_t source_crc;
+	uint32_t target_size;
+	uint32_t target_crc;
+
+	/* Current operation. */
+	uint32_t src_offset;
+	uint32_t op_remaining;
+	uint32_t literal_remaining;
+
+	uint32_t written;
+	uint32_t crc;
+} patch;
+
+static const struct flash_area *source_fa;
+
+static uint8_t source_cache[SOURCE_CACHE_SIZE] __aligned(4);
+static uint32_t source_cache_base;
+static uint32_t source_cache_len;
+
+static uint8_t out_buf[OUT_BUF_SIZE] __aligned(4);
+static size_t out_len;
+
+static uint8_t dfu_buf[CONFIG_FOTA_MANAGER_DELTA_DFU_BUF_SIZE] __aligned(4);
+
+static void dfu_target_cb(enum dfu_target_evt_id evt)
+{
+	ARG_UNUSED(evt);
+}
+
+static int source_byte_get(uint32_t offset, uint8_t *byte)
+{
+	if ((offset < source_cache_base) || (offset >= (source_cache_base + source_cache_len))) {
+		uint32_t len = MIN(SOURCE_CACHE_SIZE, patch.source_size - offset);
+		int err = flash_area_read(source_fa, offset, source_cache, len);
+
+		if (err) {
+			LOG_ERR("flash_area_read, error: %d", err);
+			return err;
+		}
+
+		source_cache_base = offset;
+		source_cache_len = len;
+	}
+
+	*byte = source_cache[offset - source_cache_base];
+
+	return 0;
+}
+
+static int out_flush(void)
+{
+	int err;
+
+	if (out_len == 0) {
+		return 0;
+	}
+
+	err = dfu_target_write(out_buf, out_len);
+	if (err) {
+		LOG_ERR("dfu_target_write, error: %d", err);
+		return err;
+	}
+
+	out_len = 0;
+
+	return 0;
+}
+
+static int out_put(uint8_t byte)
+{
+	if (patch.written >= patch.target_size) {
+		LOG_ERR("Patch output exceeds target size");
+		return -EBADMSG;
+	}
+
+	patch.crc = crc32_ieee_update(patch.crc, &byte, 1);
+	patch.written++;
+	out_buf[out_len++] = byte;
+
+	return (out_len == sizeof(out_buf)) ? out_flush() : 0;
+}
+
+static int diff_byte_put(uint8_t diff)
+{
+	uint8_t src;
+	int err = source_byte_get(patch.src_offset, &src);
+
+	if (err) {
+		return err;
+	}
+
+	patch.src_offset++;
+	patch.op_remaining--;
+
+	return out_put(src + diff);
+}
+
+static int source_verify(void)
+{
+	uint32_t crc = 0;
+
+	if (patch.source_size > source_fa->fa_size) {
+		LOG_ERR("Patch source size %d exceeds primary slot", patch.source_size);
+		return -ENOEXEC;
+	}
+
+	for (uint32_t offset = 0; offset < patch.source_size; offset += sizeof(source_cache)) {
+		uint32_t len = MIN(sizeof(source_cache), patch.source_size - offset);
+		int err = flash_area_read(source_fa, offset, source_cache, len);
+
+		if (err) {
+			LOG_ERR("flash_area_read, error: %d", err);
+			return err;
+		}
+
+		crc = crc32_ieee_update(crc, source_cache, len);
+	}
+
+	/* Cache content is invalidated by the check. */
+	source_cache_len = 0;
+
+	if (crc != patch.source_crc) {
+		LOG_ERR("Patch is not made for the running image, CRC32 0x%08x, expected 0x%08x",
+			crc, patch.source_crc);
+		return -ENOEXEC;
+	}
+
+	return 0;
+}
+
+static int header_handle(void)
+{
+	int err;
+
+	if ((memcmp(patch.args, DELTA_PATCH_MAGIC, 4) != 0) ||
+	    (patch.args[4] != DELTA_PATCH_VERSION)) {
+		LOG_ERR("Invalid patch header");
+		return -EBADMSG;
+	}
+
+	patch.source_size = sys_get_le32(&patch.args[8]);
+	patch.source_crc = sys_get_le32(&patch.args[12]);
+	patch.target_size = sys_get_le32(&patch.args[16]);
+	patch.target_crc = sys_get_le32(&patch.args[20]);
+
+	err = source_verify();
+	if (err) {
+		return err;
+	}
+
+	err = dfu_target_mcuboot_set_buf(dfu_buf, sizeof(dfu_buf));
+	if (err) {
+		LOG_ERR("dfu_target_mcuboot_set_buf, error: %d", err);
+		return err;
+	}
+
+	err = dfu_target_init(DFU_TARGET_IMAGE_TYPE_MCUBOOT, 0, patch.target_size,
+			      dfu_target_cb);
+	if (err) {
+		LOG_ERR("dfu_target_init, error: %d", err);
+		return err;
+	}
+
+	/* A patch is always applied from the start, discard any progress saved by an
+	 * interrupted download of a full image.
+	 */
+	err = dfu_target_reset();
+	if (err) {
+		LOG_ERR("dfu_target_reset, error: %d", err);
+		return err;
+	}
+
+	err = dfu_target_init(DFU_TARGET_IMAGE_TYPE_MCUBOOT, 0, patch.target_size,
+			      dfu_target_cb);
+	if (err) {
+		LOG_ERR("dfu_target_init, error: %d", err);
+		return err;
+	}
+
+	patch.target_initialized = true;
+
+	LOG_INF("Applying patch, source: %d bytes, target: %d bytes",
+		patch.source_size, patch.target_size);
+
+	return 0;
+}
+
+static void args_expect(size_t len)
+{
+	patch.args_len = 0;
+	patch.args_needed = len;
+}
+
+static int op_args_handle(void)
+{
+	if (patch.op == DELTA_PATCH_OP_DIFF) {
+		patch.src_offset = sys_get_le32(&patch.args[0]);
+		patch.op_remaining = sys_get_le32(&patch.args[4]);
+
+		if ((patch.src_offset > patch.source_size) ||
+		    (patch.op_remaining > (patch.source_size - patch.src_offset))) {
+			LOG_ERR("DIFF operation outside of source image");
+			return -EBADMSG;
+		}
+
+		patch.state = STATE_DIFF_CTRL;
+	} else {
+		patch.op_remaining = sys_get_le32(&patch.args[0]);
+		patch.state = STATE_INSERT;
+	}
+
+	if (patch.op_remaining > (patch.target_size - patch.written)) {
+		LOG_ERR("Operation exceeds target size");
+		return -EBADMSG;
+	}
+
+	if (patch.op_remaining == 0) {
+		patch.state = STATE_OP;
+	}
+
+	return 0;
+}
+
+static int byte_handle(uint8_t byte)
+{
+	int err = 0;
+
+	switch (patch.state) {
+	case STATE_HDR:
+	case STATE_OP_ARGS:
+		patch.args[patch.args_len++] = byte;
+
+		if (patch.args_len < patch.args_needed) {
+			break;
+		}
+
+		if (patch.state == STATE_HDR) {
+			err = header_handle();
+			patch.state = STATE_OP;
+		} else {
+			err = op_args_handle();
+		}
+		break;
+	case STATE_OP:
+		if ((byte != DELTA_PATCH_OP_DIFF) && (byte != DELTA_PATCH_OP_INSERT)) {
+			LOG_ERR("Unknown patch operation 0x%02x", byte);
+			return -EBADMSG;
+		}
+
+		patch.op = byte;
+		patch.state = STATE_OP_ARGS;
+		args_expect((byte == DELTA_PATCH_OP_DIFF) ? 8 : 4);
+		break;
+	case STATE_DIFF_CTRL:
+		if (byte & BIT(7)) {
+			uint32_t zeros = (byte & 0x7F) + 1;
+
+			if (zeros > patch.op_remaining) {
+				return -EBADMSG;
+			}
+
+			while (zeros-- && !err) {
+				err = diff_byte_put(0);
+			}
+		} else {
+			patch.literal_remaining = byte + 1;
+
+			if (patch.literal_remaining > patch.op_remaining) {
+				return -EBADMSG;
+			}
+
+			patch.state = STATE_DIFF_LITERAL;
+		}
+
+		if (patch.op_remaining == 0) {
+			patch.state = STATE_OP;
+		}
+		break;
+	case STATE_DIFF_LITERAL:
+		err = diff_byte_put(byte);
+
+		if (--patch.literal_remaining == 0) {
+			patch.state = (patch.op_remaining == 0) ? STATE_OP : STATE_DIFF_CTRL;
+		}
+		break;
+	case STATE_INSERT:
+		err = out_put(byte);
+
+		if (--patch.op_remaining == 0) {
+			patch.state = STATE_OP;
+		}
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return err;
+}
+
+int delta_patch_init(void)
+{
+	int err;
+
+	if (source_fa == NULL) {
+		err = flash_area_open(PM_MCUBOOT_PRIMARY_ID, &source_fa);
+		if (err) {
+			LOG_ERR("flash_area_open, error: %d", err);
+			return err;
+		}
+	}
+
+	memset(&patch, 0, sizeof(patch));
+	patch.state = STATE_HDR;
+	args_expect(DELTA_PATCH_HDR_SIZE);
+
+	source_cache_len = 0;
+	out_len = 0;
+
+	return 0;
+}
+
+int delta_patch_write(const uint8_t *buf, size_t len)
+{
+	if (patch.state == STATE_ERROR) {
+		return -EBADMSG;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		int err = byte_handle(buf[i]);
+
+		if (err) {
+			patch.state = STATE_ERROR;
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+int delta_patch_done(bool successful)
+{
+	int err;
+
+	/* Nothing has been written to the secondary slot before the header is handled. */
+	if (!patch.target_initialized) {
+		patch.state = STATE_DONE;
+		return successful ? -EBADMSG : 0;
+	}
+
+	if (successful && (patch.state != STATE_OP)) {
+		LOG_ERR("Patch ended in the middle of an operation");
+		successful = false;
+	}
+
+	if (successful) {
+		err = out_flush();
+		if (err) {
+			successful = false;
+		}
+	}
+
+	if (successful && ((patch.written != patch.target_size) ||
+			   (patch.crc != patch.target_crc))) {
+		LOG_ERR("Rebuilt image mismatch, %d of %d bytes, CRC32 0x%08x, expected 0x%08x",
+			patch.written, patch.target_size, patch.crc, patch.target_crc);
+		successful = false;
+	}
+
+	patch.state = STATE_DONE;
+
+	if (!successful) {
+		(void)dfu_target_done(false);
+		(void)dfu_target_reset();
+		return -EBADMSG;
+	}
+
+	err = dfu_target_done(true);
+	if (err) {
+		LOG_ERR("dfu_target_done, error: %d", err);
+		return err;
+	}
+
+	err = dfu_target_schedule_update(0);
+	if (err) {
+		LOG_ERR("dfu_target_schedule_update, error: %d", err);
+		return err;
+	}
+
+	LOG_INF("Patch applied, %d bytes written", patch.written);
+
+	return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**@file
+ *
+ * @brief   Streaming delta patch applier for Asset Tracker v2
+ *
+ * Rebuilds a new application image into the MCUboot secondary slot from the image in the
+ * primary slot and a patch generated by scripts/delta_patch.py. The patch is consumed in
+ * arbitrarily sized chunks, so it can be fed directly from a download.
+ *
+ * Patch format, all integers little endian:
+ *
+ *  Header (24 bytes):
+ *  | magic "ATDP" (4) | version (1) | reserved (3) | source size (4) | source CRC32 (4) |
+ *  | target size (4) | target CRC32 (4) |
+ *
+ *  Followed by a sequence of operations:
+ *  | DELTA_PATCH_OP_DIFF (1) | source offset (4) | length (4) | encoded diff data |
+ *  | DELTA_PATCH_OP_INSERT (1) | length (4) | literal data (length) |
+ *
+ *  DIFF produces length bytes, each the sum modulo 256 of a source byte and a diff byte.
+ *  Diff bytes are run length encoded as a control byte followed by data: a control byte with
+ *  bit 7 set is a run of ((ctrl & 0x7F) + 1) zero bytes, otherwise it is followed by
+ *  (ctrl + 1) literal diff bytes.
+ */
+
+#ifndef DELTA_PATCH_H__
+#define DELTA_PATCH_H__
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DELTA_PATCH_MAGIC		"ATDP"
+#define DELTA_PATCH_VERSION		1
+#define DELTA_PATCH_HDR_SIZE		24
+
+#define DELTA_PATCH_OP_DIFF		0x01
+#define DELTA_PATCH_OP_INSERT		0x02
+
+/** @brief Prepare for a new patch. Any previously written data in the secondary slot is
+ *	   discarded once the patch header has been validated.
+ *
+ *  @return Zero on success, otherwise a negative error code is returned.
+ */
+int delta_patch_init(void);
+
+/** @brief Apply the next chunk of a patch.
+ *
+ *  @param[in] buf Patch data.
+ *  @param[in] len Length of patch data.
+ *
+ *  @return Zero on success, -ENOEXEC if the patch was not made for the image in the primary
+ *	    slot, otherwise a negative error code.
+ */
+int delta_patch_write(const uint8_t *buf, size_t len);
+
+/** @brief Finish patching. On success, the rebuilt image is verified and scheduled to be
+ *	   swapped in by MCUboot on the next reset.
+ *
+ *  @param[in] successful false to abort patching.
+ *
+ *  @return Zero on success, -EBADMSG if the rebuilt image does not match the patch,
+ *	    otherwise a negative error code.
+ */
+int delta_patch_done(bool successful);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DELTA_PATCH_H__ */
@@ -0,0 +1,531 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/crc.h>
+#include <net/fota_download.h>
+#include <dfu/dfu_target.h>
+#include <string.h>
+
+#include "fota_manager.h"
+
+#if defined(CONFIG_FOTA_MANAGER_DELTA)
+#include <net/download_client.h>
+#include "delta_patch.h"
+#endif /* CONFIG_FOTA_MANAGER_DELTA */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(fota_manager, CONFIG_FOTA_MANAGER_LOG_LEVEL);
+
+#define SETTINGS_KEY		"fota_mgr"
+#define SETTINGS_STATE_KEY	"state"
+
+/* Persisted download state. Identified by a checksum of the host and file name, so that the
+ * state of a previous job is not applied to a different image.
+ */
+struct job_state {
+	uint32_t job_id;
+	uint32_t offset;
+	uint32_t retries;
+	uint32_t elapsed_ms;
+};
+
+static fota_manager_evt_handler_t app_evt_handler;
+
+/* Updated from the download client thread and read from the system workqueue, protected by
+ * state_lock.
+ */
+static struct job_state state;
+static struct k_spinlock state_lock;
+static atomic_t busy;
+
+/* Per session bookkeeping. */
+static int64_t session_start;
+static uint32_t session_start_offset;
+static uint32_t session_elapsed_base;
+static uint32_t session_retries;
+static int last_checkpoint_percent;
+
+#if defined(CONFIG_FOTA_MANAGER_DELTA)
+static struct download_client dlc;
+/* Set while a delta patch is being applied, cleared when falling back to the full image. */
+static bool delta_mode;
+#endif /* CONFIG_FOTA_MANAGER_DELTA */
+
+static void start_work_fn(struct k_work *work);
+static void checkpoint_work_fn(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(start_work, start_work_fn);
+static K_WORK_DEFINE(checkpoint_work, checkpoint_work_fn);
+
+static int settings_handler(const char *key, size_t len, settings_read_cb read_cb,
+			    void *cb_arg);
+
+SETTINGS_STATIC_HANDLER_DEFINE(fota_manager, SETTINGS_KEY, NULL, settings_handler, NULL, NULL);
+
+static int settings_handler(const char *key, size_t len, settings_read_cb read_cb,
+			    void *cb_arg)
+{
+	if ((strcmp(key, SETTINGS_STATE_KEY) == 0) && (len == sizeof(state))) {
+		int err = read_cb(cb_arg, &state, sizeof(state));
+
+		if (err < 0) {
+			LOG_ERR("Failed to load download state, error: %d", err);
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+static uint32_t job_id_get(void)
+{
+	uint32_t crc = crc32_ieee((const uint8_t *)CONFIG_FOTA_MANAGER_HOST,
+				  strlen(CONFIG_FOTA_MANAGER_HOST));
+
+	return crc32_ieee_update(crc, (const uint8_t *)CONFIG_FOTA_MANAGER_FILE,
+				 strlen(CONFIG_FOTA_MANAGER_FILE));
+}
+
+static struct job_state state_get(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&state_lock);
+	struct job_state copy = state;
+
+	k_spin_unlock(&state_lock, key);
+
+	return copy;
+}
+
+static void metrics_get(struct fota_manager_metrics *metrics, int percent)
+{
+	struct job_state current = state_get();
+	uint32_t session_ms = (uint32_t)(k_uptime_get() - session_start);
+	uint32_t session_bytes = current.offset - session_start_offset;
+
+	metrics->offset = current.offset;
+	metrics->percent = percent;
+	metrics->bytes_per_sec = (session_ms > 0) ?
+				 (uint32_t)(((uint64_t)session_bytes * MSEC_PER_SEC) / session_ms) :
+				 0;
+	metrics->retries = current.retries;
+	metrics->elapsed_ms = session_elapsed_base + session_ms;
+}
+
+static void notify(enum fota_manager_evt_type type, int percent)
+{
+	struct fota_manager_evt evt = {
+		.type = type,
+	};
+
+	metrics_get(&evt.metrics, percent);
+
+	if (app_evt_handler != NULL) {
+		app_evt_handler(&evt);
+	}
+}
+
+static void checkpoint_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	struct job_state current = state_get();
+	int err = settings_save_one(SETTINGS_KEY "/" SETTINGS_STATE_KEY, &current,
+				    sizeof(current));
+
+	if (err) {
+		LOG_WRN("settings_save_one, error: %d", err);
+	}
+}
+
+static void checkpoint(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&state_lock);
+
+	state.elapsed_ms = session_elapsed_base + (uint32_t)(k_uptime_get() - session_start);
+	k_spin_unlock(&state_lock, key);
+
+	k_work_submit(&checkpoint_work);
+}
+
+static void offset_set(uint32_t offset)
+{
+	k_spinlock_key_t key = k_spin_lock(&state_lock);
+
+	state.offset = offset;
+	k_spin_unlock(&state_lock, key);
+}
+
+/* Count a retry of the download, returns the updated state. */
+static struct job_state retry_count(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&state_lock);
+	struct job_state copy;
+
+	state.retries++;
+	copy = state;
+	k_spin_unlock(&state_lock, key);
+
+	return copy;
+}
+
+/* The job is complete, the next start begins a new job. */
+static void state_clear(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&state_lock);
+
+	memset(&state, 0, sizeof(state));
+	k_spin_unlock(&state_lock, key);
+
+	k_work_submit(&checkpoint_work);
+}
+
+static void offset_update(void)
+{
+	size_t offset;
+
+	if (dfu_target_offset_get(&offset) == 0) {
+		offset_set(offset);
+	}
+}
+
+/* Called from the download client thread. */
+static void fota_dl_handler(const struct fota_download_evt *evt)
+{
+	switch (evt->id) {
+	case FOTA_DOWNLOAD_EVT_PROGRESS:
+		offset_update();
+
+		if ((evt->progress - last_checkpoint_percent) >=
+		    CONFIG_FOTA_MANAGER_CHECKPOINT_PERCENT) {
+			last_checkpoint_percent = evt->progress;
+			checkpoint();
+		}
+
+		notify(FOTA_MANAGER_EVT_PROGRESS, evt->progress);
+		break;
+	case FOTA_DOWNLOAD_EVT_ERROR: {
+		offset_update();
+
+		if (session_retries >= CONFIG_FOTA_MANAGER_RETRY_MAX) {
+			LOG_ERR("Download failed at offset %d, retries exhausted",
+				state_get().offset);
+			checkpoint();
+			notify(FOTA_MANAGER_EVT_ERROR, last_checkpoint_percent);
+			atomic_set(&busy, false);
+			break;
+		}
+
+		/* Exponential back-off, the download continues from the current offset. */
+		uint32_t delay = CONFIG_FOTA_MANAGER_RETRY_DELAY_SEC << MIN(session_retries, 5);
+		struct job_state current;
+
+		session_retries++;
+		current = retry_count();
+		checkpoint();
+
+		LOG_WRN("Download failed at offset %d, resuming in %d seconds",
+			current.offset, delay);
+
+		notify(FOTA_MANAGER_EVT_RETRY, last_checkpoint_percent);
+		k_work_reschedule(&start_work, K_SECONDS(delay));
+		break;
+	}
+	case FOTA_DOWNLOAD_EVT_FINISHED: {
+		offset_update();
+		notify(FOTA_MANAGER_EVT_FINISHED, 100);
+
+		struct job_state current = state_get();
+
+		LOG_INF("Download finished, %d bytes, %d retries, %d ms",
+			current.offset, current.retries,
+			session_elapsed_base + (uint32_t)(k_uptime_get() - session_start));
+
+		state_clear();
+		atomic_set(&busy, false);
+		break;
+	}
+	case FOTA_DOWNLOAD_EVT_CANCELLED:
+		checkpoint();
+		atomic_set(&busy, false);
+		break;
+	default:
+		break;
+	}
+}
+
+#if defined(CONFIG_FOTA_MANAGER_DELTA)
+/* Give up on the patch and download the full image instead. */
+static void delta_fallback(int err)
+{
+	LOG_WRN("Delta update failed, error: %d, falling back to full image", err);
+
+	delta_mode = false;
+	session_retries = 0;
+	last_checkpoint_percent = 0;
+	offset_set(0);
+
+	k_work_reschedule(&start_work, K_NO_WAIT);
+}
+
+/* Errors that retrying the patch download does not resolve. The download client reports
+ * HTTP responses other than 200 and 206, such as 404 for a missing patch, as -EBADMSG.
+ */
+static bool delta_error_permanent(int err)
+{
+	switch (err) {
+	case -ENOENT:
+	case -EACCES:
+	case -EBADMSG:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Called from the download client thread. */
+static int delta_dl_callback(const struct download_client_evt *event)
+{
+	int err;
+	size_t file_size = 0;
+	struct job_state current;
+	k_spinlock_key_t key;
+
+	switch (event->id) {
+	case DOWNLOAD_CLIENT_EVT_FRAGMENT:
+		err = delta_patch_write(event->fragment.buf, event->fragment.len);
+		if (err) {
+			(void)delta_patch_done(false);
+			(void)download_client_disconnect(&dlc);
+			delta_fallback(err);
+
+			/* Stop the download. */
+			return -1;
+		}
+
+		key = k_spin_lock(&state_lock);
+		state.offset += event->fragment.len;
+		current = state;
+		k_spin_unlock(&state_lock, key);
+
+		if ((download_client_file_size_get(&dlc, &file_size) == 0) && (file_size > 0)) {
+			notify(FOTA_MANAGER_EVT_PROGRESS,
+			       (int)(((uint64_t)current.offset * 100) / file_size));
+		}
+		break;
+	case DOWNLOAD_CLIENT_EVT_DONE:
+		(void)download_client_disconnect(&dlc);
+
+		err = delta_patch_done(true);
+		if (err) {
+			delta_fallback(err);
+			break;
+		}
+
+		notify(FOTA_MANAGER_EVT_FINISHED, 100);
+
+		current = state_get();
+		LOG_INF("Delta update finished, %d patch bytes, %d retries", current.offset,
+			current.retries);
+
+		state_clear();
+		atomic_set(&busy, false);
+		break;
+	case DOWNLOAD_CLIENT_EVT_ERROR:
+		(void)delta_patch_done(false);
+		(void)download_client_disconnect(&dlc);
+
+		if (delta_error_permanent(event->error) ||
+		    (session_retries >= CONFIG_FOTA_MANAGER_RETRY_MAX)) {
+			delta_fallback(event->error);
+			return -1;
+		}
+
+		/* Patches are small, a failed patch download is restarted from the start. */
+		uint32_t delay = CONFIG_FOTA_MANAGER_RETRY_DELAY_SEC << MIN(session_retries, 5);
+
+		session_retries++;
+		(void)retry_count();
+
+		LOG_WRN("Patch download failed, error: %d, restarting in %d seconds",
+			event->error, delay);
+
+		notify(FOTA_MANAGER_EVT_RETRY, 0);
+		offset_set(0);
+		k_work_reschedule(&start_work, K_SECONDS(delay));
+		return -1;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+static int delta_download_start(void)
+{
+	int err;
+	const struct download_client_cfg config = {
+		.sec_tag = CONFIG_FOTA_MANAGER_SEC_TAG,
+		.frag_size_override = CONFIG_FOTA_MANAGER_FRAGMENT_SIZE,
+	};
+
+	LOG_INF("Downloading patch %s from %s", CONFIG_FOTA_MANAGER_DELTA_FILE,
+		CONFIG_FOTA_MANAGER_HOST);
+
+	offset_set(0);
+	session_start_offset = 0;
+
+	err = delta_patch_init();
+	if (err) {
+		return err;
+	}
+
+	err = download_client_connect(&dlc, CONFIG_FOTA_MANAGER_HOST, &config);
+	if (err) {
+		LOG_ERR("download_client_connect, error: %d", err);
+		return err;
+	}
+
+	err = download_client_start(&dlc, CONFIG_FOTA_MANAGER_DELTA_FILE, 0);
+	if (err) {
+		LOG_ERR("download_client_start, error: %d", err);
+		(void)download_client_disconnect(&dlc);
+		return err;
+	}
+
+	return 0;
+}
+#endif /* CONFIG_FOTA_MANAGER_DELTA */
+
+static void start_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	/* Accumulate the time of the previous session before starting a new one. */
+	if (session_start != 0) {
+		session_elapsed_base += (uint32_t)(k_uptime_get() - session_start);
+	}
+
+	session_start = k_uptime_get();
+	session_start_offset = state_get().offset;
+
+#if defined(CONFIG_FOTA_MANAGER_DELTA)
+	if (delta_mode) {
+		int err = delta_download_start();
+
+		if (err) {
+			delta_fallback(err);
+		}
+
+		return;
+	}
+#endif /* CONFIG_FOTA_MANAGER_DELTA */
+
+	LOG_INF("Downloading %s from %s, offset: %d, fragment size: %d",
+		CONFIG_FOTA_MANAGER_FILE, CONFIG_FOTA_MANAGER_HOST, session_start_offset,
+		CONFIG_FOTA_MANAGER_FRAGMENT_SIZE);
+
+	/* The download library resumes from the offset stored by the DFU target, requesting
+	 * the remaining part of the image with HTTP range requests.
+	 */
+	int err = fota_download_start(CONFIG_FOTA_MANAGER_HOST, CONFIG_FOTA_MANAGER_FILE,
+				      CONFIG_FOTA_MANAGER_SEC_TAG, 0,
+				      CONFIG_FOTA_MANAGER_FRAGMENT_SIZE);
+
+	if (err) {
+		LOG_ERR("fota_download_start, error: %d", err);
+		notify(FOTA_MANAGER_EVT_ERROR, last_checkpoint_percent);
+		atomic_set(&busy, false);
+	}
+}
+
+int fota_manager_init(fota_manager_evt_handler_t evt_handler)
+{
+	int err;
+
+	app_evt_handler = evt_handler;
+
+#if defined(CONFIG_FOTA_MANAGER_DELTA)
+	err = download_client_init(&dlc, delta_dl_callback);
+	if (err) {
+		LOG_ERR("download_client_init, error: %d", err);
+		return err;
+	}
+#endif /* CONFIG_FOTA_MANAGER_DELTA */
+
+	err = settings_subsys_init();
+	if (err) {
+		LOG_ERR("settings_subsys_init, error: %d", err);
+		return err;
+	}
+
+	err = settings_load_subtree(SETTINGS_KEY);
+	if (err) {
+		LOG_ERR("settings_load_subtree, error: %d", err);
+		return err;
+	}
+
+	if (state.job_id == job_id_get() && state.offset > 0) {
+		LOG_INF("Interrupted download found, offset: %d, retries: %d",
+			state.offset, state.retries);
+	}
+
+	return 0;
+}
+
+int fota_manager_start(void)
+{
+	uint32_t job_id = job_id_get();
+	struct job_state current;
+	k_spinlock_key_t key;
+	int err;
+
+	if (!atomic_cas(&busy, false, true)) {
+		return -EBUSY;
+	}
+
+	/* The FOTA download library keeps a single callback, which the cloud FOTA libraries
+	 * replace with their own when they are initialized. Take it back for every job.
+	 */
+	err = fota_download_init(fota_dl_handler);
+	if (err) {
+		LOG_ERR("fota_download_init, error: %d", err);
+		atomic_set(&busy, false);
+		return err;
+	}
+
+	key = k_spin_lock(&state_lock);
+
+	if (state.job_id != job_id) {
+		memset(&state, 0, sizeof(state));
+		state.job_id = job_id;
+	}
+
+	current = state;
+	k_spin_unlock(&state_lock, key);
+
+	session_start = 0;
+	session_elapsed_base = current.elapsed_ms;
+	session_retries = 0;
+	last_checkpoint_percent = 0;
+
+#if defined(CONFIG_FOTA_MANAGER_DELTA)
+	/* A full image download that was interrupted is resumed rather than replaced by a
+	 * patch.
+	 */
+	delta_mode = (current.offset == 0);
+#endif /* CONFIG_FOTA_MANAGER_DELTA */
+
+	k_work_reschedule(&start_work, K_NO_WAIT);
+
+	return 0;
+}
+
+bool fota_manager_busy(void)
+{
+	return atomic_get(&busy);
+}
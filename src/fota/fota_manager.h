@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**@file
+ *
+ * @brief   Application FOTA manager for Asset Tracker v2
+ *
+ * Downloads the application image from the configured host using HTTP range requests of
+ * CONFIG_FOTA_MANAGER_FRAGMENT_SIZE bytes. The download offset is checkpointed to flash, so
+ * an interrupted download, either by a dropped connection or by a reset, continues from the
+ * last written offset instead of restarting the image.
+ */
+
+#ifndef FOTA_MANAGER_H__
+#define FOTA_MANAGER_H__
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum fota_manager_evt_type {
+	/** Download progress. */
+	FOTA_MANAGER_EVT_PROGRESS,
+	/** The download failed and is resumed after a back-off delay. */
+	FOTA_MANAGER_EVT_RETRY,
+	/** The image has been downloaded and is ready to be applied on the next reset. */
+	FOTA_MANAGER_EVT_FINISHED,
+	/** The download failed and all retries have been exhausted. */
+	FOTA_MANAGER_EVT_ERROR,
+};
+
+/** @brief Download metrics. Retries and elapsed time are accumulated over all sessions of
+ *	   the same job, including sessions before a reset.
+ */
+struct fota_manager_metrics {
+	/** Number of bytes of the image written to flash. */
+	uint32_t offset;
+	/** Download progress in percent. */
+	int percent;
+	/** Throughput of the current session in bytes per second. */
+	uint32_t bytes_per_sec;
+	/** Number of times the download has been resumed after an error. */
+	uint32_t retries;
+	/** Time spent downloading in milliseconds. For FOTA_MANAGER_EVT_FINISHED this is the
+	 *  time to complete.
+	 */
+	uint32_t elapsed_ms;
+};
+
+struct fota_manager_evt {
+	enum fota_manager_evt_type type;
+	struct fota_manager_metrics metrics;
+};
+
+/** @brief FOTA manager event handler.
+ *
+ *  @param[in] evt The event and any associated parameters.
+ */
+typedef void (*fota_manager_evt_handler_t)(const struct fota_manager_evt *evt);
+
+/** @brief Initialize the FOTA manager.
+ *
+ *  @param[in] evt_handler Event handler.
+ *
+ *  @return Zero on success, otherwise a negative error code is returned.
+ */
+int fota_manager_init(fota_manager_evt_handler_t evt_handler);
+
+/** @brief Start, or resume, the download of the configured image. The download is started
+ *	   from the system workqueue.
+ *
+ *  @return Zero on success, -EBUSY if a download is ongoing, otherwise a negative error code.
+ */
+int fota_manager_start(void);
+
+/** @brief Check whether a download is ongoing.
+ *
+ *  @return true if a download is ongoing, otherwise false.
+ */
+bool fota_manager_busy(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FOTA_MANAGER_H__ */
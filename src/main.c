@@ -13,6 +13,7 @@
 #include <modem/nrf_modem_lib.h>
 #endif /* CONFIG_NRF_MODEM_LIB */
 #include <zephyr/sys/reboot.h>
+#include <zephyr/sys/byteorder.h>
 #if defined(CONFIG_LWM2M_INTEGRATION)
 #include <net/lwm2m_client_utils.h>
 #endif /* CONFIG_LWM2M_INTEGRATION */
@@ -31,6 +32,8 @@
 #include <caf/events/module_state_event.h>
 
 #include "modules_common.h"
+#include "boot_init.h"
+#include "heap_tracker.h"
 #include "events/app_module_event.h"
 #include "events/cloud_module_event.h"
 #include "events/data_module_event.h"
@@ -47,6 +50,11 @@
 #include <zephyr/pm/device.h>
 
 #include "voltage-sensor.h"
+#include "battery_estimator.h"
+
+#if defined(CONFIG_RECORD_STORE)
+#include "record_store.h"
+#endif /* CONFIG_RECORD_STORE */
 
 // 判断电压表device tree node是否存在
 #if !DT_NODE_EXISTS(DT_PATH(my_voltage_sensor))|| \
@@ -56,10 +64,9 @@
 
 const struct device *voltage_sensor = DEVICE_DT_GET(DT_PATH(my_voltage_sensor));
 
-#include <zephyr/net/socket.h>
-static int client_fd;
-static struct sockaddr_storage host_addr;
-static bool connected_3rd_party = false;
+#if defined(CONFIG_SERVER_LINK)
+#include "server_link.h"
+#endif /* CONFIG_SERVER_LINK */
 
 LOG_MODULE_REGISTER(MODULE, CONFIG_APPLICATION_MODULE_LOG_LEVEL);
 
@@ -115,6 +122,11 @@ static bool sample_request_ongoing;
 /* Variable that is set high whenever the device is considered active (under movement). */
 static bool activity;
 
+/* Factor that sampling and publication intervals are multiplied with, raised when the battery
+ * is low.
+ */
+static uint8_t battery_interval_factor = 1;
+
 /* Timer callback used to signal when timeout has occurred both in active
  * and passive mode.
  */
@@ -161,6 +173,7 @@ static int modem_lib_init_result = -1;
 static void on_modem_lib_init(int ret, void *ctx)
 {
 	modem_lib_init_result = ret;
+	boot_stage_done(BOOT_STAGE_MODEM_LIB);
 }
 #endif /* CONFIG_NRF_MODEM_LIB */
 
@@ -349,35 +362,54 @@ static void data_sample_timer_handler(struct k_timer *timer)
 }
 
 /* Static module functions. */
-static void passive_mode_timers_start_all(void)
+/* Restart the passive mode timers that depend on the configuration fields flagged in
+ * changed, the others keep running.
+ */
+static void passive_mode_timers_start(uint32_t changed)
 {
+	uint32_t movement_resolution = app_cfg.movement_resolution * battery_interval_factor;
+	uint32_t movement_timeout = app_cfg.movement_timeout * battery_interval_factor;
+
 	LOG_DBG("Device mode: Passive");
-	LOG_DBG("Start movement timeout: %d seconds interval", app_cfg.movement_timeout);
 
-	LOG_DBG("%d seconds until movement can trigger a new data sample/publication",
-		app_cfg.movement_resolution);
+	if (changed & CLOUD_DATA_CFG_MOVEMENT_RESOLUTION) {
+		LOG_DBG("%d seconds until movement can trigger a new data sample/publication",
+			movement_resolution);
 
-	k_timer_start(&data_sample_timer,
-		      K_SECONDS(app_cfg.movement_resolution),
-		      K_SECONDS(app_cfg.movement_resolution));
+		k_timer_start(&data_sample_timer,
+			      K_SECONDS(movement_resolution),
+			      K_SECONDS(movement_resolution));
+
+		k_timer_start(&movement_resolution_timer,
+			      K_SECONDS(movement_resolution),
+			      K_SECONDS(0));
+	}
 
-	k_timer_start(&movement_resolution_timer,
-		      K_SECONDS(app_cfg.movement_resolution),
-		      K_SECONDS(0));
+	if (changed & CLOUD_DATA_CFG_MOVEMENT_TIMEOUT) {
+		LOG_DBG("Start movement timeout: %d seconds interval", movement_timeout);
+
+		k_timer_start(&movement_timeout_timer,
+			      K_SECONDS(movement_timeout),
+			      K_SECONDS(movement_timeout));
+	}
+}
 
-	k_timer_start(&movement_timeout_timer,
-		      K_SECONDS(app_cfg.movement_timeout),
-		      K_SECONDS(app_cfg.movement_timeout));
+static void passive_mode_timers_start_all(void)
+{
+	passive_mode_timers_start(CLOUD_DATA_CFG_MOVEMENT_RESOLUTION |
+				  CLOUD_DATA_CFG_MOVEMENT_TIMEOUT);
 }
 
 static void active_mode_timers_start_all(void)
 {
+	uint32_t active_wait_timeout = app_cfg.active_wait_timeout * battery_interval_factor;
+
 	LOG_DBG("Device mode: Active");
-	LOG_DBG("Start data sample timer: %d seconds interval", app_cfg.active_wait_timeout);
+	LOG_DBG("Start data sample timer: %d seconds interval", active_wait_timeout);
 
 	k_timer_start(&data_sample_timer,
-		      K_SECONDS(app_cfg.active_wait_timeout),
-		      K_SECONDS(app_cfg.active_wait_timeout));
+		      K_SECONDS(active_wait_timeout),
+		      K_SECONDS(active_wait_timeout));
 
 	k_timer_stop(&movement_resolution_timer);
 	k_timer_stop(&movement_timeout_timer);
@@ -478,6 +510,15 @@ static void on_state_init(struct app_msg_data *msg)
 
 static struct nvs_fs fs;
 
+static bool connected_3rd_party(void)
+{
+#if defined(CONFIG_SERVER_LINK)
+	return server_link_is_connected();
+#else
+	return false;
+#endif /* CONFIG_SERVER_LINK */
+}
+
 void my_nvs_init()
 {
     int rc = 0;
@@ -503,7 +544,28 @@ void my_nvs_init()
 		LOG_ERR("Flash init failed\n");
 		return;
 	}
+
+#if defined(CONFIG_RECORD_STORE)
+    rc = record_store_init(&fs);
+    if (rc) {
+        LOG_ERR("record_store_init, error: %d", rc);
+    }
+#endif /* CONFIG_RECORD_STORE */
+}
+
+#if defined(CONFIG_RECORD_STORE)
+/* Flush the buffered records. The record store is set up by a boot worker, nothing can be
+ * flushed before the storage stage is done.
+ */
+static int records_flush(void)
+{
+	if (!boot_stage_is_done(BOOT_STAGE_STORAGE)) {
+		return -EAGAIN;
+	}
+
+	return record_store_flush();
 }
+#endif /* CONFIG_RECORD_STORE */
 
 const struct spi_cs_control spi_cs = {
     .gpio = GPIO_DT_SPEC_GET(DT_NODELABEL(spi1), cs_gpios),
@@ -552,10 +614,68 @@ enum custom_cmd_t {
     SPIM_READ = 0x04,
     TWI_WRITE = 0x05,
     TWI_READ = 0x06,
+    /* [key][record data] */
+    FLASH_APPEND = 0x07,
+    /* [key][start index, 4 bytes big endian][record count] */
+    FLASH_READ_RANGE = 0x08,
+    FLASH_FLUSH = 0x09,
 };
 
 #define NVS_CUSTOM_CLOUD_DATA_ID 0x01
 
+#if defined(CONFIG_RECORD_STORE)
+/* Upper limit of the buffer allocated for a FLASH_READ_RANGE response. Responses are forwarded
+ * to the third party server as a single message, so they are limited to the payload size of
+ * the server link when it is enabled.
+ */
+#if defined(CONFIG_SERVER_LINK)
+#define FLASH_READ_RANGE_BUF_MAX MIN(512, CONFIG_SERVER_LINK_PAYLOAD_MAX)
+#else
+#define FLASH_READ_RANGE_BUF_MAX 512
+#endif /* CONFIG_SERVER_LINK */
+
+/* Number of FLASH_READ_RANGE responses that can be pending at the same time. A response
+ * buffer is owned by the QoS message of the response until the cloud has acknowledged it.
+ */
+#define FLASH_READ_RANGE_BUF_COUNT 2
+
+K_MEM_SLAB_DEFINE_STATIC(read_range_slab, FLASH_READ_RANGE_BUF_MAX,
+                         FLASH_READ_RANGE_BUF_COUNT, 4);
+
+static void read_range_buf_free(uint8_t *buf)
+{
+    k_mem_slab_free(&read_range_slab, (void **)&buf);
+}
+
+/* Submit a custom command response, and forward it to the third party server if connected.
+ * Ownership of buf, a buffer from read_range_slab, is passed on with the event.
+ */
+static void custom_cmd_response_submit(uint8_t *buf, size_t len)
+{
+    struct app_module_event *evt = new_app_module_event();
+
+    __ASSERT(evt, "Not enough heap left to allocate event");
+
+#if defined(CONFIG_SERVER_LINK)
+    /* The server link copies the message into its own transmit buffers. */
+    if (connected_3rd_party() && (buf != NULL)) {
+        int err = server_link_send(buf, len);
+
+        if (err) {
+            LOG_WRN("server_link_send, error: %d", err);
+        }
+    }
+#endif /* CONFIG_SERVER_LINK */
+
+    evt->data.custom_cmd.buf = buf;
+    evt->data.custom_cmd.len = (buf != NULL) ? len : 0;
+    evt->data.custom_cmd.is_allocated = (buf != NULL);
+    evt->data.custom_cmd.release = (buf != NULL) ? read_range_buf_free : NULL;
+    evt->type = APP_EVT_CUSTOM_CLOUD_CMD_READY;
+    APP_EVENT_SUBMIT(evt);
+}
+#endif /* CONFIG_RECORD_STORE */
+
 /* 自定义云端命令处理函数*/
 static void on_cloud_custom_cmd(struct app_msg_data *msg)
 {
@@ -569,12 +689,19 @@ static void on_cloud_custom_cmd(struct app_msg_data *msg)
     case FLASH_WRITE:
     case SPIM_WRITE:
     case TWI_WRITE:
+    case FLASH_APPEND:
+    case FLASH_READ_RANGE:
         if (len != command->len - 2) {
             LOG_WRN("write len is not match! paylod_len=%d, len=%d", command->len - 2, len);
         }
         break;
     }
 
+    if (!boot_stage_is_done(BOOT_STAGE_STORAGE) || !boot_stage_is_done(BOOT_STAGE_PERIPHERALS)) {
+        LOG_WRN("Storage and peripherals are not initialized yet, command 0x%02x dropped", cmd);
+        goto free_ptr;
+    }
+
     switch(cmd) {
     case FLASH_WRITE:{
         LOG_HEXDUMP_INF(data, len, "flash write: ");
@@ -600,7 +727,7 @@ static void on_cloud_custom_cmd(struct app_msg_data *msg)
             evt->data.custom_cmd.len = 0;
             evt->data.custom_cmd.is_allocated = false;
         } else {
-            uint8_t *buf = k_malloc(len);
+            uint8_t *buf = heap_tracker_alloc(HEAP_TAG_CUSTOM_CMD, len);
             if ( buf == NULL){
                 LOG_WRN("read flash malloc failed!");
                 goto free_ptr;
@@ -608,7 +735,7 @@ static void on_cloud_custom_cmd(struct app_msg_data *msg)
             int rc = nvs_read(&fs, NVS_CUSTOM_CLOUD_DATA_ID, buf, len);
             if (rc < 0) {
                 LOG_WRN("read flash failed!, rc = %d", rc);
-                k_free(buf);
+                heap_tracker_free(buf);
                 evt->data.custom_cmd.buf = NULL;
                 evt->data.custom_cmd.len = 0;
                 evt->data.custom_cmd.is_allocated = false;
@@ -619,12 +746,13 @@ static void on_cloud_custom_cmd(struct app_msg_data *msg)
                 evt->data.custom_cmd.is_allocated = true;
             }
         }
+        evt->data.custom_cmd.release = NULL;
         evt->type = APP_EVT_CUSTOM_CLOUD_CMD_READY;
         APP_EVENT_SUBMIT(evt);
 
-        if(connected_3rd_party) {
+        if(connected_3rd_party()) {
             struct app_module_event *evt2 = new_app_module_event();
-            uint8_t *buf = k_malloc(len);
+            uint8_t *buf = heap_tracker_alloc(HEAP_TAG_CUSTOM_CMD, len);
             if ( buf == NULL){
                 LOG_WRN("read flash malloc failed!");
                 goto free_ptr;
@@ -639,6 +767,70 @@ static void on_cloud_custom_cmd(struct app_msg_data *msg)
 
         goto free_ptr;
     }
+#if defined(CONFIG_RECORD_STORE)
+    case FLASH_APPEND:{
+        if (len < 2) {
+            LOG_WRN("flash append: no record data");
+            goto free_ptr;
+        }
+
+        int idx = record_store_append(data[0], &data[1], len - 1);
+        if (idx >= 0) {
+            LOG_INF("flash append success, key=%d, index=%d", data[0], idx);
+        } else {
+            LOG_WRN("flash append failed!, rc=%d", idx);
+        }
+        goto free_ptr;
+    }
+
+    case FLASH_READ_RANGE:{
+        if (len < 6) {
+            LOG_WRN("flash read range: invalid request length %d", len);
+            custom_cmd_response_submit(NULL, 0);
+            goto free_ptr;
+        }
+
+        uint8_t key = data[0];
+        uint32_t start = sys_get_be32(&data[1]);
+        uint8_t count = data[5];
+        size_t buf_len = MIN(count * (CONFIG_RECORD_STORE_RECORD_SIZE_MAX +
+                                      RECORD_STORE_RECORD_HDR_SIZE),
+                             FLASH_READ_RANGE_BUF_MAX);
+        uint8_t *buf;
+
+        if (buf_len == 0) {
+            LOG_WRN("flash read range: no records requested");
+            custom_cmd_response_submit(NULL, 0);
+            goto free_ptr;
+        }
+
+        if (k_mem_slab_alloc(&read_range_slab, (void **)&buf, K_NO_WAIT)) {
+            LOG_WRN("flash read range: all response buffers are in use");
+            custom_cmd_response_submit(NULL, 0);
+            goto free_ptr;
+        }
+
+        int rc = record_store_read_range(key, start, count, buf, buf_len);
+        if (rc <= 0) {
+            LOG_WRN("flash read range: no records read, rc=%d", rc);
+            read_range_buf_free(buf);
+            custom_cmd_response_submit(NULL, 0);
+        } else {
+            LOG_HEXDUMP_INF(buf, rc, "flash read range success:");
+            custom_cmd_response_submit(buf, rc);
+        }
+        goto free_ptr;
+    }
+
+    case FLASH_FLUSH:{
+        int rc = records_flush();
+        if (rc) {
+            LOG_WRN("flash flush failed!, rc=%d", rc);
+        }
+        goto free_ptr;
+    }
+#endif /* CONFIG_RECORD_STORE */
+
     case SPIM_WRITE:{
         LOG_HEXDUMP_INF(data, len, "spim write: ");
         // 直接把完整指令+数据发送到从机，由从机处理写入或读出
@@ -691,7 +883,7 @@ static void on_cloud_custom_cmd(struct app_msg_data *msg)
                 evt->data.custom_cmd.is_allocated = false;
             } else {
                 LOG_HEXDUMP_INF(spi_buffer.buf, spi_buffer.len, "spi read success:");
-                evt->data.custom_cmd.buf = k_malloc(len);
+                evt->data.custom_cmd.buf = heap_tracker_alloc(HEAP_TAG_CUSTOM_CMD, len);
                 if ( evt->data.custom_cmd.buf == NULL){
                     LOG_WRN("read flash malloc failed!");
                     goto free_ptr;
@@ -700,12 +892,13 @@ static void on_cloud_custom_cmd(struct app_msg_data *msg)
                 evt->data.custom_cmd.len = len;
                 evt->data.custom_cmd.is_allocated = true;
             }
+            evt->data.custom_cmd.release = NULL;
             evt->type = APP_EVT_CUSTOM_CLOUD_CMD_READY;
             APP_EVENT_SUBMIT(evt);
 
-            if(connected_3rd_party) {
+            if(connected_3rd_party()) {
                 struct app_module_event *evt2 = new_app_module_event();
-                uint8_t *buf = k_malloc(len);
+                uint8_t *buf = heap_tracker_alloc(HEAP_TAG_CUSTOM_CMD, len);
                 if ( buf == NULL){
                     LOG_WRN("read flash malloc failed!");
                     goto free_ptr;
@@ -744,7 +937,7 @@ static void on_cloud_custom_cmd(struct app_msg_data *msg)
             evt->data.custom_cmd.len = 0;
             evt->data.custom_cmd.is_allocated = false;
         } else {
-            uint8_t* buf = k_malloc(len);
+            uint8_t* buf = heap_tracker_alloc(HEAP_TAG_CUSTOM_CMD, len);
             if ( buf == NULL){
                 LOG_WRN("read flash malloc failed!");
                 goto free_ptr;
@@ -752,7 +945,7 @@ static void on_cloud_custom_cmd(struct app_msg_data *msg)
             int rc = i2c_read(twi_dev, buf, len, I2C_ADDR);
             if (rc < 0) {
                 LOG_WRN("read i2c failed!, rc=%d", rc);
-                k_free(buf);
+                heap_tracker_free(buf);
                 evt->data.custom_cmd.buf = NULL;
                 evt->data.custom_cmd.len = 0;
                 evt->data.custom_cmd.is_allocated = false;
@@ -763,12 +956,13 @@ static void on_cloud_custom_cmd(struct app_msg_data *msg)
                 evt->data.custom_cmd.is_allocated = true;
             }
         }
+        evt->data.custom_cmd.release = NULL;
         evt->type = APP_EVT_CUSTOM_CLOUD_CMD_READY;
         APP_EVENT_SUBMIT(evt);
 
-        if(connected_3rd_party) {
+        if(connected_3rd_party()) {
             struct app_module_event *evt2 = new_app_module_event();
-            uint8_t *buf = k_malloc(len);
+            uint8_t *buf = heap_tracker_alloc(HEAP_TAG_CUSTOM_CMD, len);
             if ( buf == NULL){
                 LOG_WRN("read flash malloc failed!");
                 goto free_ptr;
@@ -789,154 +983,146 @@ static void on_cloud_custom_cmd(struct app_msg_data *msg)
 
 free_ptr:         
     if(command->is_allocated){
-        k_free(command->ptr);
+        if (command->release != NULL) {
+            command->release(command->ptr);
+        } else {
+            heap_tracker_free(command->ptr);
+        }
     }
 }
 
 // added by jayant
-#include <zephyr/dfu/mcuboot.h>
-#include <dfu/dfu_target_mcuboot.h>
-#include <net/fota_download.h>
-
-static struct k_work fota_work;
-static bool fota_lock = false;
-
-#define SEG_TAG -1
+#if defined(CONFIG_FOTA_MANAGER)
+#include "fota_manager.h"
 
-static void fota_dl_handler(const struct fota_download_evt *evt)
+static void fota_manager_evt_handler(const struct fota_manager_evt *evt)
 {
-	switch (evt->id) {
-	case FOTA_DOWNLOAD_EVT_ERROR:
-		LOG_ERR("Received error from fota_download\n");
-		fota_lock = false;
+	const struct fota_manager_metrics *m = &evt->metrics;
+
+	switch (evt->type) {
+	case FOTA_MANAGER_EVT_PROGRESS:
+		LOG_INF("FOTA progress: %d%%, offset: %d, %d bytes/s",
+			m->percent, m->offset, m->bytes_per_sec);
 		break;
 
-	case FOTA_DOWNLOAD_EVT_FINISHED:
-		LOG_INF("Press 'Reset' button to apply new firmware\n");
-        fota_lock = false;
+	case FOTA_MANAGER_EVT_RETRY:
+		LOG_WRN("FOTA download interrupted at offset %d, retry %d",
+			m->offset, m->retries);
 		break;
 
-	default:
+	case FOTA_MANAGER_EVT_ERROR:
+		LOG_ERR("FOTA download failed at offset %d after %d retries",
+			m->offset, m->retries);
 		break;
-	}
-}
 
-static void fota_work_cb(struct k_work *work)
-{
-	ARG_UNUSED(work);
+	case FOTA_MANAGER_EVT_FINISHED:
+		LOG_INF("FOTA finished: %d bytes in %d ms, %d retries",
+			m->offset, m->elapsed_ms, m->retries);
+		LOG_INF("Press 'Reset' button to apply new firmware");
+		break;
 
-	int err = fota_download_start("182.61.144.86:50002", "app_update_jayant.bin", SEG_TAG, 0, 0);
-	if (err != 0) {
-		LOG_ERR("fota_download_start() failed, err %d\n", err);
+	default:
+		break;
 	}
 }
+#endif /* CONFIG_FOTA_MANAGER */
 
-static void recv_packet(void)
+#if defined(CONFIG_SERVER_LINK)
+/* Called from the server link thread. Commands received from the server are handled the
+ * same way as custom commands received from the cloud.
+ */
+static void server_link_evt_handler(const struct server_link_evt *evt)
 {
-    int received_len;
-    int buf[20] = {0};
-	while (1) {
-        LOG_INF("Waiting for packets ...");
-		received_len = recv(client_fd, buf, sizeof(buf), 0);
-		if (received_len < 0) {
-            LOG_ERR("Failed to recv packets");
-			return;
-		}
-        LOG_HEXDUMP_INF(buf, received_len, "Received from William's Server:");
+    switch (evt->type) {
+    case SERVER_LINK_EVT_CONNECTED:
+        LOG_INF("Connected to William's Server");
+        break;
+    case SERVER_LINK_EVT_DISCONNECTED:
+        LOG_WRN("Disconnected from William's Server, err: %d", evt->err);
+        break;
+    case SERVER_LINK_EVT_TX_DROPPED:
+        LOG_WRN("Message to William's Server dropped, err: %d", evt->err);
+        break;
+    case SERVER_LINK_EVT_DATA_RECEIVED: {
+        LOG_HEXDUMP_INF(evt->data.buf, evt->data.len, "Received from William's Server:");
 
-        struct cloud_module_event *cloud_evt = new_cloud_module_event(); 
+        struct cloud_module_event *cloud_evt = new_cloud_module_event();
         __ASSERT(cloud_evt, "Not enough heap left to allocate event");
-        cloud_evt->data.custom_cmd.ptr = k_malloc(received_len);
-        if (NULL == cloud_evt->data.custom_cmd.ptr) {
-            LOG_WRN("k_malloc failed");
-            return;
-        }
-        memcpy(cloud_evt->data.custom_cmd.ptr, buf, received_len);
-        cloud_evt->data.custom_cmd.len = received_len;
-        cloud_evt->data.custom_cmd.is_allocated = true; // 用于指示此内存是需要释放的
+
+        /* The pooled receive buffer is passed on with the event. */
+        cloud_evt->data.custom_cmd.ptr = evt->data.buf;
+        cloud_evt->data.custom_cmd.len = evt->data.len;
+        cloud_evt->data.custom_cmd.is_allocated = true;
+        cloud_evt->data.custom_cmd.release = server_link_rx_buf_free;
 
         cloud_evt->type = CLOUD_EVT_CUSTOM_CMD;
         APP_EVENT_SUBMIT(cloud_evt);
-	}
+        break;
+    }
+    default:
+        break;
+    }
 }
-
-K_THREAD_DEFINE(receiver_thread_id, 1024,
-		recv_packet, NULL, NULL, NULL,
-		K_PRIO_PREEMPT(8), 0, -1);
+#endif /* CONFIG_SERVER_LINK */
 
 // FOTA triggered by button 1
-// UDP socket opened by button 2
+// Third party server link opened by button 2
 static void on_my_button_pressed(struct app_msg_data *msg)
 {
     struct ui_module_data *evt_data = &(msg->module.ui.data.ui);
     
+#if defined(CONFIG_FOTA_MANAGER)
     // refuse button event when already in FOTA progress
-    if (fota_lock) {
+    if (fota_manager_busy()) {
         LOG_INF("FOTA is in progress, please wait!");
         return;
     }
+#endif /* CONFIG_FOTA_MANAGER */
     
     // Button 1
     if(evt_data->button_number == 1) {
-        // start FOTA
-        fota_lock = true;
-        int err = fota_download_init(fota_dl_handler);
-        if (err != 0) {
-            LOG_ERR("fota_download_init() failed, err %d\n", err);
-            fota_lock = false;
+#if defined(CONFIG_FOTA_MANAGER)
+        // the FOTA manager is initialized by a boot worker after the settings are loaded
+        if (!boot_stage_is_done(BOOT_STAGE_FOTA)) {
+            LOG_WRN("FOTA manager is not initialized yet, button press ignored");
             return;
         }
-        
-        // add a new thread to start fota,
-        // prevent blocking the main thread
-        k_work_init(&fota_work, fota_work_cb);
-        k_work_submit(&fota_work);
 
+        // start or resume FOTA, the download runs outside of the main thread
+        int err = fota_manager_start();
+        if (err != 0) {
+            LOG_ERR("fota_manager_start() failed, err %d", err);
+        }
+#else
+        LOG_INF("FOTA manager is disabled");
+#endif /* CONFIG_FOTA_MANAGER */
     } 
     
-    // Button 2; enable socket
+    // Button 2; open link to the third party server
     else if (evt_data->button_number == 2) {
-
-        static bool first_press = true;
-        if(!first_press){
-            LOG_INF("Press Button 2 more than once is not supported, Socket already opened!");
+#if defined(CONFIG_SERVER_LINK)
+        if (server_link_is_connected()) {
+            LOG_INF("Link to William's Server already opened!");
             return;
         }
-        first_press = false;
 
-        struct sockaddr_in *server4 = ((struct sockaddr_in *)&host_addr);
-
-#define USE_UDP 1 // set 0 to use tcp
-
-        server4->sin_family = AF_INET;
-        server4->sin_port = htons( USE_UDP ? 50001 : 50000);
-
-        inet_pton(AF_INET, "182.61.144.86",&server4->sin_addr);
-
-#ifdef USE_UDP
-        client_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-#else
-        client_fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-#endif
-
-        if (client_fd < 0) {
-            LOG_ERR("Failed to create %s socket", USE_UDP ? "UDP" : "TCP");
-            return;
-	    }
-        
-        int err = connect(client_fd, (struct sockaddr *)&host_addr,
-		      sizeof(struct sockaddr_in));
-        if (err < 0) {
-		    LOG_ERR("Connect to server failed : %d\n", errno);
+        int err = server_link_connect(server_link_evt_handler);
+        if (err) {
+            LOG_ERR("server_link_connect, error: %d", err);
             return;
-	    }
-
-        connected_3rd_party = true;
+        }
 
-        send(client_fd, "Hello from Jayant\n", sizeof("Hello from Jayant\n"), 0);
-        LOG_INF("Send Hello from Jayant to William's Server");
-        k_thread_start(receiver_thread_id);
+        static const char hello[] = "Hello from Jayant\n";
 
+        err = server_link_send((const uint8_t *)hello, sizeof(hello));
+        if (err) {
+            LOG_WRN("server_link_send, error: %d", err);
+        } else {
+            LOG_INF("Send Hello from Jayant to William's Server");
+        }
+#else
+        LOG_INF("Third party server link is disabled");
+#endif /* CONFIG_SERVER_LINK */
     }
 }
 
@@ -965,9 +1151,14 @@ static void on_state_running(struct app_msg_data *msg)
     // send data to william's server
     if (IS_EVENT(msg, app, APP_EVT_SEND_TO_WILLIAMS_SERVER)) {
         struct app_module_custom_cloud_cmd_data *cmd = &(msg->module.app.data.custom_cmd);
-        send(client_fd, cmd->buf, cmd->len, 0);
+#if defined(CONFIG_SERVER_LINK)
+        int err = server_link_send(cmd->buf, cmd->len);
+        if (err) {
+            LOG_WRN("server_link_send, error: %d", err);
+        }
+#endif /* CONFIG_SERVER_LINK */
         if (cmd->is_allocated) {
-             k_free(cmd->buf);
+             heap_tracker_free(cmd->buf);
         }
     }
 }
@@ -985,7 +1176,7 @@ void on_sub_state_passive(struct app_msg_data *msg)
 			return;
 		}
 
-		passive_mode_timers_start_all();
+		passive_mode_timers_start(msg->module.data.data.cfg_changed);
 	}
 
 	if ((IS_EVENT(msg, sensor, SENSOR_EVT_MOVEMENT_ACTIVITY_DETECTED)) ||
@@ -1007,7 +1198,63 @@ static void on_sub_state_active(struct app_msg_data *msg)
 			return;
 		}
 
+		if (msg->module.data.data.cfg_changed & CLOUD_DATA_CFG_ACTIVE_WAIT_TIMEOUT) {
+			active_mode_timers_start_all();
+		}
+	}
+}
+
+/* Called from the system workqueue when the voltage sensor has finished a reading. */
+static void battery_sampled(int32_t volt_mv, void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	if (volt_mv < 0) {
+		SEND_EVENT(app, APP_EVT_BATTERY_DATA_NOT_READY);
+		return;
+	}
+
+	struct app_module_event *evt = new_app_module_event();
+	struct battery_estimate estimate;
+
+	__ASSERT(evt, "Not enough heap left to allocate event");
+	evt->type = APP_EVT_BATTERY_DATA_READY;
+	evt->data.bat.vdd_mv = volt_mv;
+	evt->data.bat.timestamp = k_uptime_get();
+
+	battery_estimator_update(evt->data.bat.vdd_mv, evt->data.bat.timestamp, &estimate);
+	evt->data.bat.soc = estimate.soc;
+	evt->data.bat.remaining_h = estimate.remaining_h;
+	evt->data.bat.has_estimate = IS_ENABLED(CONFIG_BATTERY_ESTIMATOR);
+	evt->data.bat.publish = estimate.publish;
+	APP_EVENT_SUBMIT(evt);
+}
+
+static void on_battery_data_ready(const struct app_module_bat_data *bat)
+{
+	uint8_t factor;
+
+	if (!bat->has_estimate) {
+		return;
+	}
+
+	factor = battery_estimator_interval_factor(bat->soc);
+	if (factor == battery_interval_factor) {
+		return;
+	}
+
+	LOG_INF("Battery at %d %%, sampling interval factor %d -> %d", bat->soc,
+		battery_interval_factor, factor);
+	battery_interval_factor = factor;
+
+	if (state != STATE_RUNNING) {
+		return;
+	}
+
+	if (app_cfg.active_mode) {
 		active_mode_timers_start_all();
+	} else {
+		passive_mode_timers_start_all();
 	}
 }
 
@@ -1019,6 +1266,10 @@ static void on_all_events(struct app_msg_data *msg)
 		k_timer_stop(&movement_timeout_timer);
 		k_timer_stop(&movement_resolution_timer);
 
+#if defined(CONFIG_RECORD_STORE)
+		(void)records_flush();
+#endif /* CONFIG_RECORD_STORE */
+
 		SEND_SHUTDOWN_ACK(app, APP_EVT_SHUTDOWN_READY, self.id);
 		state_set(STATE_SHUTDOWN);
 	}
@@ -1036,22 +1287,20 @@ static void on_all_events(struct app_msg_data *msg)
             if (APP_DATA_BATTERY == msg->module.app.data_list[i]) {
                 
                 const struct voltage_sensor_api *api = (const struct voltage_sensor_api*)voltage_sensor->api;
-                int32_t volt_vdd = api->voltage_get();
-                
-                if (-1 == volt_vdd) {
+                int err = api->voltage_get_async(battery_sampled, NULL);
+
+                if (err) {
+                    LOG_WRN("Battery sampling not started, error: %d", err);
                     SEND_EVENT(app, APP_EVT_BATTERY_DATA_NOT_READY);
-                } else {
-                    struct app_module_event *evt = new_app_module_event();
-                    __ASSERT(evt, "Not enough heap left to allocate event");
-                    evt->type = APP_EVT_BATTERY_DATA_READY;
-                    evt->data.bat.vdd_mv = volt_vdd;
-                    evt->data.bat.timestamp = k_uptime_get();
-                    APP_EVENT_SUBMIT(evt);
                 }
             }
         }
 	}
 
+	if (IS_EVENT(msg, app, APP_EVT_BATTERY_DATA_READY)) {
+		on_battery_data_ready(&msg->module.app.data.bat);
+	}
+
 	if (IS_EVENT(msg, data, DATA_EVT_DATA_READY)) {
 		sample_request_ongoing = false;
 	}
@@ -1061,10 +1310,51 @@ static void on_all_events(struct app_msg_data *msg)
 	}
 }
 
+static int storage_init(void)
+{
+	my_nvs_init();
+	return 0;
+}
+
+static int peripherals_init(void)
+{
+	my_spi_init();
+	my_twi_init();
+	return 0;
+}
+
+#if defined(CONFIG_FOTA_MANAGER)
+static int fota_init(void)
+{
+	return fota_manager_init(fota_manager_evt_handler);
+}
+#endif /* CONFIG_FOTA_MANAGER */
+
+/* Setup steps that are independent of the application message loop. They are run on worker
+ * threads so that the main thread can start handling messages, and the module threads can
+ * start the LTE attach, without waiting for flash to be mounted.
+ */
+static const struct boot_init_step boot_steps[] = {
+	{ .name = "storage", .stage = BOOT_STAGE_STORAGE, .fn = storage_init },
+	{ .name = "peripherals", .stage = BOOT_STAGE_PERIPHERALS, .fn = peripherals_init },
+#if defined(CONFIG_FOTA_MANAGER)
+	/* The FOTA manager shares the settings subsystem with the data module. */
+	{
+		.name = "fota",
+		.stage = BOOT_STAGE_FOTA,
+		.depends = BIT(BOOT_STAGE_SETTINGS),
+		.fn = fota_init
+	},
+#endif /* CONFIG_FOTA_MANAGER */
+};
+
 void main(void)
 {
 	int err;
 	struct app_msg_data msg = { 0 };
+
+	boot_stage_done(BOOT_STAGE_MAIN);
+
 	if (!IS_ENABLED(CONFIG_LWM2M_CARRIER)) {
 		handle_nrf_modem_lib_init_ret();
 	}
@@ -1083,9 +1373,10 @@ void main(void)
 
 	self.thread_id = k_current_get();
 
-    my_nvs_init();
-    my_spi_init();
-    my_twi_init();
+	err = boot_init_run(boot_steps, ARRAY_SIZE(boot_steps));
+	if (err) {
+		LOG_ERR("boot_init_run, error: %d", err);
+	}
 
 	err = module_start(&self);
 	if (err) {
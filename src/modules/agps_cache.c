@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <string.h>
+#include <net/nrf_cloud_agps.h>
+
+#include "agps_cache.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(agps_cache, CONFIG_DATA_MODULE_LOG_LEVEL);
+
+/* Data types that stay valid for hours and are cached. */
+#define CACHEABLE_FLAGS (NRF_MODEM_GNSS_AGPS_GPS_UTC_REQUEST |	\
+			 NRF_MODEM_GNSS_AGPS_KLOBUCHAR_REQUEST |	\
+			 NRF_MODEM_GNSS_AGPS_NEQUICK_REQUEST)
+
+static struct {
+	/* A-GPS data in nRF Cloud binary format. */
+	uint8_t buf[CONFIG_DATA_AGPS_CACHE_SIZE];
+	size_t len;
+	/* Data types contained in buf. */
+	struct nrf_modem_gnss_agps_data_frame content;
+	/* Uptime when buf was stored. */
+	int64_t uptime;
+	/* Whether the GNSS module has requested assistance since buf was stored. */
+	bool used;
+
+	/* Request sent to cloud that has not been answered yet. */
+	struct nrf_modem_gnss_agps_data_frame in_flight;
+	int64_t in_flight_uptime;
+	bool in_flight_valid;
+
+	/* Data types to request once the request in flight has been answered. */
+	struct nrf_modem_gnss_agps_data_frame deferred;
+
+	/* Statistics. */
+	uint32_t bytes_downloaded;
+	uint32_t bytes_from_cache;
+} cache;
+
+static K_MUTEX_DEFINE(cache_lock);
+
+static bool request_empty(const struct nrf_modem_gnss_agps_data_frame *request)
+{
+	return (request->sv_mask_ephe == 0) && (request->sv_mask_alm == 0) &&
+	       (request->data_flags == 0);
+}
+
+static bool request_cacheable(const struct nrf_modem_gnss_agps_data_frame *request)
+{
+	return (request->sv_mask_ephe != 0) || (request->sv_mask_alm != 0) ||
+	       (request->data_flags & CACHEABLE_FLAGS);
+}
+
+static bool request_time_sensitive(const struct nrf_modem_gnss_agps_data_frame *request)
+{
+	return request->data_flags & ~CACHEABLE_FLAGS;
+}
+
+static void request_merge(struct nrf_modem_gnss_agps_data_frame *dst,
+			  const struct nrf_modem_gnss_agps_data_frame *src)
+{
+	dst->sv_mask_ephe |= src->sv_mask_ephe;
+	dst->sv_mask_alm |= src->sv_mask_alm;
+	dst->data_flags |= src->data_flags;
+}
+
+static void request_remove(struct nrf_modem_gnss_agps_data_frame *dst,
+			   const struct nrf_modem_gnss_agps_data_frame *src)
+{
+	dst->sv_mask_ephe &= ~src->sv_mask_ephe;
+	dst->sv_mask_alm &= ~src->sv_mask_alm;
+	dst->data_flags &= ~src->data_flags;
+}
+
+static bool request_covers(const struct nrf_modem_gnss_agps_data_frame *outer,
+			   const struct nrf_modem_gnss_agps_data_frame *inner)
+{
+	return ((inner->sv_mask_ephe & ~outer->sv_mask_ephe) == 0) &&
+	       ((inner->sv_mask_alm & ~outer->sv_mask_alm) == 0) &&
+	       ((inner->data_flags & ~outer->data_flags) == 0);
+}
+
+/* Ephemerides are valid for a few hours, the other cached data types much longer. */
+static int64_t content_max_age_ms(void)
+{
+	if (cache.content.sv_mask_ephe) {
+		return CONFIG_DATA_AGPS_CACHE_EPHEMERIS_MAX_AGE_SEC * MSEC_PER_SEC;
+	}
+
+	return CONFIG_DATA_AGPS_CACHE_MAX_AGE_SEC * MSEC_PER_SEC;
+}
+
+static int64_t content_age_ms(void)
+{
+	return k_uptime_get() - cache.uptime;
+}
+
+static bool in_flight_get(void)
+{
+	if (cache.in_flight_valid &&
+	    (k_uptime_get() - cache.in_flight_uptime) >=
+	    (CONFIG_DATA_AGPS_CACHE_REQUEST_TIMEOUT_SEC * MSEC_PER_SEC)) {
+		LOG_WRN("A-GPS request timed out");
+		cache.in_flight_valid = false;
+	}
+
+	return cache.in_flight_valid;
+}
+
+static void cached_data_write(struct nrf_modem_gnss_agps_data_frame *request)
+{
+	struct nrf_modem_gnss_agps_data_frame cacheable = {
+		.sv_mask_ephe = request->sv_mask_ephe,
+		.sv_mask_alm = request->sv_mask_alm,
+		.data_flags = request->data_flags & CACHEABLE_FLAGS,
+	};
+	int err;
+
+	if ((cache.len == 0) || !request_cacheable(&cacheable) ||
+	    !request_covers(&cache.content, &cacheable) ||
+	    (content_age_ms() >= content_max_age_ms())) {
+		return;
+	}
+
+	err = nrf_cloud_agps_process(cache.buf, cache.len);
+	if (err) {
+		LOG_WRN("Writing cached A-GPS data failed, error: %d", err);
+		return;
+	}
+
+	cache.bytes_from_cache += cache.len;
+	request_remove(request, &cache.content);
+
+	LOG_DBG("Cached A-GPS data written, age: %lld s", content_age_ms() / MSEC_PER_SEC);
+	LOG_DBG("A-GPS bytes downloaded: %d, written from cache: %d",
+		cache.bytes_downloaded, cache.bytes_from_cache);
+}
+
+bool agps_cache_request_prepare(struct nrf_modem_gnss_agps_data_frame *request)
+{
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	cache.used = true;
+
+	cached_data_write(request);
+
+	if (in_flight_get()) {
+		request_remove(request, &cache.in_flight);
+		request_merge(&cache.deferred, request);
+		*request = (struct nrf_modem_gnss_agps_data_frame){ 0 };
+	} else if (request_cacheable(request) && request_time_sensitive(request)) {
+		/* Time-sensitive data types are requested after the cacheable ones have been
+		 * received, so that the response to this request can be cached as a whole.
+		 */
+		cache.deferred.data_flags |= request->data_flags & ~CACHEABLE_FLAGS;
+		request->data_flags &= CACHEABLE_FLAGS;
+	}
+
+	k_mutex_unlock(&cache_lock);
+
+	return !request_empty(request);
+}
+
+void agps_cache_request_sent(const struct nrf_modem_gnss_agps_data_frame *request)
+{
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	cache.in_flight = *request;
+	cache.in_flight_uptime = k_uptime_get();
+	cache.in_flight_valid = true;
+
+	k_mutex_unlock(&cache_lock);
+}
+
+void agps_cache_response_store(const uint8_t *buf, size_t len)
+{
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	cache.bytes_downloaded += len;
+
+	if (!cache.in_flight_valid) {
+		LOG_DBG("Unsolicited A-GPS data, not cached");
+		goto exit;
+	}
+
+	cache.in_flight_valid = false;
+
+	if (!request_cacheable(&cache.in_flight) || request_time_sensitive(&cache.in_flight)) {
+		goto exit;
+	}
+
+	if (len > sizeof(cache.buf)) {
+		LOG_WRN("A-GPS data too large to be cached: %zu bytes", len);
+		goto exit;
+	}
+
+	memcpy(cache.buf, buf, len);
+	cache.len = len;
+	cache.content = cache.in_flight;
+	cache.uptime = k_uptime_get();
+	cache.used = false;
+
+	LOG_DBG("A-GPS data cached, %zu bytes", len);
+
+exit:
+	k_mutex_unlock(&cache_lock);
+}
+
+bool agps_cache_deferred_get(struct nrf_modem_gnss_agps_data_frame *request)
+{
+	bool pending = false;
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	if (!in_flight_get() && !request_empty(&cache.deferred)) {
+		*request = cache.deferred;
+		cache.deferred = (struct nrf_modem_gnss_agps_data_frame){ 0 };
+		pending = true;
+	}
+
+	k_mutex_unlock(&cache_lock);
+
+	return pending;
+}
+
+bool agps_cache_prefetch_get(struct nrf_modem_gnss_agps_data_frame *request)
+{
+	bool prefetch = false;
+	int64_t age;
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	if ((cache.len == 0) || !cache.used || in_flight_get()) {
+		goto exit;
+	}
+
+	age = content_age_ms();
+
+	if ((age < content_max_age_ms()) &&
+	    (age >= content_max_age_ms() -
+		    (CONFIG_DATA_AGPS_CACHE_PREFETCH_MARGIN_SEC * MSEC_PER_SEC))) {
+		*request = cache.content;
+		prefetch = true;
+	}
+
+exit:
+	k_mutex_unlock(&cache_lock);
+
+	return prefetch;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _AGPS_CACHE_H_
+#define _AGPS_CACHE_H_
+
+/**@file
+ *@brief Local A-GPS assistance cache, used by the data and cloud modules.
+ *
+ * Ephemerides, almanacs, UTC parameters and ionospheric corrections received from cloud are kept
+ * together with the time they were received, and are written to the GNSS module again when it
+ * requests them while they are still valid. Time and position assistance is never cached.
+ * Requests for time-insensitive and time-sensitive data are sent separately so that a response
+ * can be cached as a whole, and only one request is in flight at any time.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <nrf_modem_gnss.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Prepare an A-GPS request from the GNSS module before it is sent to cloud.
+ *
+ *  Assistance that is available in the cache is written to the GNSS module and removed from
+ *  the request, as is assistance that has already been requested from cloud. If a request is
+ *  in flight, or if the request mixes cacheable and time-sensitive data, (part of) the request
+ *  is deferred and can be retrieved with agps_cache_deferred_get() once the request in flight
+ *  has been answered.
+ *
+ *  @param[in, out] request A-GPS data types requested by the GNSS module. On return, the data
+ *			    types that must be requested from cloud now.
+ *
+ *  @return true if the request must be sent to cloud, false if nothing is left to request.
+ */
+bool agps_cache_request_prepare(struct nrf_modem_gnss_agps_data_frame *request);
+
+/** @brief Register that a request has been sent to cloud.
+ *
+ *  @param[in] request A-GPS data types that were requested.
+ */
+void agps_cache_request_sent(const struct nrf_modem_gnss_agps_data_frame *request);
+
+/** @brief Store A-GPS data received from cloud, after it has been processed successfully.
+ *
+ *  The data is cached if it answers a request for cacheable data types only.
+ *
+ *  @param[in] buf A-GPS data in nRF Cloud binary format.
+ *  @param[in] len Length of the data.
+ */
+void agps_cache_response_store(const uint8_t *buf, size_t len);
+
+/** @brief Get the deferred part of earlier requests.
+ *
+ *  @param[out] request A-GPS data types to request.
+ *
+ *  @return true if there is a deferred request and no request is in flight.
+ */
+bool agps_cache_deferred_get(struct nrf_modem_gnss_agps_data_frame *request);
+
+/** @brief Check whether the cached data is about to expire and should be refreshed.
+ *
+ *  Refreshing is only suggested if the GNSS module has requested assistance since the data was
+ *  stored, so that the cache is not kept up to date on a device that no longer uses GNSS.
+ *
+ *  @param[out] request A-GPS data types to request.
+ *
+ *  @return true if the cache should be refreshed.
+ */
+bool agps_cache_prefetch_get(struct nrf_modem_gnss_agps_data_frame *request);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AGPS_CACHE_H_ */
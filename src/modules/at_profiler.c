@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <string.h>
+
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#if defined(CONFIG_MEMFAULT)
+#include <memfault/metrics/metrics.h>
+#endif
+
+#include "at_profiler.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(at_profiler, CONFIG_MODEM_MODULE_LOG_LEVEL);
+
+/* Upper bounds of the histogram buckets in milliseconds, the last bucket has no upper bound. */
+static const uint16_t bucket_limits_ms[] = { 5, 10, 20, 50, 100, 200, 500, 1000 };
+
+#define BUCKET_COUNT (ARRAY_SIZE(bucket_limits_ms) + 1)
+
+static struct at_profile {
+	const char *name;
+	uint32_t count;
+	uint32_t total_us;
+	uint32_t max_us;
+	uint32_t buckets[BUCKET_COUNT];
+} profiles[CONFIG_MODEM_AT_PROFILER_COMMANDS_MAX];
+
+static struct k_spinlock lock;
+
+static struct at_profile *profile_get(const char *name)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(profiles); i++) {
+		if (profiles[i].name == NULL) {
+			profiles[i].name = name;
+			return &profiles[i];
+		}
+
+		if (strcmp(profiles[i].name, name) == 0) {
+			return &profiles[i];
+		}
+	}
+
+	return NULL;
+}
+
+static size_t bucket_get(uint32_t duration_us)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(bucket_limits_ms); i++) {
+		if (duration_us < bucket_limits_ms[i] * USEC_PER_MSEC) {
+			break;
+		}
+	}
+
+	return i;
+}
+
+void at_profiler_stop(const char *name, uint32_t start)
+{
+	uint32_t duration_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+	struct at_profile *profile;
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	profile = profile_get(name);
+	if (profile != NULL) {
+		profile->count++;
+		profile->total_us += duration_us;
+		profile->max_us = MAX(profile->max_us, duration_us);
+		profile->buckets[bucket_get(duration_us)]++;
+	}
+
+	k_spin_unlock(&lock, key);
+
+	if (profile == NULL) {
+		LOG_WRN("No room to profile %s, increase CONFIG_MODEM_AT_PROFILER_COMMANDS_MAX",
+			name);
+	}
+
+	if (duration_us >= CONFIG_MODEM_AT_PROFILER_SLOW_THRESHOLD_MS * USEC_PER_MSEC) {
+		LOG_WRN("%s took %d ms", name, duration_us / USEC_PER_MSEC);
+	} else {
+		LOG_DBG("%s took %d us", name, duration_us);
+	}
+
+#if defined(CONFIG_MEMFAULT)
+	memfault_metrics_heartbeat_add(MEMFAULT_METRICS_KEY(ModemAtCommands), 1);
+	memfault_metrics_heartbeat_add(MEMFAULT_METRICS_KEY(ModemAtLatencyTotalMs),
+				       duration_us / USEC_PER_MSEC);
+
+	if (duration_us >= CONFIG_MODEM_AT_PROFILER_SLOW_THRESHOLD_MS * USEC_PER_MSEC) {
+		memfault_metrics_heartbeat_add(MEMFAULT_METRICS_KEY(ModemAtSlowCommands), 1);
+	}
+#endif
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_at_profiler(const struct shell *shell, size_t argc, char **argv)
+{
+	struct at_profile snapshot[ARRAY_SIZE(profiles)];
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	memcpy(snapshot, profiles, sizeof(snapshot));
+	k_spin_unlock(&lock, key);
+
+	shell_print(shell, "%-12s %6s %8s %8s  histogram (<5 <10 <20 <50 <100 <200 <500 <1000 "
+		    ">=1000 ms)", "command", "count", "avg ms", "max ms");
+
+	for (size_t i = 0; i < ARRAY_SIZE(snapshot) && snapshot[i].name != NULL; i++) {
+		const struct at_profile *profile = &snapshot[i];
+		char histogram[BUCKET_COUNT * sizeof(" 4294967295")];
+		int len = 0;
+
+		for (size_t j = 0; j < BUCKET_COUNT; j++) {
+			len += snprintk(&histogram[len], sizeof(histogram) - len, " %d",
+					profile->buckets[j]);
+		}
+
+		shell_print(shell, "%-12s %6d %8d %8d %s", profile->name, profile->count,
+			    profile->total_us / profile->count / USEC_PER_MSEC,
+			    profile->max_us / USEC_PER_MSEC, histogram);
+	}
+
+	return 0;
+}
+
+SHELL_CMD_REGISTER(at_profiler, NULL, "Print AT command latency histograms", cmd_at_profiler);
+#endif /* CONFIG_SHELL */
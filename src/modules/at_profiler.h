@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _AT_PROFILER_H_
+#define _AT_PROFILER_H_
+
+/**@file
+ *@brief AT command latency profiler, used by the modem module.
+ *
+ * Keeps a latency histogram for each profiled AT command. The histograms can be printed with
+ * the "at_profiler" shell command, and totals are reported as Memfault metrics.
+ */
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(CONFIG_MODEM_AT_PROFILER)
+
+/** @brief Start timing an AT command.
+ *
+ *  @return Start time to pass to at_profiler_stop().
+ */
+static inline uint32_t at_profiler_start(void)
+{
+	return k_cycle_get_32();
+}
+
+/** @brief Stop timing an AT command and record the latency.
+ *
+ *  @param[in] name Name of the command. The string is referenced, not copied, and must
+ *		    remain valid.
+ *  @param[in] start Value returned by at_profiler_start().
+ */
+void at_profiler_stop(const char *name, uint32_t start);
+
+#else
+
+static inline uint32_t at_profiler_start(void)
+{
+	return 0;
+}
+
+static inline void at_profiler_stop(const char *name, uint32_t start)
+{
+	ARG_UNUSED(name);
+	ARG_UNUSED(start);
+}
+
+#endif /* CONFIG_MODEM_AT_PROFILER */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AT_PROFILER_H_ */
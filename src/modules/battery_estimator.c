@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <stdlib.h>
+
+#include "battery_estimator.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(battery_estimator, CONFIG_APPLICATION_MODULE_LOG_LEVEL);
+
+BUILD_ASSERT(CONFIG_BATTERY_ESTIMATOR_FULL_MV > CONFIG_BATTERY_ESTIMATOR_EMPTY_MV,
+	     "Full battery voltage must be above the empty voltage");
+
+/* Discharge rates are kept in 1/100 per mille of charge per hour. */
+#define RATE_SCALE		100
+#define RATE_WINDOW_MS	(CONFIG_BATTERY_ESTIMATOR_RATE_WINDOW_MIN * 60LL * MSEC_PER_SEC)
+#define PUBLISH_MAX_INTERVAL_MS	(CONFIG_BATTERY_ESTIMATOR_PUBLISH_MAX_INTERVAL_H * \
+				 MSEC_PER_SEC * 3600LL)
+
+/* Smallest change in state of charge, in per mille, that ends a discharge rate window. Smaller
+ * changes are within the noise of the voltage readings, the window is kept open until the
+ * change is large enough to give a meaningful rate.
+ */
+#define RATE_DROP_MIN		10
+
+/* Open-circuit discharge curve of a Li-ion cell. Voltages are in per mille of the range between
+ * the empty and the full voltage, state of charge is in per mille.
+ */
+static const struct {
+	uint16_t voltage;
+	uint16_t soc;
+} curve[] = {
+	{ 0, 0 }, { 250, 50 }, { 400, 100 }, { 533, 200 }, { 600, 300 }, { 650, 400 },
+	{ 700, 500 }, { 758, 600 }, { 817, 700 }, { 883, 800 }, { 942, 900 }, { 1000, 1000 },
+};
+
+static struct {
+	bool valid;
+
+	/* Start of the current discharge rate window. */
+	uint16_t window_soc;
+	int64_t window_ts;
+
+	/* Smoothed discharge rate, 0 until the charge has dropped over a full window. */
+	uint32_t rate;
+
+	/* Last published estimate. */
+	bool published_valid;
+	struct battery_estimate published;
+	int64_t published_ts;
+} state;
+
+/* State of charge in per mille. */
+static uint16_t soc_get(uint16_t vdd_mv)
+{
+	int32_t mv = vdd_mv + CONFIG_BATTERY_ESTIMATOR_LOAD_DROP_MV;
+	int32_t v = (mv - CONFIG_BATTERY_ESTIMATOR_EMPTY_MV) * 1000 /
+		    (CONFIG_BATTERY_ESTIMATOR_FULL_MV - CONFIG_BATTERY_ESTIMATOR_EMPTY_MV);
+
+	if (v <= 0) {
+		return 0;
+	}
+
+	for (size_t i = 1; i < ARRAY_SIZE(curve); i++) {
+		if (v <= curve[i].voltage) {
+			return curve[i - 1].soc + (v - curve[i - 1].voltage) *
+			       (curve[i].soc - curve[i - 1].soc) /
+			       (curve[i].voltage - curve[i - 1].voltage);
+		}
+	}
+
+	return 1000;
+}
+
+static void rate_update(uint16_t soc, int64_t timestamp)
+{
+	int64_t elapsed = timestamp - state.window_ts;
+	int32_t drop = state.window_soc - soc;
+	uint32_t rate;
+
+	if (elapsed < RATE_WINDOW_MS) {
+		return;
+	}
+
+	if (drop <= -RATE_DROP_MIN) {
+		/* Charged or replaced, the old rate does not apply any more. */
+		LOG_DBG("Battery state of charge increased, discharge rate reset");
+		state.rate = 0;
+	} else if (drop < RATE_DROP_MIN) {
+		return;
+	} else {
+		rate = (uint32_t)((int64_t)drop * RATE_SCALE * MSEC_PER_SEC * 3600 / elapsed);
+		state.rate = state.rate ? (3 * state.rate + rate) / 4 : rate;
+	}
+
+	state.window_soc = soc;
+	state.window_ts = timestamp;
+}
+
+static bool publish_needed(const struct battery_estimate *estimate, int64_t timestamp)
+{
+	const struct battery_estimate *last = &state.published;
+
+	if (!state.published_valid ||
+	    (timestamp - state.published_ts >= PUBLISH_MAX_INTERVAL_MS)) {
+		return true;
+	}
+
+	if (abs(estimate->soc - last->soc) >= CONFIG_BATTERY_ESTIMATOR_SOC_THRESHOLD) {
+		return true;
+	}
+
+	if ((estimate->remaining_h != 0) != (last->remaining_h != 0)) {
+		return true;
+	}
+
+	if (last->remaining_h == 0) {
+		return false;
+	}
+
+	return abs(estimate->remaining_h - last->remaining_h) * 100 >=
+	       last->remaining_h * CONFIG_BATTERY_ESTIMATOR_LIFE_THRESHOLD_PERCENT;
+}
+
+void battery_estimator_update(uint16_t vdd_mv, int64_t timestamp,
+			      struct battery_estimate *estimate)
+{
+	uint16_t soc = soc_get(vdd_mv);
+
+	if (!state.valid) {
+		state.valid = true;
+		state.window_soc = soc;
+		state.window_ts = timestamp;
+	} else {
+		rate_update(soc, timestamp);
+	}
+
+	estimate->soc = (soc + 5) / 10;
+	estimate->remaining_h = 0;
+
+	if (state.rate) {
+		estimate->remaining_h = MIN((uint32_t)soc * RATE_SCALE / state.rate, UINT16_MAX);
+	}
+
+	estimate->publish = publish_needed(estimate, timestamp);
+	if (estimate->publish) {
+		state.published_valid = true;
+		state.published = *estimate;
+		state.published_ts = timestamp;
+	}
+
+	LOG_DBG("Battery: %d mV, %d %%, %d h remaining%s", vdd_mv, estimate->soc,
+		estimate->remaining_h, estimate->publish ? ", publish" : "");
+}
+
+uint8_t battery_estimator_interval_factor(uint8_t soc)
+{
+	if (soc <= CONFIG_BATTERY_ESTIMATOR_CRITICAL_SOC) {
+		return 4;
+	} else if (soc <= CONFIG_BATTERY_ESTIMATOR_LOW_SOC) {
+		return 2;
+	}
+
+	return 1;
+}
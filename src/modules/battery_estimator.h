@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _BATTERY_ESTIMATOR_H_
+#define _BATTERY_ESTIMATOR_H_
+
+/**@file
+ *@brief Battery state-of-charge and discharge-rate estimator, fed with voltage readings.
+ *
+ * The voltage measured under load is compensated for the load drop and mapped to a state of
+ * charge on a Li-ion discharge curve scaled between CONFIG_BATTERY_ESTIMATOR_EMPTY_MV and
+ * CONFIG_BATTERY_ESTIMATOR_FULL_MV. The discharge rate is measured over windows of
+ * CONFIG_BATTERY_ESTIMATOR_RATE_WINDOW_MIN and smoothed, and gives the remaining battery life.
+ * A reading is only flagged for publishing when the estimate has changed by a threshold.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Battery estimate. */
+struct battery_estimate {
+	/** State of charge in percent. */
+	uint8_t soc;
+	/** Remaining battery life in hours, 0 while unknown, that is until the state of charge
+	 *  has dropped by at least 1 % since start-up or the last charge.
+	 */
+	uint16_t remaining_h;
+	/** Set if the estimate has changed enough since it was last published. */
+	bool publish;
+};
+
+#if defined(CONFIG_BATTERY_ESTIMATOR)
+
+/** @brief Update the estimate with a new voltage reading. Not thread safe, readings must be
+ *	   passed from a single context.
+ *
+ *  @param[in] vdd_mv Battery voltage in millivolts.
+ *  @param[in] timestamp Uptime of the reading in milliseconds.
+ *  @param[out] estimate Updated estimate.
+ */
+void battery_estimator_update(uint16_t vdd_mv, int64_t timestamp,
+			      struct battery_estimate *estimate);
+
+/** @brief Get the factor that sampling and publication intervals are multiplied with.
+ *
+ *  @param[in] soc State of charge in percent.
+ *
+ *  @return 1 above CONFIG_BATTERY_ESTIMATOR_LOW_SOC, 2 at or below it, 4 at or below
+ *	    CONFIG_BATTERY_ESTIMATOR_CRITICAL_SOC.
+ */
+uint8_t battery_estimator_interval_factor(uint8_t soc);
+
+#else
+
+static inline void battery_estimator_update(uint16_t vdd_mv, int64_t timestamp,
+					    struct battery_estimate *estimate)
+{
+	estimate->soc = 0;
+	estimate->remaining_h = 0;
+	estimate->publish = true;
+}
+
+static inline uint8_t battery_estimator_interval_factor(uint8_t soc)
+{
+	return 1;
+}
+
+#endif /* CONFIG_BATTERY_ESTIMATOR */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BATTERY_ESTIMATOR_H_ */
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/sys/crc.h>
+#include <string.h>
+
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#include "boot_init.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(boot_init, CONFIG_MODULES_COMMON_LOG_LEVEL);
+
+BUILD_ASSERT(BOOT_STAGE_COUNT <= 32, "Boot stages must fit in a 32-bit mask");
+
+static const char * const stage_names[] = {
+	[BOOT_STAGE_KERNEL] = "kernel",
+	[BOOT_STAGE_MODEM_LIB] = "modem_lib",
+	[BOOT_STAGE_MAIN] = "main",
+	[BOOT_STAGE_STORAGE] = "storage",
+	[BOOT_STAGE_PERIPHERALS] = "peripherals",
+	[BOOT_STAGE_WATCHDOG] = "watchdog",
+	[BOOT_STAGE_SETTINGS] = "settings",
+	[BOOT_STAGE_SENSORS] = "sensors",
+	[BOOT_STAGE_FOTA] = "fota",
+	[BOOT_STAGE_MODEM] = "modem",
+	[BOOT_STAGE_LTE_CONNECTING] = "lte_connecting",
+	[BOOT_STAGE_LTE_CONNECTED] = "lte_connected",
+	[BOOT_STAGE_CLOUD_CONNECTED] = "cloud_connected",
+	[BOOT_STAGE_FIRST_PUBLISH] = "first_publish",
+};
+
+BUILD_ASSERT(ARRAY_SIZE(stage_names) == BOOT_STAGE_COUNT, "Missing boot stage name");
+
+#define BOOT_HISTORY_MAGIC		0x42544c31 /* "BTL1" */
+#define BOOT_MODULE_NAME_LEN		8
+
+/* Timeline of a single boot. Times are in microseconds of uptime. */
+struct boot_record {
+	uint32_t boot_id;
+	uint32_t stages_done;
+	uint32_t stage_us[BOOT_STAGE_COUNT];
+	uint32_t module_count;
+	struct {
+		char name[BOOT_MODULE_NAME_LEN];
+		uint32_t us;
+	} modules[CONFIG_BOOT_INIT_MODULES_MAX];
+};
+
+/* Ring of the last boots. It is placed in RAM that is not cleared at startup, so that it
+ * survives soft resets, and is protected by a CRC so that it is discarded after a power cycle.
+ */
+struct boot_history {
+	uint32_t magic;
+	uint32_t next_boot_id;
+	uint32_t head;
+	uint32_t count;
+	struct boot_record records[CONFIG_BOOT_INIT_HISTORY];
+	uint32_t crc;
+};
+
+static __noinit struct boot_history history;
+static struct boot_record *current;
+static struct k_spinlock lock;
+
+/* Posted once for each stage that is done, steps wait on it for their dependencies. */
+static K_EVENT_DEFINE(stage_events);
+
+static K_THREAD_STACK_ARRAY_DEFINE(worker_stacks, CONFIG_BOOT_INIT_WORKERS,
+				   CONFIG_BOOT_INIT_WORKER_STACK_SIZE);
+static struct k_thread workers[CONFIG_BOOT_INIT_WORKERS];
+
+static const struct boot_init_step *steps_pending;
+static size_t steps_pending_count;
+static atomic_t step_next;
+static atomic_t run_started;
+
+static uint32_t history_crc(void)
+{
+	return crc32_ieee((uint8_t *)&history, offsetof(struct boot_history, crc));
+}
+
+static uint32_t uptime_us(void)
+{
+	/* The kernel tick is the RTC, which is also the cycle counter on nRF91. */
+	return (uint32_t)MIN(k_ticks_to_us_floor64(k_uptime_ticks()), UINT32_MAX);
+}
+
+static void timeline_print(const struct boot_record *record)
+{
+	for (size_t i = 0; i < BOOT_STAGE_COUNT; i++) {
+		if (record->stages_done & BIT(i)) {
+			LOG_INF("%-16s %9d us", stage_names[i], record->stage_us[i]);
+		} else {
+			LOG_INF("%-16s not reached", stage_names[i]);
+		}
+	}
+}
+
+void boot_stage_done(enum boot_stage stage)
+{
+	uint32_t now = uptime_us();
+	k_spinlock_key_t key;
+
+	__ASSERT_NO_MSG(stage < BOOT_STAGE_COUNT);
+
+	key = k_spin_lock(&lock);
+
+	if (current->stages_done & BIT(stage)) {
+		k_spin_unlock(&lock, key);
+		return;
+	}
+
+	current->stage_us[stage] = now;
+	current->stages_done |= BIT(stage);
+	history.crc = history_crc();
+
+	k_spin_unlock(&lock, key);
+
+	k_event_post(&stage_events, BIT(stage));
+
+	LOG_DBG("Boot stage %s done after %d us", stage_names[stage], now);
+
+	if (stage == BOOT_STAGE_FIRST_PUBLISH) {
+		timeline_print(current);
+	}
+}
+
+void boot_module_started(const char *name)
+{
+	uint32_t now = uptime_us();
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (current->module_count < ARRAY_SIZE(current->modules)) {
+		uint32_t i = current->module_count++;
+
+		strncpy(current->modules[i].name, name, sizeof(current->modules[i].name));
+		current->modules[i].us = now;
+		history.crc = history_crc();
+	}
+
+	k_spin_unlock(&lock, key);
+}
+
+bool boot_stage_is_done(enum boot_stage stage)
+{
+	return (current->stages_done & BIT(stage)) != 0;
+}
+
+int64_t boot_stage_time_get(enum boot_stage stage)
+{
+	if (!boot_stage_is_done(stage)) {
+		return -ENODATA;
+	}
+
+	return current->stage_us[stage];
+}
+
+static void worker_fn(void *arg1, void *arg2, void *arg3)
+{
+	ARG_UNUSED(arg1);
+	ARG_UNUSED(arg2);
+	ARG_UNUSED(arg3);
+
+	size_t i;
+
+	while ((i = atomic_inc(&step_next)) < steps_pending_count) {
+		const struct boot_init_step *step = &steps_pending[i];
+		int64_t start;
+		int err;
+
+		if (step->depends &&
+		    !k_event_wait_all(&stage_events, step->depends, false,
+				      K_SECONDS(CONFIG_BOOT_INIT_STEP_WAIT_TIMEOUT_SEC))) {
+			LOG_WRN("Dependencies of %s not done in time, running anyway", step->name);
+		}
+
+		start = k_uptime_get();
+		err = step->fn();
+		if (err) {
+			LOG_ERR("Setup step %s failed, error: %d", step->name, err);
+		}
+
+		LOG_DBG("Setup step %s took %d ms", step->name, (int)(k_uptime_get() - start));
+		boot_stage_done(step->stage);
+	}
+}
+
+int boot_init_run(const struct boot_init_step *steps, size_t count)
+{
+	if (atomic_set(&run_started, 1)) {
+		return -EALREADY;
+	}
+
+	steps_pending = steps;
+	steps_pending_count = count;
+
+	for (size_t i = 0; i < MIN(count, ARRAY_SIZE(workers)); i++) {
+		k_thread_create(&workers[i], worker_stacks[i],
+				K_THREAD_STACK_SIZEOF(worker_stacks[i]),
+				worker_fn, NULL, NULL, NULL,
+				K_LOWEST_APPLICATION_THREAD_PRIO, 0, K_NO_WAIT);
+		k_thread_name_set(&workers[i], "boot_init");
+	}
+
+	return 0;
+}
+
+/* Open a new record in the boot history. Runs before the modem library is initialized. */
+static int history_init(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	if ((history.magic != BOOT_HISTORY_MAGIC) || (history.crc != history_crc()) ||
+	    (history.head >= ARRAY_SIZE(history.records)) ||
+	    (history.count > ARRAY_SIZE(history.records))) {
+		memset(&history, 0, sizeof(history));
+		history.magic = BOOT_HISTORY_MAGIC;
+	}
+
+	if (history.count > 0) {
+		history.head = (history.head + 1) % ARRAY_SIZE(history.records);
+	}
+
+	history.count = MIN(history.count + 1, ARRAY_SIZE(history.records));
+
+	current = &history.records[history.head];
+	memset(current, 0, sizeof(*current));
+	current->boot_id = history.next_boot_id++;
+	history.crc = history_crc();
+
+	boot_stage_done(BOOT_STAGE_KERNEL);
+	return 0;
+}
+
+SYS_INIT(history_init, POST_KERNEL, 0);
+
+#if defined(CONFIG_SHELL)
+/* Prints the boot history as CSV, oldest boot first, for scripts/boot_timeline.py. */
+static int cmd_boot_timeline(const struct shell *shell, size_t argc, char **argv)
+{
+	struct boot_record snapshot;
+	const struct boot_record *record = &snapshot;
+	uint32_t count = history.count;
+
+	shell_print(shell, "boot,event,time_us");
+
+	for (uint32_t n = 0; n < count; n++) {
+		uint32_t index = (history.head + ARRAY_SIZE(history.records) - count + 1 + n) %
+				 ARRAY_SIZE(history.records);
+		k_spinlock_key_t key = k_spin_lock(&lock);
+
+		memcpy(&snapshot, &history.records[index], sizeof(snapshot));
+		k_spin_unlock(&lock, key);
+
+		for (size_t i = 0; i < BOOT_STAGE_COUNT; i++) {
+			if (record->stages_done & BIT(i)) {
+				shell_print(shell, "%u,%s,%u", record->boot_id, stage_names[i],
+					    record->stage_us[i]);
+			}
+		}
+
+		for (size_t i = 0; i < MIN(record->module_count, ARRAY_SIZE(record->modules));
+		     i++) {
+			shell_print(shell, "%u,module:%.*s,%u", record->boot_id,
+				    BOOT_MODULE_NAME_LEN, record->modules[i].name,
+				    record->modules[i].us);
+		}
+	}
+
+	return 0;
+}
+
+SHELL_CMD_REGISTER(boot_timeline, NULL, "Print the timeline of the last boots as CSV",
+		   cmd_boot_timeline);
+#endif /* CONFIG_SHELL */
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _BOOT_INIT_H_
+#define _BOOT_INIT_H_
+
+/**@file
+ *@brief Boot stage tracking and parallel initialization of independent setup steps.
+ *
+ * Modules mark the boot stages they complete with boot_stage_done(), which records the
+ * uptime at which each stage was first reached. Setup steps that would otherwise block the
+ * main thread are handed to boot_init_run(), which runs them on worker threads as soon as
+ * the stages they depend on are done.
+ *
+ * The timelines of the last CONFIG_BOOT_INIT_HISTORY boots are kept in RAM that survives
+ * soft resets, and are printed as CSV by the "boot_timeline" shell command. The output can be
+ * analyzed on the host with scripts/boot_timeline.py.
+ */
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Boot stages, in the order they are normally reached. */
+enum boot_stage {
+	/** Kernel is initialized and the boot record is opened. */
+	BOOT_STAGE_KERNEL,
+	/** nRF modem library has been initialized. */
+	BOOT_STAGE_MODEM_LIB,
+	/** main() has been entered. */
+	BOOT_STAGE_MAIN,
+	/** Application NVS partition and record store are mounted. */
+	BOOT_STAGE_STORAGE,
+	/** SPI and TWI peripherals are ready. */
+	BOOT_STAGE_PERIPHERALS,
+	/** Application watchdog is started. */
+	BOOT_STAGE_WATCHDOG,
+	/** Device configuration has been loaded from flash. */
+	BOOT_STAGE_SETTINGS,
+	/** External sensors are initialized. */
+	BOOT_STAGE_SENSORS,
+	/** FOTA manager is initialized. */
+	BOOT_STAGE_FOTA,
+	/** Modem module is set up and LTE attach can start. */
+	BOOT_STAGE_MODEM,
+	/** LTE attach has been started. */
+	BOOT_STAGE_LTE_CONNECTING,
+	/** Connected to LTE. */
+	BOOT_STAGE_LTE_CONNECTED,
+	/** Connected to cloud. */
+	BOOT_STAGE_CLOUD_CONNECTED,
+	/** First data message has been handed over for publishing. */
+	BOOT_STAGE_FIRST_PUBLISH,
+	BOOT_STAGE_COUNT,
+};
+
+/** Setup step run by boot_init_run(). */
+struct boot_init_step {
+	/** Name used in log messages. */
+	const char *name;
+	/** Stage that is marked as done when the step has run. */
+	enum boot_stage stage;
+	/** Bitmask of stages that must be done before the step is run. */
+	uint32_t depends;
+	/** Setup function. */
+	int (*fn)(void);
+};
+
+#if defined(CONFIG_BOOT_INIT)
+
+/** @brief Mark a boot stage as done. Only the first call for each stage is recorded.
+ *
+ *  @param[in] stage Boot stage.
+ */
+void boot_stage_done(enum boot_stage stage);
+
+/** @brief Record the time at which a module was started. Called from module_start().
+ *
+ *  @param[in] name Name of the module, truncated to 8 characters in the record.
+ */
+void boot_module_started(const char *name);
+
+/** @brief Check if a boot stage is done.
+ *
+ *  @param[in] stage Boot stage.
+ *
+ *  @return true if the stage is done.
+ */
+bool boot_stage_is_done(enum boot_stage stage);
+
+/** @brief Get the uptime at which a boot stage was done.
+ *
+ *  @param[in] stage Boot stage.
+ *
+ *  @return Uptime in microseconds, or a negative error code if the stage is not done.
+ */
+int64_t boot_stage_time_get(enum boot_stage stage);
+
+/** @brief Run setup steps on worker threads. The function returns immediately.
+ *
+ *  Steps are started in array order. A step waits until all stages in its dependency mask
+ *  are done, or until CONFIG_BOOT_INIT_STEP_WAIT_TIMEOUT_SEC has passed, and is then run.
+ *  Steps must not depend on stages of steps that are placed after them in the array.
+ *
+ *  @param[in] steps Array of steps. Must remain valid until all steps have run.
+ *  @param[in] count Number of steps.
+ *
+ *  @return 0 if successful, otherwise a negative error code.
+ */
+int boot_init_run(const struct boot_init_step *steps, size_t count);
+
+#else
+
+static inline void boot_stage_done(enum boot_stage stage)
+{
+	ARG_UNUSED(stage);
+}
+
+static inline void boot_module_started(const char *name)
+{
+	ARG_UNUSED(name);
+}
+
+static inline bool boot_stage_is_done(enum boot_stage stage)
+{
+	ARG_UNUSED(stage);
+	return true;
+}
+
+static inline int64_t boot_stage_time_get(enum boot_stage stage)
+{
+	ARG_UNUSED(stage);
+	return -ENOTSUP;
+}
+
+static inline int boot_init_run(const struct boot_init_step *steps, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		(void)steps[i].fn();
+	}
+
+	return 0;
+}
+
+#endif /* CONFIG_BOOT_INIT */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BOOT_INIT_H_ */
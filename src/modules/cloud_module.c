@@ -20,11 +20,16 @@
 #endif
 
 #include "cloud_wrapper.h"
+#if defined(CONFIG_DATA_AGPS_CACHE)
+#include "agps_cache.h"
+#endif
 #include "cloud/cloud_codec/cloud_codec.h"
 
 #define MODULE cloud_module
 
 #include "modules_common.h"
+#include "boot_init.h"
+#include "heap_tracker.h"
 #include "events/cloud_module_event.h"
 #include "events/app_module_event.h"
 #include "events/data_module_event.h"
@@ -104,6 +109,17 @@ const k_tid_t cloud_module_thread;
 QOS_MESSAGE_TYPES_REGISTER(GENERIC, BATCH, UI, NEIGHBOR_CELLS, AGPS_REQUEST,
 			   PGPS_REQUEST, CONFIG, MEMFAULT, CUSTOM_CMD);
 
+/* QoS message payloads that are released by their owner instead of with heap_tracker_free().
+ * The QoS library only keeps the heap_allocated flag, so the release function is looked up by
+ * payload when the message is removed from the pending list.
+ */
+static struct payload_owner {
+	uint8_t *buf;
+	void (*release)(uint8_t *ptr);
+} payload_owners[CONFIG_QOS_PENDING_MESSAGES_MAX];
+
+static struct k_spinlock payload_owners_lock;
+
 /* Cloud module message queue. */
 #define CLOUD_QUEUE_ENTRY_COUNT		20
 #define CLOUD_QUEUE_BYTE_ALIGNMENT	4
@@ -120,8 +136,8 @@ static struct module_data self = {
 /* Forward declarations. */
 static void connect_check_work_fn(struct k_work *work);
 static void send_config_received(void);
-static void add_qos_message(uint8_t *ptr, size_t len, uint8_t type,
-			    uint32_t flags, bool heap_allocated);
+static int add_qos_message(uint8_t *ptr, size_t len, uint8_t type,
+			   uint32_t flags, bool heap_allocated);
 
 /* Convenience functions used in internal state handling. */
 static char *state2str(enum state_type state)
@@ -291,6 +307,11 @@ static void agps_data_handle(const uint8_t *buf, const size_t len)
 		LOG_ERR("Unable to process A-GPS data, error: %d", err);
 		return;
 	}
+
+#if defined(CONFIG_DATA_AGPS_CACHE)
+	agps_cache_response_store(buf, len);
+	SEND_EVENT(cloud, CLOUD_EVT_AGPS_DATA_PROCESSED);
+#endif
 #if defined(CONFIG_NRF_CLOUD_PGPS)
 	err = nrf_cloud_pgps_notify_prediction();
 	if (err) {
@@ -326,6 +347,7 @@ static void cloud_wrap_event_handler(const struct cloud_wrap_event *const evt)
 	}
 	case CLOUD_WRAP_EVT_CONNECTED: {
 		LOG_DBG("CLOUD_WRAP_EVT_CONNECTED");
+		boot_stage_done(BOOT_STAGE_CLOUD_CONNECTED);
 		SEND_EVENT(cloud, CLOUD_EVT_CONNECTED);
 		break;
 	}
@@ -442,14 +464,16 @@ static void cloud_wrap_event_handler(const struct cloud_wrap_event *const evt)
 
         // 当前函数是一个回调函数，在nrf cloud library内部被调用，
         // evt在 nct_mqtt_evt_handler 中是局部变量。当它返回时，evt会被释放，所以这里需要复制一份
-        cloud_evt->data.custom_cmd.ptr = k_malloc(evt->data.len);
+        cloud_evt->data.custom_cmd.ptr = heap_tracker_alloc(HEAP_TAG_CLOUD_RX,
+                                                            evt->data.len);
         if (NULL == cloud_evt->data.custom_cmd.ptr) {
-            LOG_WRN("k_malloc failed");
+            LOG_WRN("heap_tracker_alloc failed");
             return;
         }
         memcpy(cloud_evt->data.custom_cmd.ptr, evt->data.buf, evt->data.len);
         cloud_evt->data.custom_cmd.len = evt->data.len;
         cloud_evt->data.custom_cmd.is_allocated = true; // 用于指示此内存是需要释放的
+        cloud_evt->data.custom_cmd.release = NULL;
 
         cloud_evt->type = CLOUD_EVT_CUSTOM_CMD;
         APP_EVENT_SUBMIT(cloud_evt);
@@ -494,6 +518,8 @@ static void connect_cloud(void)
 	 * it is rather common that cloud_connect can be called under these
 	 * conditions.
 	 */
+	module_blocking_call_start(&self);
+
 	err = cloud_wrap_connect();
 	if (err) {
 		LOG_ERR("cloud_connect failed, error: %d", err);
@@ -511,6 +537,7 @@ static void connect_cloud(void)
 
 static void disconnect_cloud(void)
 {
+	module_blocking_call_start(&self);
 	cloud_wrap_disconnect();
 
 	connect_retries = 0;
@@ -520,8 +547,8 @@ static void disconnect_cloud(void)
 }
 
 /* Convenience function used to add messages to the QoS library. */
-static void add_qos_message(uint8_t *ptr, size_t len, uint8_t type,
-			    uint32_t flags, bool heap_allocated)
+static int add_qos_message(uint8_t *ptr, size_t len, uint8_t type,
+			   uint32_t flags, bool heap_allocated)
 {
 	int err;
 	struct qos_data message = {
@@ -540,6 +567,48 @@ static void add_qos_message(uint8_t *ptr, size_t len, uint8_t type,
 		LOG_ERR("qos_message_add, error: %d", err);
 		SEND_ERROR(cloud, CLOUD_EVT_ERROR, err);
 	}
+
+	return err;
+}
+
+static bool payload_owner_add(uint8_t *buf, void (*release)(uint8_t *ptr))
+{
+	k_spinlock_key_t key = k_spin_lock(&payload_owners_lock);
+	bool added = false;
+
+	for (size_t i = 0; i < ARRAY_SIZE(payload_owners); i++) {
+		if (payload_owners[i].buf == NULL) {
+			payload_owners[i].buf = buf;
+			payload_owners[i].release = release;
+			added = true;
+			break;
+		}
+	}
+
+	k_spin_unlock(&payload_owners_lock, key);
+
+	return added;
+}
+
+static void payload_owner_release(uint8_t *buf)
+{
+	void (*release)(uint8_t *ptr) = NULL;
+	k_spinlock_key_t key = k_spin_lock(&payload_owners_lock);
+
+	for (size_t i = 0; i < ARRAY_SIZE(payload_owners); i++) {
+		if (payload_owners[i].buf == buf) {
+			release = payload_owners[i].release;
+			payload_owners[i].buf = NULL;
+			break;
+		}
+	}
+
+	k_spin_unlock(&payload_owners_lock, key);
+
+	if (release != NULL) {
+		LOG_DBG("Releasing pointer: %p", (void *)buf);
+		release(buf);
+	}
 }
 
 static void qos_event_handler(const struct qos_evt *evt)
@@ -575,7 +644,9 @@ static void qos_event_handler(const struct qos_evt *evt)
 
 		if (evt->message.heap_allocated) {
 			LOG_DBG("Freeing pointer: %p", (void *)evt->message.data.buf);
-			k_free(evt->message.data.buf);
+			heap_tracker_free(evt->message.data.buf);
+		} else {
+			payload_owner_release(evt->message.data.buf);
 		}
 		break;
 	default:
@@ -647,6 +718,17 @@ static void on_custom_cloud_data_ready(struct cloud_msg_data *msg)
     static uint8_t none[2] = { 0x00, 0x00 };
     if(!(cmd->buf)) {
         add_qos_message(none, sizeof(none), CUSTOM_CMD, QOS_FLAG_RELIABILITY_ACK_REQUIRED, false);
+    } else if (cmd->is_allocated && (cmd->release != NULL)) {
+        if (!payload_owner_add(cmd->buf, cmd->release)) {
+            LOG_WRN("No free payload owner entry, custom command response dropped");
+            cmd->release(cmd->buf);
+            return;
+        }
+
+        if (add_qos_message(cmd->buf, cmd->len, CUSTOM_CMD,
+                            QOS_FLAG_RELIABILITY_ACK_REQUIRED, false)) {
+            payload_owner_release(cmd->buf);
+        }
     } else {
         add_qos_message(cmd->buf, cmd->len, CUSTOM_CMD, QOS_FLAG_RELIABILITY_ACK_REQUIRED, cmd->is_allocated);
     }
@@ -766,6 +848,8 @@ static void on_sub_state_cloud_connected(struct cloud_msg_data *msg)
 						   paths);
 			if (err) {
 				LOG_ERR("cloud_wrap_data_send, err: %d", err);
+			} else {
+				boot_stage_done(BOOT_STAGE_FIRST_PUBLISH);
 			}
 
 			return;
@@ -872,6 +956,8 @@ static void on_sub_state_cloud_connected(struct cloud_msg_data *msg)
 						   NULL);
 			if (err) {
 				LOG_WRN("cloud_wrap_data_send, err: %d", err);
+			} else {
+				boot_stage_done(BOOT_STAGE_FIRST_PUBLISH);
 			}
 			break;
 		case BATCH:
@@ -881,6 +967,8 @@ static void on_sub_state_cloud_connected(struct cloud_msg_data *msg)
 						    msg->module.cloud.data.message.id);
 			if (err) {
 				LOG_WRN("cloud_wrap_batch_send, err: %d", err);
+			} else {
+				boot_stage_done(BOOT_STAGE_FIRST_PUBLISH);
 			}
 			break;
 		case UI:
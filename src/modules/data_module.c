@@ -21,10 +21,17 @@
 #endif
 
 #include "cloud/cloud_codec/cloud_codec.h"
+#if defined(CONFIG_DATA_AGPS_CACHE)
+#include "agps_cache.h"
+#endif
+#if defined(CONFIG_DATA_GNSS_FILTER)
+#include "gnss_filter.h"
+#endif
 
 #define MODULE data_module
 
 #include "modules_common.h"
+#include "boot_init.h"
 #include "events/app_module_event.h"
 #include "events/cloud_module_event.h"
 #include "events/data_module_event.h"
@@ -34,11 +41,25 @@
 #include "events/ui_module_event.h"
 #include "events/util_module_event.h"
 
+#if defined(CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE)
+#include "ext_sensors.h"
+#endif
+
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(MODULE, CONFIG_DATA_MODULE_LOG_LEVEL);
 
 #define DEVICE_SETTINGS_KEY			"data_module"
+/* Whole configuration stored as one blob by earlier firmware, migrated to field records. */
 #define DEVICE_SETTINGS_CONFIG_KEY		"config"
+/* Configuration stored as one record per field, under "data_module/cfg/<field>". */
+#define DEVICE_SETTINGS_CONFIG_FIELDS_KEY	"cfg"
+
+/* Version of the field record encoding, stored as the first byte of each record and followed
+ * by the value in the layout of the corresponding cloud_data_cfg member. Records of a newer
+ * version, or with a value size that does not match, are ignored and the field keeps its
+ * default value.
+ */
+#define CONFIG_RECORD_VERSION			1
 
 struct data_msg_data {
 	union {
@@ -81,6 +102,17 @@ static struct cloud_data_modem_static modem_stat;
  */
 #define MODEM_STATIC_ARRAY_SIZE 1
 
+#if defined(CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE)
+/* Impact waveform windows drained from the external sensors library, waiting to be encoded.
+ * Each window is matched to its impact by the window ID in cloud_data_impact.
+ */
+static uint8_t impact_window_batch[CONFIG_DATA_IMPACT_WINDOW_BATCH_SIZE];
+static size_t impact_window_batch_len;
+
+BUILD_ASSERT(CONFIG_DATA_IMPACT_WINDOW_BATCH_SIZE >= EXT_SENSOR_IMPACT_WINDOW_SIZE_MAX,
+	     "Impact window batch buffer cannot hold a single window");
+#endif
+
 /* Head of ringbuffers. */
 static int head_gnss_buf;
 static int head_sensor_buf;
@@ -91,6 +123,44 @@ static int head_bat_buf;
 
 static K_SEM_DEFINE(config_load_sem, 0, 1);
 
+/* Longest name of a configuration field, the settings key is built on the stack. */
+#define FIELD_NAME_LEN_MAX	8
+
+/* Largest configuration field, records are a version byte followed by the value. */
+#define FIELD_SIZE_MAX		sizeof(double)
+
+#define CONFIG_RECORD_SIZE_MAX	(1 + FIELD_SIZE_MAX)
+
+#define CONFIG_FIELD(_name, _member) {						\
+	.name = _name + ZERO_OR_COMPILE_ERROR(sizeof(_name) - 1 <= FIELD_NAME_LEN_MAX),	\
+	.offset = offsetof(struct cloud_data_cfg, _member),			\
+	.size = sizeof(((struct cloud_data_cfg *)0)->_member) +			\
+		ZERO_OR_COMPILE_ERROR(sizeof(((struct cloud_data_cfg *)0)->_member) <=	\
+				      FIELD_SIZE_MAX),					\
+}
+
+/* Persisted configuration fields. Fields added to cloud_data_cfg need an entry with a new
+ * name, devices that have no record for it yet use the default value.
+ */
+static const struct config_field {
+	const char *name;
+	uint8_t offset;
+	uint8_t size;
+} config_fields[] = {
+	CONFIG_FIELD("mode", active_mode),
+	CONFIG_FIELD("loct", location_timeout),
+	CONFIG_FIELD("actw", active_wait_timeout),
+	CONFIG_FIELD("movr", movement_resolution),
+	CONFIG_FIELD("movt", movement_timeout),
+	CONFIG_FIELD("acct", accelerometer_activity_threshold),
+	CONFIG_FIELD("inat", accelerometer_inactivity_threshold),
+	CONFIG_FIELD("inato", accelerometer_inactivity_timeout),
+	CONFIG_FIELD("nognss", no_data.gnss),
+	CONFIG_FIELD("noncell", no_data.neighbor_cell),
+};
+
+BUILD_ASSERT(sizeof(struct cloud_data_cfg) <= UINT8_MAX, "Field offsets do not fit in 8 bits");
+
 /* Default device configuration. */
 static struct cloud_data_cfg current_cfg = {
 	.location_timeout	 = CONFIG_DATA_LOCATION_TIMEOUT_SECONDS,
@@ -105,6 +175,19 @@ static struct cloud_data_cfg current_cfg = {
 	.no_data.neighbor_cell	 = !IS_ENABLED(CONFIG_DATA_SAMPLE_NEIGHBOR_CELLS_DEFAULT)
 };
 
+/* Configuration as stored in flash, defaults for fields that have no record. Used to only
+ * write the fields that have changed. A field set from the cloud to its default value gets
+ * no record, so it follows the default of later firmware.
+ */
+static struct cloud_data_cfg stored_cfg;
+
+/* Configuration read from the legacy blob, and the fields that had a record of their own. */
+static struct cloud_data_cfg legacy_cfg;
+static bool legacy_cfg_loaded;
+static uint32_t config_fields_loaded;
+
+BUILD_ASSERT(ARRAY_SIZE(config_fields) <= 32, "Too many configuration fields");
+
 static struct k_work_delayable data_send_work;
 
 /* List used to keep track of responses from other modules with data that is
@@ -363,17 +446,63 @@ grant:
 	return true;
 }
 
+static int config_field_load(const char *name, size_t len, settings_read_cb read_cb,
+			     void *cb_arg)
+{
+	uint8_t record[CONFIG_RECORD_SIZE_MAX];
+	const struct config_field *field = NULL;
+	size_t i;
+	int err;
+
+	for (i = 0; i < ARRAY_SIZE(config_fields); i++) {
+		if (strcmp(name, config_fields[i].name) == 0) {
+			field = &config_fields[i];
+			break;
+		}
+	}
+
+	if (field == NULL) {
+		LOG_DBG("Unknown configuration field %s ignored", name);
+		return 0;
+	}
+
+	if (len != 1 + field->size) {
+		LOG_WRN("Configuration field %s has size %d, ignored", name, len);
+		return 0;
+	}
+
+	err = read_cb(cb_arg, record, len);
+	if (err < 0) {
+		LOG_ERR("Failed to load configuration field %s, error: %d", name, err);
+		return err;
+	}
+
+	if (record[0] != CONFIG_RECORD_VERSION) {
+		LOG_WRN("Configuration field %s has version %d, ignored", name, record[0]);
+		return 0;
+	}
+
+	memcpy((uint8_t *)&current_cfg + field->offset, &record[1], field->size);
+	memcpy((uint8_t *)&stored_cfg + field->offset, &record[1], field->size);
+	config_fields_loaded |= BIT(i);
+
+	return 0;
+}
+
 static int config_settings_handler(const char *key, size_t len,
 				   settings_read_cb read_cb, void *cb_arg)
 {
+	const char *next;
 	int err = 0;
 
-	if (strcmp(key, DEVICE_SETTINGS_CONFIG_KEY) == 0) {
-		err = read_cb(cb_arg, &current_cfg, sizeof(current_cfg));
+	if (settings_name_steq(key, DEVICE_SETTINGS_CONFIG_FIELDS_KEY, &next) && next) {
+		err = config_field_load(next, len, read_cb, cb_arg);
+	} else if (strcmp(key, DEVICE_SETTINGS_CONFIG_KEY) == 0) {
+		err = read_cb(cb_arg, &legacy_cfg, MIN(len, sizeof(legacy_cfg)));
 		if (err < 0) {
 			LOG_ERR("Failed to load configuration, error: %d", err);
 		} else {
-			LOG_DBG("Device configuration loaded from flash");
+			legacy_cfg_loaded = true;
 			err = 0;
 		}
 	}
@@ -405,23 +534,74 @@ static void date_time_event_handler(const struct date_time_evt *evt)
 	}
 }
 
-static int save_config(const void *buf, size_t buf_len)
+/* Store the fields of the current configuration that differ from what is stored in flash. */
+static int save_config(void)
 {
+	uint8_t record[CONFIG_RECORD_SIZE_MAX] = { CONFIG_RECORD_VERSION };
+	char key[sizeof(DEVICE_SETTINGS_KEY "/" DEVICE_SETTINGS_CONFIG_FIELDS_KEY "/") +
+		 FIELD_NAME_LEN_MAX];
+	int count = 0;
 	int err;
 
-	err = settings_save_one(DEVICE_SETTINGS_KEY "/"
-				DEVICE_SETTINGS_CONFIG_KEY,
-				buf, buf_len);
-	if (err) {
-		LOG_WRN("settings_save_one, error: %d", err);
-		return err;
+	for (size_t i = 0; i < ARRAY_SIZE(config_fields); i++) {
+		const struct config_field *field = &config_fields[i];
+		uint8_t *current = (uint8_t *)&current_cfg + field->offset;
+		uint8_t *stored = (uint8_t *)&stored_cfg + field->offset;
+
+		if (memcmp(current, stored, field->size) == 0) {
+			continue;
+		}
+
+		memcpy(&record[1], current, field->size);
+		snprintk(key, sizeof(key), DEVICE_SETTINGS_KEY "/" DEVICE_SETTINGS_CONFIG_FIELDS_KEY
+			 "/%s", field->name);
+
+		err = settings_save_one(key, record, 1 + field->size);
+		if (err) {
+			LOG_WRN("settings_save_one, error: %d", err);
+			return err;
+		}
+
+		memcpy(stored, current, field->size);
+		count++;
 	}
 
-	LOG_DBG("Device configuration stored to flash");
+	LOG_DBG("%d device configuration field(s) stored to flash", count);
 
 	return 0;
 }
 
+/* Take over the values of the legacy configuration blob for fields that have no record of
+ * their own, store them as field records and delete the blob.
+ */
+static void config_legacy_migrate(void)
+{
+	int err;
+
+	for (size_t i = 0; i < ARRAY_SIZE(config_fields); i++) {
+		const struct config_field *field = &config_fields[i];
+
+		if (!(config_fields_loaded & BIT(i))) {
+			memcpy((uint8_t *)&current_cfg + field->offset,
+			       (uint8_t *)&legacy_cfg + field->offset, field->size);
+		}
+	}
+
+	err = save_config();
+	if (err) {
+		LOG_ERR("Configuration not migrated, error: %d", err);
+		return;
+	}
+
+	err = settings_delete(DEVICE_SETTINGS_KEY "/" DEVICE_SETTINGS_CONFIG_KEY);
+	if (err) {
+		LOG_WRN("settings_delete, error: %d", err);
+		return;
+	}
+
+	LOG_DBG("Device configuration migrated to field records");
+}
+
 static void cloud_codec_event_handler(const struct cloud_codec_evt *evt)
 {
 	if (evt->type == CLOUD_CODEC_EVT_CONFIG_UPDATE) {
@@ -441,19 +621,29 @@ static int setup(void)
 		return err;
 	}
 
+	stored_cfg = current_cfg;
+	legacy_cfg = current_cfg;
+
 	err = settings_load_subtree(DEVICE_SETTINGS_KEY);
 	if (err) {
 		LOG_ERR("settings_load_subtree, error: %d", err);
 		return err;
 	}
 
-	/* Wait up to 1 seconds for the settings API to load the device configuration stored
-	 * to flash, if any.
+	/* The settings handler is called from settings_load_subtree(), so the configuration
+	 * stored to flash, if any, has already been loaded at this point. Do not wait for it,
+	 * nothing is stored on a device that has not been configured yet.
 	 */
-	if (k_sem_take(&config_load_sem, K_SECONDS(1)) != 0) {
-		LOG_DBG("Failed retrieveing the device configuration from flash in time");
+	if (k_sem_take(&config_load_sem, K_NO_WAIT) != 0) {
+		LOG_DBG("No device configuration stored to flash, using defaults");
+	} else if (legacy_cfg_loaded) {
+		config_legacy_migrate();
+	} else {
+		LOG_DBG("Device configuration loaded from flash");
 	}
 
+	boot_stage_done(BOOT_STAGE_SETTINGS);
+
 	err = cloud_codec_init(&current_cfg, cloud_codec_event_handler);
 	if (err) {
 		LOG_ERR("cloud_codec_init, error: %d", err);
@@ -496,7 +686,7 @@ static void config_print_all(void)
 	}
 }
 
-static void config_distribute(enum data_module_event_type type)
+static void config_distribute(enum data_module_event_type type, uint32_t changed)
 {
 	struct data_module_event *data_module_event = new_data_module_event();
 
@@ -504,6 +694,7 @@ static void config_distribute(enum data_module_event_type type)
 
 	data_module_event->type = type;
 	data_module_event->data.cfg = current_cfg;
+	data_module_event->data.cfg_changed = changed;
 
 	APP_EVENT_SUBMIT(data_module_event);
 }
@@ -536,6 +727,54 @@ static void data_send(enum data_module_event_type event,
 	memset(data, 0, sizeof(struct cloud_codec_data));
 }
 
+#if defined(CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE)
+/* Drain stored impact waveform windows into the batch buffer and send them as batch data.
+ * Windows that do not fit are left in the external sensors library, which drops the oldest
+ * windows when it runs full.
+ */
+static void impact_windows_send(void)
+{
+	int err;
+	struct cloud_codec_data codec = { 0 };
+
+	while (true) {
+		err = ext_sensors_impact_window_get(&impact_window_batch[impact_window_batch_len],
+						    sizeof(impact_window_batch) -
+						    impact_window_batch_len);
+		if (err < 0) {
+			break;
+		}
+
+		impact_window_batch_len += err;
+	}
+
+	if ((err != -ENODATA) && (err != -ENOMEM)) {
+		LOG_ERR("ext_sensors_impact_window_get, error: %d", err);
+	}
+
+	if (impact_window_batch_len == 0) {
+		return;
+	}
+
+	err = cloud_codec_encode_impact_windows(&codec, impact_window_batch,
+						impact_window_batch_len);
+	switch (err) {
+	case 0:
+		LOG_DBG("Impact windows encoded successfully");
+		data_send(DATA_EVT_DATA_SEND_BATCH, &codec);
+		impact_window_batch_len = 0;
+		break;
+	case -ENOTSUP:
+		LOG_DBG("Encoding of impact windows not supported");
+		break;
+	default:
+		LOG_ERR("Error encoding impact windows: %d", err);
+		SEND_ERROR(data, DATA_EVT_ERROR, err);
+		break;
+	}
+}
+#endif /* CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE */
+
 /* This function allocates buffer on the heap, which needs to be freed after use. */
 static void data_encode(void)
 {
@@ -658,6 +897,10 @@ static void data_encode(void)
 			SEND_ERROR(data, DATA_EVT_ERROR, err);
 			return;
 		}
+
+#if defined(CONFIG_EXTERNAL_SENSORS_IMPACT_CAPTURE)
+		impact_windows_send();
+#endif
 	}
 }
 
@@ -892,7 +1135,7 @@ static void requested_data_list_set(enum app_module_data_type *data_list,
 
 static void new_config_handle(struct cloud_data_cfg *new_config)
 {
-	bool config_change = false;
+	uint32_t changed = 0;
 
 	/* Guards making sure that only new configuration values are applied. */
 	if (current_cfg.active_mode != new_config->active_mode) {
@@ -904,7 +1147,7 @@ static void new_config_handle(struct cloud_data_cfg *new_config)
 			LOG_DBG("New Device mode: Passive");
 		}
 
-		config_change = true;
+		changed |= CLOUD_DATA_CFG_ACTIVE_MODE;
 	}
 
 	if (current_cfg.no_data.gnss != new_config->no_data.gnss) {
@@ -916,7 +1159,7 @@ static void new_config_handle(struct cloud_data_cfg *new_config)
 			LOG_DBG("Requesting of GNSS data is disabled");
 		}
 
-		config_change = true;
+		changed |= CLOUD_DATA_CFG_NO_DATA_GNSS;
 	}
 
 	if (current_cfg.no_data.neighbor_cell != new_config->no_data.neighbor_cell) {
@@ -928,7 +1171,7 @@ static void new_config_handle(struct cloud_data_cfg *new_config)
 			LOG_DBG("Requesting of neighbor cell data is disabled");
 		}
 
-		config_change = true;
+		changed |= CLOUD_DATA_CFG_NO_DATA_NEIGHBOR_CELL;
 	}
 
 	if (new_config->location_timeout > 0) {
@@ -937,7 +1180,7 @@ static void new_config_handle(struct cloud_data_cfg *new_config)
 
 			LOG_DBG("New location timeout: %d", current_cfg.location_timeout);
 
-			config_change = true;
+			changed |= CLOUD_DATA_CFG_LOCATION_TIMEOUT;
 		}
 	} else {
 		LOG_WRN("New location timeout out of range: %d", new_config->location_timeout);
@@ -949,7 +1192,7 @@ static void new_config_handle(struct cloud_data_cfg *new_config)
 
 			LOG_DBG("New Active wait timeout: %d", current_cfg.active_wait_timeout);
 
-			config_change = true;
+			changed |= CLOUD_DATA_CFG_ACTIVE_WAIT_TIMEOUT;
 		}
 	} else {
 		LOG_WRN("New Active timeout out of range: %d", new_config->active_wait_timeout);
@@ -961,7 +1204,7 @@ static void new_config_handle(struct cloud_data_cfg *new_config)
 
 			LOG_DBG("New Movement resolution: %d", current_cfg.movement_resolution);
 
-			config_change = true;
+			changed |= CLOUD_DATA_CFG_MOVEMENT_RESOLUTION;
 		}
 	} else {
 		LOG_WRN("New Movement resolution out of range: %d",
@@ -974,7 +1217,7 @@ static void new_config_handle(struct cloud_data_cfg *new_config)
 
 			LOG_DBG("New Movement timeout: %d", current_cfg.movement_timeout);
 
-			config_change = true;
+			changed |= CLOUD_DATA_CFG_MOVEMENT_TIMEOUT;
 		}
 	} else {
 		LOG_WRN("New Movement timeout out of range: %d", new_config->movement_timeout);
@@ -986,7 +1229,7 @@ static void new_config_handle(struct cloud_data_cfg *new_config)
 		new_config->accelerometer_activity_threshold;
 		LOG_DBG("New Accelerometer act threshold: %.2f",
 			current_cfg.accelerometer_activity_threshold);
-		config_change = true;
+		changed |= CLOUD_DATA_CFG_ACC_ACT_THRESHOLD;
 	}
 	if (current_cfg.accelerometer_inactivity_threshold !=
 	    new_config->accelerometer_inactivity_threshold) {
@@ -994,7 +1237,7 @@ static void new_config_handle(struct cloud_data_cfg *new_config)
 		new_config->accelerometer_inactivity_threshold;
 		LOG_DBG("New Accelerometer inact threshold: %.2f",
 			current_cfg.accelerometer_inactivity_threshold);
-		config_change = true;
+		changed |= CLOUD_DATA_CFG_ACC_INACT_THRESHOLD;
 	}
 	if (current_cfg.accelerometer_inactivity_timeout !=
 	    new_config->accelerometer_inactivity_timeout) {
@@ -1002,20 +1245,20 @@ static void new_config_handle(struct cloud_data_cfg *new_config)
 		new_config->accelerometer_inactivity_timeout;
 		LOG_DBG("New Accelerometer inact timeout: %.2f",
 			current_cfg.accelerometer_inactivity_timeout);
-		config_change = true;
+		changed |= CLOUD_DATA_CFG_ACC_INACT_TIMEOUT;
 	}
 
 	/* If there has been a change in the currently applied device configuration we want to store
-	 * the configuration to flash and distribute it to other modules.
+	 * the changed fields to flash and distribute the configuration to other modules.
 	 */
-	if (config_change) {
-		int err = save_config(&current_cfg, sizeof(current_cfg));
+	if (changed) {
+		int err = save_config();
 
 		if (err) {
 			LOG_ERR("Configuration not stored, error: %d", err);
 		}
 
-		config_distribute(DATA_EVT_CONFIG_READY);
+		config_distribute(DATA_EVT_CONFIG_READY, changed);
 	} else {
 		LOG_DBG("No new values in incoming device configuration update message");
 	}
@@ -1079,12 +1322,23 @@ static void agps_request_handle(struct nrf_modem_gnss_agps_data_frame *incoming_
 	 * A-GPS request and send out an event containing the request for the cloud module to pick
 	 * up and send to the cloud that is currently used.
 	 */
+#if defined(CONFIG_DATA_AGPS_CACHE)
+	if ((incoming_request != NULL) && !agps_cache_request_prepare(&request)) {
+		LOG_DBG("A-GPS request answered from cache or pending");
+		return;
+	}
+#endif
 	err = (incoming_request == NULL) ? agps_request_encode(NULL) :
 					   agps_request_encode(&request);
 	if (err) {
 		LOG_WRN("Failed to request A-GPS data, error: %d", err);
 	} else {
 		LOG_DBG("A-GPS request sent");
+#if defined(CONFIG_DATA_AGPS_CACHE)
+		if (incoming_request != NULL) {
+			agps_cache_request_sent(&request);
+		}
+#endif
 		return;
 	}
 #endif
@@ -1103,6 +1357,24 @@ static void agps_request_handle(struct nrf_modem_gnss_agps_data_frame *incoming_
 	(void)err;
 }
 
+#if defined(CONFIG_DATA_AGPS_CACHE)
+/* Refresh cached A-GPS data that is about to expire while the radio is in use anyway. */
+static void agps_prefetch(void)
+{
+	struct nrf_modem_gnss_agps_data_frame request;
+
+	if (!agps_cache_prefetch_get(&request)) {
+		return;
+	}
+
+	LOG_DBG("Refreshing cached A-GPS data");
+
+	if (agps_request_encode(&request) == 0) {
+		agps_cache_request_sent(&request);
+	}
+}
+#endif /* CONFIG_DATA_AGPS_CACHE */
+
 /* Message handler for STATE_CLOUD_DISCONNECTED. */
 static void on_cloud_state_disconnected(struct data_msg_data *msg)
 {
@@ -1122,9 +1394,23 @@ static void on_cloud_state_disconnected(struct data_msg_data *msg)
 	}
 
 	if (IS_EVENT(msg, location, LOCATION_MODULE_EVT_AGPS_NEEDED)) {
+		struct nrf_modem_gnss_agps_data_frame *request =
+			&msg->module.location.data.agps_request;
+
 		LOG_DBG("A-GPS request buffered");
+
+		/* Merge with requests buffered earlier, the GNSS module may have obtained some of
+		 * the data types since, but requesting them again is cheaper than losing requests.
+		 */
+		if (agps_request_buffered) {
+			agps_request_buffer.sv_mask_ephe |= request->sv_mask_ephe;
+			agps_request_buffer.sv_mask_alm |= request->sv_mask_alm;
+			agps_request_buffer.data_flags |= request->data_flags;
+		} else {
+			agps_request_buffer = *request;
+		}
+
 		agps_request_buffered = true;
-		agps_request_buffer = msg->module.location.data.agps_request;
 		return;
 	}
 }
@@ -1134,6 +1420,9 @@ static void on_cloud_state_connected(struct data_msg_data *msg)
 {
 	if (IS_EVENT(msg, data, DATA_EVT_DATA_READY)) {
 		data_encode();
+#if defined(CONFIG_DATA_AGPS_CACHE)
+		agps_prefetch();
+#endif
 		return;
 	}
 
@@ -1166,6 +1455,18 @@ static void on_cloud_state_connected(struct data_msg_data *msg)
 		agps_request_handle(&msg->module.location.data.agps_request);
 		return;
 	}
+
+#if defined(CONFIG_DATA_AGPS_CACHE)
+	if (IS_EVENT(msg, cloud, CLOUD_EVT_AGPS_DATA_PROCESSED)) {
+		struct nrf_modem_gnss_agps_data_frame request;
+
+		if (agps_cache_deferred_get(&request)) {
+			LOG_DBG("Requesting deferred A-GPS data");
+			agps_request_handle(&request);
+		}
+		return;
+	}
+#endif
 }
 
 /* Message handler for all states. */
@@ -1202,7 +1503,7 @@ static void on_all_states(struct data_msg_data *msg)
 
 	if (IS_EVENT(msg, app, APP_EVT_START)) {
 		config_print_all();
-		config_distribute(DATA_EVT_CONFIG_INIT);
+		config_distribute(DATA_EVT_CONFIG_INIT, CLOUD_DATA_CFG_ALL);
 	}
 
 	if (IS_EVENT(msg, util, UTIL_EVT_SHUTDOWN_REQUEST)) {
@@ -1331,12 +1632,18 @@ static void on_all_states(struct data_msg_data *msg)
 		struct cloud_data_battery new_battery_data = {
 			.bat = msg->module.app.data.bat.vdd_mv,
 			.bat_ts = msg->module.app.data.bat.timestamp,
+			.soc = msg->module.app.data.bat.soc,
+			.rem_h = msg->module.app.data.bat.remaining_h,
+			.est = msg->module.app.data.bat.has_estimate,
 			.queued = true
 		};
 
-		cloud_codec_populate_bat_buffer(bat_buf, &new_battery_data,
-						&head_bat_buf,
-						ARRAY_SIZE(bat_buf));
+		/* Readings where the battery estimate has not changed enough are not published. */
+		if (msg->module.app.data.bat.publish) {
+			cloud_codec_populate_bat_buffer(bat_buf, &new_battery_data,
+							&head_bat_buf,
+							ARRAY_SIZE(bat_buf));
+		}
 
 		requested_data_status_set(APP_DATA_BATTERY);
 	}
@@ -1366,6 +1673,10 @@ static void on_all_states(struct data_msg_data *msg)
 	if (IS_EVENT(msg, sensor, SENSOR_EVT_MOVEMENT_IMPACT_DETECTED)) {
 		struct cloud_data_impact new_impact_data = {
 			.magnitude = msg->module.sensor.data.impact.magnitude,
+			.duration_us = msg->module.sensor.data.impact.duration_us,
+			.energy = msg->module.sensor.data.impact.energy,
+			.type = msg->module.sensor.data.impact.type,
+			.window_id = msg->module.sensor.data.impact.window_id,
 			.ts = msg->module.sensor.data.impact.timestamp,
 			.queued = true
 		};
@@ -1390,6 +1701,13 @@ static void on_all_states(struct data_msg_data *msg)
 		new_location_data.pvt.longi = msg->module.location.data.location.pvt.longitude;
 		new_location_data.pvt.spd = msg->module.location.data.location.pvt.speed;
 
+#if defined(CONFIG_DATA_GNSS_FILTER)
+		if (!gnss_filter_process(&new_location_data)) {
+			requested_data_status_set(APP_DATA_LOCATION);
+			return;
+		}
+#endif
+
 		cloud_codec_populate_gnss_buffer(gnss_buf, &new_location_data,
 						&head_gnss_buf,
 						ARRAY_SIZE(gnss_buf));
@@ -1397,7 +1715,8 @@ static void on_all_states(struct data_msg_data *msg)
 		requested_data_status_set(APP_DATA_LOCATION);
 	}
 
-	if (IS_EVENT(msg, location, LOCATION_MODULE_EVT_DATA_NOT_READY)) {
+	if (IS_EVENT(msg, location, LOCATION_MODULE_EVT_DATA_NOT_READY) ||
+	    IS_EVENT(msg, location, LOCATION_MODULE_EVT_NEIGHBOR_CELLS_DATA_UNCHANGED)) {
 		requested_data_status_set(APP_DATA_LOCATION);
 	}
 
@@ -5,6 +5,7 @@
  */
 
 #include <zephyr/kernel.h>
+#include <string.h>
 #if defined(CONFIG_MEMFAULT)
 #include <memfault/metrics/metrics.h>
 #include <memfault/ports/zephyr/http.h>
@@ -14,12 +15,18 @@
 #include <memfault/panics/coredump.h>
 #endif
 
+#if defined(CONFIG_DEBUG_MODULE_THREAD_STATS)
+#include <zephyr/debug/thread_analyzer.h>
+#include <zephyr/sys/sys_heap.h>
+#endif /* CONFIG_DEBUG_MODULE_THREAD_STATS */
+
 #define MODULE debug_module
 
 #if defined(CONFIG_WATCHDOG_APPLICATION)
 #include "watchdog_app.h"
 #endif /* CONFIG_WATCHDOG_APPLICATION */
 #include "modules_common.h"
+#include "heap_tracker.h"
 #include "events/app_module_event.h"
 #include "events/cloud_module_event.h"
 #include "events/data_module_event.h"
@@ -86,7 +93,7 @@ entry:
 	 * After use it is expected that the data is freed.
 	 */
 	while (memfault_packetizer_get_chunk(data, &len)) {
-		message = k_malloc(len);
+		message = heap_tracker_alloc(HEAP_TAG_MEMFAULT, len);
 		if (message == NULL) {
 			LOG_ERR("Failed to allocate memory for Memfault data");
 			goto entry;
@@ -238,6 +245,14 @@ static void watchdog_handler(const struct watchdog_evt *evt)
 			LOG_ERR("memfault_software_watchdog_update_timeout, error: %d", err);
 		}
 		break;
+	case WATCHDOG_EVT_TASK_STALLED:
+		LOG_DBG("WATCHDOG_EVT_TASK_STALLED");
+		/* The hardware watchdog is no longer fed. Record which module thread stalled,
+		 * the Memfault software watchdog captures a coredump before the reset.
+		 */
+		MEMFAULT_TRACE_EVENT_WITH_LOG(TaskWatchdogStall, "%s: %d ms", evt->channel,
+					      evt->timeout);
+		break;
 	default:
 		break;
 	}
@@ -293,6 +308,152 @@ static void add_location_metrics(uint8_t satellites, uint32_t search_time,
 	memfault_metrics_heartbeat_debug_trigger();
 }
 
+#if defined(CONFIG_DEBUG_MODULE_THREAD_STATS)
+/* Threads that are reported, by thread name and metric key infix. Each thread has the metrics
+ * Thread<key>CpuPermille, Thread<key>StackFree and Thread<key>SwitchesEst. The work queues of
+ * the application are the system work queue and the BSEC state save queue.
+ */
+#define THREAD_STATS_THREADS(X)				\
+	X("main", Main)					\
+	X("sysworkq", SysWorkq)				\
+	X("bsec_save", BsecSave)			\
+	X("cloud_module_thread", Cloud)			\
+	X("data_module_thread", Data)			\
+	X("modem_module_thread", Modem)			\
+	X("sensor_module_thread", Sensor)		\
+	X("mflt_send_thread", MemfaultSend)
+
+#define THREAD_STATS_ENUM(_name, _key) THREAD_STATS_##_key,
+#define THREAD_STATS_NAME(_name, _key) [THREAD_STATS_##_key] = _name,
+#define THREAD_STATS_METRICS_SET(_name, _key)						\
+	case THREAD_STATS_##_key:							\
+		(void)memfault_metrics_heartbeat_set_unsigned(				\
+			MEMFAULT_METRICS_KEY(Thread##_key##CpuPermille), cpu);		\
+		(void)memfault_metrics_heartbeat_set_unsigned(				\
+			MEMFAULT_METRICS_KEY(Thread##_key##StackFree), stack_free);	\
+		(void)memfault_metrics_heartbeat_set_unsigned(				\
+			MEMFAULT_METRICS_KEY(Thread##_key##SwitchesEst), switches);	\
+		break;
+
+enum thread_stats_id {
+	THREAD_STATS_THREADS(THREAD_STATS_ENUM)
+	THREAD_STATS_COUNT
+};
+
+static const char *const thread_stats_names[] = {
+	THREAD_STATS_THREADS(THREAD_STATS_NAME)
+};
+
+/* Counters at the previous sample, CPU load and context switches are reported per interval. */
+static struct {
+	uint64_t cycles;
+	uint64_t switches;
+} thread_stats_prev[THREAD_STATS_COUNT];
+
+/* Results of the last sample. The thread analyzer callback runs with the scheduler locked, so
+ * it only fills in this array and the metrics are set after the analyzer has returned.
+ */
+static struct {
+	bool valid;
+	uint32_t cpu;
+	uint32_t stack_used;
+	uint32_t stack_size;
+	uint32_t switches;
+} thread_stats_sample[THREAD_STATS_COUNT];
+
+static uint64_t thread_stats_prev_ticks;
+static uint64_t thread_stats_window_cycles;
+
+extern struct k_heap _system_heap;
+
+static struct k_work_delayable thread_stats_work;
+
+static void thread_metrics_set(enum thread_stats_id id, uint32_t cpu, uint32_t stack_free,
+			       uint32_t switches)
+{
+	switch (id) {
+	THREAD_STATS_THREADS(THREAD_STATS_METRICS_SET)
+	default:
+		break;
+	}
+}
+
+static void thread_stats_cb(struct thread_analyzer_info *info)
+{
+	const k_thread_runtime_stats_t *usage = &info->usage;
+	uint64_t cycles, switches;
+	uint32_t cpu;
+	size_t id;
+
+	for (id = 0; id < THREAD_STATS_COUNT; id++) {
+		if (strcmp(info->name, thread_stats_names[id]) == 0) {
+			break;
+		}
+	}
+
+	if (id == THREAD_STATS_COUNT) {
+		return;
+	}
+
+	/* The number of times the thread has been scheduled in is not counted by the kernel. It
+	 * is estimated as the execution time divided by the average time per scheduling window,
+	 * which is reported as SwitchesEst.
+	 */
+	switches = usage->average_cycles ? usage->execution_cycles / usage->average_cycles : 0;
+	cycles = usage->execution_cycles - thread_stats_prev[id].cycles;
+	cpu = thread_stats_window_cycles ?
+	      (uint32_t)(cycles * 1000 / thread_stats_window_cycles) : 0;
+
+	thread_stats_sample[id].valid = true;
+	thread_stats_sample[id].cpu = cpu;
+	thread_stats_sample[id].stack_used = info->stack_used;
+	thread_stats_sample[id].stack_size = info->stack_size;
+	thread_stats_sample[id].switches = (uint32_t)(switches - thread_stats_prev[id].switches);
+
+	thread_stats_prev[id].cycles = usage->execution_cycles;
+	thread_stats_prev[id].switches = switches;
+}
+
+static void thread_stats_work_fn(struct k_work *work)
+{
+	uint64_t ticks = k_uptime_ticks();
+	struct sys_memory_stats heap_stats;
+
+	thread_stats_window_cycles = k_ticks_to_cyc_floor64(ticks - thread_stats_prev_ticks);
+	thread_stats_prev_ticks = ticks;
+
+	memset(thread_stats_sample, 0, sizeof(thread_stats_sample));
+	thread_analyzer_run(thread_stats_cb);
+
+	for (size_t id = 0; id < THREAD_STATS_COUNT; id++) {
+		if (!thread_stats_sample[id].valid) {
+			continue;
+		}
+
+		LOG_DBG("%s: CPU %d permille, stack %d/%d, ~%d switches", thread_stats_names[id],
+			thread_stats_sample[id].cpu, thread_stats_sample[id].stack_used,
+			thread_stats_sample[id].stack_size, thread_stats_sample[id].switches);
+
+		thread_metrics_set(id, thread_stats_sample[id].cpu,
+				   thread_stats_sample[id].stack_size -
+				   thread_stats_sample[id].stack_used,
+				   thread_stats_sample[id].switches);
+	}
+
+	/* Heap usage is not accounted per thread, the system heap is reported as a whole. */
+	if (sys_heap_runtime_stats_get(&_system_heap.heap, &heap_stats) == 0) {
+		(void)memfault_metrics_heartbeat_set_unsigned(
+						MEMFAULT_METRICS_KEY(SysHeapMaxAllocated),
+						heap_stats.max_allocated_bytes);
+		(void)memfault_metrics_heartbeat_set_unsigned(MEMFAULT_METRICS_KEY(SysHeapFree),
+							      heap_stats.free_bytes);
+	}
+
+	k_work_reschedule(&thread_stats_work,
+			  K_SECONDS(CONFIG_DEBUG_MODULE_THREAD_STATS_INTERVAL_SEC));
+}
+#endif /* CONFIG_DEBUG_MODULE_THREAD_STATS */
+
 static void memfault_handle_event(struct debug_msg_data *msg)
 {
 	if (IS_EVENT(msg, app, APP_EVT_START)) {
@@ -302,6 +463,12 @@ static void memfault_handle_event(struct debug_msg_data *msg)
 #if defined(CONFIG_WATCHDOG_APPLICATION)
 		watchdog_register_handler(watchdog_handler);
 #endif
+
+#if defined(CONFIG_DEBUG_MODULE_THREAD_STATS)
+		/* The first sample covers the time since boot. */
+		k_work_init_delayable(&thread_stats_work, thread_stats_work_fn);
+		k_work_schedule(&thread_stats_work, K_NO_WAIT);
+#endif
 	}
 
 	/* Send Memfault data at the same time application data is sent to save overhead
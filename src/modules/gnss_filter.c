@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <math.h>
+
+#include "gnss_filter.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(gnss_filter, CONFIG_DATA_MODULE_LOG_LEVEL);
+
+#define EARTH_RADIUS_M		6371000.0
+#define DEG_TO_RAD		(M_PI / 180.0)
+
+#define ALPHA			(CONFIG_DATA_GNSS_FILTER_ALPHA / 100.0)
+#define BETA			(CONFIG_DATA_GNSS_FILTER_BETA / 100.0)
+
+/* Minimum speed in m/s for the heading reported by the GNSS module to be meaningful. */
+#define HEADING_SPEED_MIN	1.0f
+
+/* Filter state. Positions are kept in meters east (x) and north (y) of the last reported
+ * fix, which keeps the local projection accurate.
+ */
+static struct {
+	bool valid;
+	double ref_lat;
+	double ref_longi;
+	double x;
+	double y;
+	double vx;
+	double vy;
+	int64_t ts;
+
+	/* Last reported fix. */
+	float reported_hdg;
+	bool reported_hdg_valid;
+	int64_t reported_ts;
+} state;
+
+static void to_local(double lat, double longi, double *x, double *y)
+{
+	*x = (longi - state.ref_longi) * DEG_TO_RAD * EARTH_RADIUS_M *
+	     cos(state.ref_lat * DEG_TO_RAD);
+	*y = (lat - state.ref_lat) * DEG_TO_RAD * EARTH_RADIUS_M;
+}
+
+static void from_local(double x, double y, double *lat, double *longi)
+{
+	*lat = state.ref_lat + y / (EARTH_RADIUS_M * DEG_TO_RAD);
+	*longi = state.ref_longi +
+		 x / (EARTH_RADIUS_M * DEG_TO_RAD * cos(state.ref_lat * DEG_TO_RAD));
+}
+
+static void reset(const struct cloud_data_gnss *fix)
+{
+	state.valid = true;
+	state.ref_lat = fix->pvt.lat;
+	state.ref_longi = fix->pvt.longi;
+	state.x = 0;
+	state.y = 0;
+	state.vx = 0;
+	state.vy = 0;
+	state.ts = fix->gnss_ts;
+}
+
+static void update(double zx, double zy, double dt)
+{
+	double px = state.x + state.vx * dt;
+	double py = state.y + state.vy * dt;
+	double rx = zx - px;
+	double ry = zy - py;
+
+	state.x = px + ALPHA * rx;
+	state.y = py + ALPHA * ry;
+	state.vx += BETA / dt * rx;
+	state.vy += BETA / dt * ry;
+}
+
+static bool heading_changed(const struct cloud_data_gnss *fix)
+{
+	float diff;
+
+	if (fix->pvt.spd < HEADING_SPEED_MIN || !state.reported_hdg_valid) {
+		return false;
+	}
+
+	diff = fabsf(fix->pvt.hdg - state.reported_hdg);
+	if (diff > 180.0f) {
+		diff = 360.0f - diff;
+	}
+
+	return diff >= CONFIG_DATA_GNSS_FILTER_HEADING_CHANGE_MIN_DEG;
+}
+
+/* Report the fix, with the smoothed position if smoothed is set. The reported position
+ * becomes the origin of the local coordinates.
+ */
+static void report(struct cloud_data_gnss *fix, bool smoothed)
+{
+	if (smoothed) {
+		double lat, longi;
+
+		from_local(state.x, state.y, &lat, &longi);
+		fix->pvt.lat = lat;
+		fix->pvt.longi = longi;
+	}
+
+	state.ref_lat = fix->pvt.lat;
+	state.ref_longi = fix->pvt.longi;
+	state.x = 0;
+	state.y = 0;
+
+	state.reported_hdg = fix->pvt.hdg;
+	state.reported_hdg_valid = fix->pvt.spd >= HEADING_SPEED_MIN;
+	state.reported_ts = fix->gnss_ts;
+}
+
+bool gnss_filter_process(struct cloud_data_gnss *fix)
+{
+	double zx, zy, dt, distance;
+	bool smoothed;
+
+	if (fix->pvt.acc > CONFIG_DATA_GNSS_FILTER_ACCURACY_MAX_M) {
+		LOG_DBG("Fix discarded, accuracy %.1f m", fix->pvt.acc);
+		return false;
+	}
+
+	dt = (fix->gnss_ts - state.ts) / (double)MSEC_PER_SEC;
+
+	/* Restart the filter if the track has been interrupted for too long, the velocity
+	 * estimate is no longer meaningful.
+	 */
+	if (!state.valid || dt <= 0 || dt > CONFIG_DATA_GNSS_FILTER_RESET_TIMEOUT_SEC) {
+		reset(fix);
+		report(fix, false);
+		return true;
+	}
+
+	to_local(fix->pvt.lat, fix->pvt.longi, &zx, &zy);
+
+	/* Fixes further apart than the tracking interval are not smoothed. The device may have
+	 * turned or stopped in between, so a position between the prediction and the fix could
+	 * be a place it never was. The fix is taken as is and the velocity is estimated anew.
+	 */
+	smoothed = dt <= CONFIG_DATA_GNSS_FILTER_SMOOTH_INTERVAL_MAX_SEC;
+
+	if (smoothed) {
+		update(zx, zy, dt);
+	} else {
+		state.x = zx;
+		state.y = zy;
+		state.vx = 0;
+		state.vy = 0;
+	}
+
+	state.ts = fix->gnss_ts;
+
+	distance = hypot(state.x, state.y);
+
+	if (distance >= CONFIG_DATA_GNSS_FILTER_DISTANCE_MIN_M || heading_changed(fix) ||
+	    (fix->gnss_ts - state.reported_ts) >=
+	    (CONFIG_DATA_GNSS_FILTER_REPORT_INTERVAL_MAX_SEC * MSEC_PER_SEC)) {
+		report(fix, smoothed);
+		return true;
+	}
+
+	LOG_DBG("Fix discarded, moved %.1f m since last reported fix", distance);
+	return false;
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _GNSS_FILTER_H_
+#define _GNSS_FILTER_H_
+
+/**@file
+ *@brief GNSS fix filter, used by the data module before fixes are buffered.
+ *
+ * Fixes with poor accuracy are discarded. Fixes that follow the previous fix within a few
+ * seconds are smoothed with a constant-velocity alpha-beta filter, sparser fixes keep their
+ * measured position. A fix is only reported when the position has moved far enough, or the
+ * heading has changed enough, since the last reported fix.
+ */
+
+#include <stdbool.h>
+
+#include "cloud/cloud_codec/cloud_codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Run a GNSS fix through the filter.
+ *
+ *  @param[in, out] fix GNSS fix with the timestamp set to uptime in milliseconds. If the fix is
+ *			to be buffered and was smoothed, the position is replaced with the
+ *			smoothed position.
+ *
+ *  @return true if the fix should be buffered, false if it should be discarded.
+ */
+bool gnss_filter_process(struct cloud_data_gnss *fix);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GNSS_FILTER_H_ */
@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <string.h>
+#include <zephyr/sys/sys_heap.h>
+#include <zephyr/sys/reboot.h>
+#include <app_event_manager.h>
+
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
+#if defined(CONFIG_MEMFAULT)
+#include <memfault/metrics/metrics.h>
+#endif
+
+#include "heap_tracker.h"
+
+#include <zephyr/logging/log.h>
+#include <zephyr/logging/log_ctrl.h>
+LOG_MODULE_REGISTER(heap_tracker, CONFIG_MODULES_COMMON_LOG_LEVEL);
+
+/* Tags, by name and metric key infix. Each tag has the metric Heap<key>Peak. */
+#define HEAP_TRACKER_TAGS(X)					\
+	X(HEAP_TAG_EVENT, "event", Event)			\
+	X(HEAP_TAG_CUSTOM_CMD, "custom_cmd", CustomCmd)		\
+	X(HEAP_TAG_CLOUD_RX, "cloud_rx", CloudRx)		\
+	X(HEAP_TAG_MEMFAULT, "memfault", Memfault)
+
+#define HEAP_TRACKER_NAME(_tag, _name, _key) [_tag] = _name,
+#define HEAP_TRACKER_METRIC_SET(_tag, _name, _key)					\
+	case _tag:									\
+		metric_max_set(MEMFAULT_METRICS_KEY(Heap##_key##Peak), peak);		\
+		break;
+
+static const char *const tag_names[] = {
+	HEAP_TRACKER_TAGS(HEAP_TRACKER_NAME)
+};
+
+BUILD_ASSERT(ARRAY_SIZE(tag_names) == HEAP_TAG_COUNT, "Missing heap tag name");
+
+/* Upper half of the last header word, the lower half holds the tag. k_malloc() stores the
+ * address of the system heap in the word before the memory it returns, which can never have
+ * this value, so untracked memory is told apart from tracked memory when it is freed.
+ */
+#define HEADER_MAGIC		0xA11C0000
+#define HEADER_MAGIC_MASK	0xFFFF0000
+
+/* Header placed in front of tracked memory, keeps the alignment of k_malloc(). */
+struct header {
+	uint32_t size;
+	uint32_t magic_tag;
+};
+
+extern struct k_heap _system_heap;
+
+static struct heap_tag_stats tags[HEAP_TAG_COUNT];
+
+/* Number of live blocks per tag, to account for the headers. */
+static uint32_t blocks[HEAP_TAG_COUNT];
+
+/* Peak per tag since the metrics were last updated. */
+static size_t window_peak[HEAP_TAG_COUNT];
+
+static struct k_spinlock lock;
+
+static struct header *header_get(void *ptr)
+{
+	struct header *header = (struct header *)ptr - 1;
+
+	if ((header->magic_tag & HEADER_MAGIC_MASK) != HEADER_MAGIC) {
+		return NULL;
+	}
+
+	__ASSERT((header->magic_tag & ~HEADER_MAGIC_MASK) < HEAP_TAG_COUNT,
+		 "Corrupt heap tracker header at %p", ptr);
+
+	return header;
+}
+
+static void stats_collect(struct heap_tracker_stats *stats)
+{
+	struct sys_memory_stats heap_stats = { 0 };
+	size_t tagged = 0;
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	memcpy(stats->tags, tags, sizeof(stats->tags));
+
+	for (size_t i = 0; i < HEAP_TAG_COUNT; i++) {
+		tagged += tags[i].live + blocks[i] * sizeof(struct header);
+	}
+
+	k_spin_unlock(&lock, key);
+
+	(void)sys_heap_runtime_stats_get(&_system_heap.heap, &heap_stats);
+
+	stats->untagged = heap_stats.allocated_bytes > tagged ?
+			  heap_stats.allocated_bytes - tagged : 0;
+	stats->free = heap_stats.free_bytes;
+	stats->largest_free = 0;
+}
+
+static void stats_log(const struct heap_tracker_stats *stats)
+{
+	for (size_t i = 0; i < HEAP_TAG_COUNT; i++) {
+		LOG_WRN("%s: %d bytes live, %d peak, %d failures", tag_names[i],
+			stats->tags[i].live, stats->tags[i].peak, stats->tags[i].failures);
+	}
+
+	LOG_WRN("untagged: %d bytes, free: %d bytes", stats->untagged, stats->free);
+}
+
+void *heap_tracker_alloc(enum heap_tag tag, size_t size)
+{
+	struct header *header = k_malloc(sizeof(*header) + size);
+	struct heap_tracker_stats stats;
+	k_spinlock_key_t key;
+
+	__ASSERT_NO_MSG(tag < HEAP_TAG_COUNT);
+
+	key = k_spin_lock(&lock);
+
+	if (header == NULL) {
+		tags[tag].failures++;
+	} else {
+		tags[tag].live += size;
+		tags[tag].peak = MAX(tags[tag].peak, tags[tag].live);
+		tags[tag].allocs++;
+		blocks[tag]++;
+		window_peak[tag] = MAX(window_peak[tag], tags[tag].live);
+	}
+
+	k_spin_unlock(&lock, key);
+
+	if (header == NULL) {
+		LOG_ERR("Allocation of %d bytes for %s failed", size, tag_names[tag]);
+		stats_collect(&stats);
+		stats_log(&stats);
+		return NULL;
+	}
+
+	header->size = size;
+	header->magic_tag = HEADER_MAGIC | tag;
+
+	return header + 1;
+}
+
+void heap_tracker_free(void *ptr)
+{
+	struct header *header;
+	k_spinlock_key_t key;
+	enum heap_tag tag;
+
+	if (ptr == NULL) {
+		return;
+	}
+
+	header = header_get(ptr);
+	if (header == NULL) {
+		k_free(ptr);
+		return;
+	}
+
+	tag = header->magic_tag & ~HEADER_MAGIC_MASK;
+
+	key = k_spin_lock(&lock);
+	tags[tag].live -= header->size;
+	blocks[tag]--;
+	k_spin_unlock(&lock, key);
+
+	k_free(header);
+}
+
+/* Largest block k_malloc() can return, found by a binary search over the size with
+ * sys_heap_alloc() and sys_heap_free(). The heap lock is held for the whole search, so other
+ * threads never see the probes, and the result is exact at the time of the call. It takes
+ * about two allocations per bit of the free size, which is fine for statistics.
+ */
+static size_t largest_free_get(size_t free)
+{
+	size_t low = 0;
+	size_t high = free;
+	k_spinlock_key_t key = k_spin_lock(&_system_heap.lock);
+
+	while (low < high) {
+		size_t size = low + (high - low + 1) / 2;
+		void *mem = sys_heap_alloc(&_system_heap.heap, size);
+
+		if (mem == NULL) {
+			high = size - 1;
+		} else {
+			sys_heap_free(&_system_heap.heap, mem);
+			low = size;
+		}
+	}
+
+	k_spin_unlock(&_system_heap.lock, key);
+
+	/* k_malloc() stores the heap reference in front of the memory it returns. */
+	return low > sizeof(struct k_heap *) ? low - sizeof(struct k_heap *) : 0;
+}
+
+void heap_tracker_stats_get(struct heap_tracker_stats *stats)
+{
+	stats_collect(stats);
+	stats->largest_free = largest_free_get(stats->free);
+}
+
+/* Events are allocated with the tracker instead of the default k_malloc() of the
+ * Application Event Manager. As in the default implementation, running out of memory for an
+ * event is fatal, but the heap usage per tag is logged first.
+ */
+void *app_event_manager_alloc(size_t size)
+{
+	void *event = heap_tracker_alloc(HEAP_TAG_EVENT, size);
+
+	if (unlikely(event == NULL)) {
+		LOG_PANIC();
+		__ASSERT_NO_MSG(false);
+		sys_reboot(SYS_REBOOT_WARM);
+		return NULL;
+	}
+
+	return event;
+}
+
+void app_event_manager_free(void *addr)
+{
+	heap_tracker_free(addr);
+}
+
+#if defined(CONFIG_MEMFAULT)
+static struct k_work_delayable metrics_work;
+
+/* Heartbeat metrics are cleared when a heartbeat is collected, so keeping the maximum of
+ * the current value gives the peak of the heartbeat.
+ */
+static void metric_max_set(MemfaultMetricId key, uint32_t value)
+{
+	uint32_t current = 0;
+
+	(void)memfault_metrics_heartbeat_read_unsigned(key, &current);
+	(void)memfault_metrics_heartbeat_set_unsigned(key, MAX(current, value));
+}
+
+static void metric_set(enum heap_tag tag, size_t peak)
+{
+	switch (tag) {
+	HEAP_TRACKER_TAGS(HEAP_TRACKER_METRIC_SET)
+	default:
+		break;
+	}
+}
+
+static void metrics_work_fn(struct k_work *work)
+{
+	struct heap_tracker_stats stats;
+	size_t peak[HEAP_TAG_COUNT];
+	uint32_t failures = 0;
+	k_spinlock_key_t key;
+
+	heap_tracker_stats_get(&stats);
+
+	key = k_spin_lock(&lock);
+
+	for (size_t i = 0; i < HEAP_TAG_COUNT; i++) {
+		peak[i] = window_peak[i];
+		window_peak[i] = tags[i].live;
+	}
+
+	k_spin_unlock(&lock, key);
+
+	for (size_t i = 0; i < HEAP_TAG_COUNT; i++) {
+		metric_set(i, peak[i]);
+		failures += stats.tags[i].failures;
+	}
+
+	metric_max_set(MEMFAULT_METRICS_KEY(HeapUntagged), stats.untagged);
+	(void)memfault_metrics_heartbeat_set_unsigned(MEMFAULT_METRICS_KEY(HeapLargestFree),
+						      stats.largest_free);
+	(void)memfault_metrics_heartbeat_set_unsigned(MEMFAULT_METRICS_KEY(HeapAllocFailures),
+						      failures);
+
+	k_work_reschedule(&metrics_work, K_SECONDS(CONFIG_HEAP_TRACKER_METRICS_INTERVAL_SEC));
+}
+
+static int metrics_init(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	k_work_init_delayable(&metrics_work, metrics_work_fn);
+	k_work_reschedule(&metrics_work, K_SECONDS(CONFIG_HEAP_TRACKER_METRICS_INTERVAL_SEC));
+
+	return 0;
+}
+
+SYS_INIT(metrics_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+#endif /* CONFIG_MEMFAULT */
+
+#if defined(CONFIG_SHELL)
+static int cmd_heap_tracker(const struct shell *shell, size_t argc, char **argv)
+{
+	struct heap_tracker_stats stats;
+
+	heap_tracker_stats_get(&stats);
+
+	shell_print(shell, "%-12s %8s %8s %8s %8s", "tag", "live", "peak", "allocs", "failures");
+
+	for (size_t i = 0; i < HEAP_TAG_COUNT; i++) {
+		shell_print(shell, "%-12s %8d %8d %8d %8d", tag_names[i], stats.tags[i].live,
+			    stats.tags[i].peak, stats.tags[i].allocs, stats.tags[i].failures);
+	}
+
+	shell_print(shell, "%-12s %8d", "untagged", stats.untagged);
+	shell_print(shell, "free %d bytes, largest free block %d bytes", stats.free,
+		    stats.largest_free);
+
+	return 0;
+}
+
+SHELL_CMD_REGISTER(heap_tracker, NULL, "Print system heap usage per subsystem",
+		   cmd_heap_tracker);
+#endif /* CONFIG_SHELL */
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef _HEAP_TRACKER_H_
+#define _HEAP_TRACKER_H_
+
+/**@file
+ *@brief Attribution of system heap allocations to the subsystems that own them.
+ *
+ * Allocations made with heap_tracker_alloc() carry a small header with the owner tag and the
+ * size, and the live bytes, peak and number of failed allocations are kept per tag. Memory
+ * allocated with plain k_malloc(), such as cJSON objects of the codecs and buffers of the
+ * cloud libraries, is reported as untagged. The largest free block is found by probing the
+ * heap with the heap lock held.
+ *
+ * The statistics are printed with the "heap_tracker" shell command, logged when an
+ * allocation fails, and reported as Memfault metrics.
+ */
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Owners of tagged allocations. */
+enum heap_tag {
+	/** Application Event Manager events. */
+	HEAP_TAG_EVENT,
+	/** Custom command payloads and responses in the application module. */
+	HEAP_TAG_CUSTOM_CMD,
+	/** Copies of custom data received from the cloud. */
+	HEAP_TAG_CLOUD_RX,
+	/** Memfault chunks sent over the cloud connection. */
+	HEAP_TAG_MEMFAULT,
+	HEAP_TAG_COUNT,
+};
+
+/** Statistics of one tag, sizes exclude the allocation header. */
+struct heap_tag_stats {
+	/** Bytes currently allocated. */
+	size_t live;
+	/** Highest number of bytes allocated at the same time. */
+	size_t peak;
+	/** Number of successful allocations. */
+	uint32_t allocs;
+	/** Number of failed allocations. */
+	uint32_t failures;
+};
+
+/** Statistics of the system heap. */
+struct heap_tracker_stats {
+	struct heap_tag_stats tags[HEAP_TAG_COUNT];
+	/** Bytes allocated outside of the tracker. Includes the allocator overhead of all blocks,
+	 *  the chunk headers and rounding, but not the headers of the tracker.
+	 */
+	size_t untagged;
+	/** Free bytes in the system heap. */
+	size_t free;
+	/** Largest block that can currently be allocated. */
+	size_t largest_free;
+};
+
+#if defined(CONFIG_HEAP_TRACKER)
+
+/** @brief Allocate memory from the system heap on behalf of a subsystem.
+ *
+ *  @param[in] tag Owner of the allocation.
+ *  @param[in] size Number of bytes.
+ *
+ *  @return Pointer to the memory, or NULL if the allocation failed.
+ */
+void *heap_tracker_alloc(enum heap_tag tag, size_t size);
+
+/** @brief Free memory. Memory allocated with k_malloc() is accepted as well, so that buffers
+ *	   of mixed origin, such as QoS message payloads, can be released in one place.
+ *
+ *  @param[in] ptr Pointer to the memory, may be NULL.
+ */
+void heap_tracker_free(void *ptr);
+
+/** @brief Get the heap statistics.
+ *
+ *  @param[out] stats Statistics.
+ */
+void heap_tracker_stats_get(struct heap_tracker_stats *stats);
+
+#else
+
+static inline void *heap_tracker_alloc(enum heap_tag tag, size_t size)
+{
+	ARG_UNUSED(tag);
+	return k_malloc(size);
+}
+
+static inline void heap_tracker_free(void *ptr)
+{
+	k_free(ptr);
+}
+
+#endif /* CONFIG_HEAP_TRACKER */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HEAP_TRACKER_H_ */
@@ -12,6 +12,7 @@
 #include <modem/location.h>
 #include <modem/modem_info.h>
 #include <nrf_modem_gnss.h>
+#include <zephyr/sys/crc.h>
 
 #define MODULE location_module
 
@@ -25,6 +26,13 @@
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(MODULE, CONFIG_LOCATION_MODULE_LOG_LEVEL);
 
+/* Define a custom STATIC macro that exposes internal variables when unit testing. */
+#if defined(CONFIG_UNITY)
+#define STATIC
+#else
+#define STATIC static
+#endif
+
 BUILD_ASSERT(CONFIG_AT_MONITOR_HEAP_SIZE >= 1024,
 	    "CONFIG_AT_MONITOR_HEAP_SIZE must be >= 1024 to fit neighbor cell measurements "
 	    "and other notifications at the same time");
@@ -78,6 +86,59 @@ static struct module_stats {
 	uint8_t satellites_tracked;
 } stats;
 
+#if defined(CONFIG_LOCATION_MODULE_METHOD_SELECTION)
+/* GNSS and cellular performance observed in recently visited cells, used to skip GNSS and
+ * shorten the GNSS timeout where fixes are unlikely or expensive, for instance indoors. Counts
+ * are halved when attempts reaches METHOD_STATS_DECAY_LIMIT so that older results are gradually
+ * forgotten.
+ */
+#define METHOD_STATS_DECAY_LIMIT 16
+
+#define GNSS_CURRENT_MA CONFIG_LOCATION_MODULE_METHOD_SELECTION_GNSS_CURRENT_MA
+#define GNSS_CHARGE_PER_FIX_MAX CONFIG_LOCATION_MODULE_METHOD_SELECTION_GNSS_CHARGE_PER_FIX_MAX
+
+static struct method_stats {
+	uint32_t cell_id;
+	/* Uptime when the entry was last used, used to replace the least recently used entry. */
+	int64_t last_used;
+	uint8_t gnss_attempts;
+	uint8_t gnss_successes;
+	/* Location requests without GNSS since GNSS was last attempted. */
+	uint8_t gnss_skipped;
+	/* Average GNSS time to fix in milliseconds. */
+	uint32_t gnss_ttf_avg;
+	/* Estimated charge spent on GNSS in this cell, in millicoulombs. */
+	uint32_t gnss_charge;
+	uint8_t cellular_attempts;
+	/* Cellular attempts where the modem measured the serving cell. */
+	uint8_t cellular_successes;
+} method_stats[CONFIG_LOCATION_MODULE_METHOD_SELECTION_CELLS];
+
+/* Current cell, reported by the modem module. */
+static uint32_t current_cell_id = UINT32_MAX;
+
+/* Statistics entry for the ongoing location request, NULL if the cell is not known. */
+static struct method_stats *method_stats_active;
+
+/* Set while GNSS is attempted in the ongoing location request. */
+static bool method_gnss_pending;
+#endif /* CONFIG_LOCATION_MODULE_METHOD_SELECTION */
+
+#if defined(CONFIG_LOCATION_MODULE_NEIGHBOR_CELLS_CACHE)
+/* Recently reported cell sets. An entry is refreshed when its fingerprint is seen after it has
+ * expired, otherwise the oldest entry is replaced.
+ */
+STATIC struct neighbor_cells_cache_entry {
+	/* Fingerprint of the cell set, see neighbor_cells_fingerprint(). */
+	uint32_t fingerprint;
+	/* Uptime when the cell set was last reported. */
+	int64_t uptime;
+	bool valid;
+} neighbor_cells_cache[CONFIG_LOCATION_MODULE_NEIGHBOR_CELLS_CACHE_SIZE];
+
+STATIC size_t neighbor_cells_cache_next;
+#endif /* CONFIG_LOCATION_MODULE_NEIGHBOR_CELLS_CACHE */
+
 static struct module_data self = {
 	.name = "location",
 	.msg_q = NULL,
@@ -227,6 +288,156 @@ static void data_send_pvt(void)
 	APP_EVENT_SUBMIT(location_module_event);
 }
 
+#if defined(CONFIG_LOCATION_MODULE_METHOD_SELECTION)
+static struct method_stats *method_stats_get(uint32_t cell_id)
+{
+	struct method_stats *entry = &method_stats[0];
+
+	for (size_t i = 0; i < ARRAY_SIZE(method_stats); i++) {
+		if (method_stats[i].cell_id == cell_id && method_stats[i].last_used != 0) {
+			entry = &method_stats[i];
+			goto exit;
+		}
+
+		if (method_stats[i].last_used < entry->last_used) {
+			entry = &method_stats[i];
+		}
+	}
+
+	memset(entry, 0, sizeof(*entry));
+	entry->cell_id = cell_id;
+
+exit:
+	entry->last_used = k_uptime_get();
+	return entry;
+}
+
+/* Returns true if cellular has mostly worked in the cell, or has not been tried often enough
+ * to tell.
+ */
+static bool method_selection_cellular_reliable(const struct method_stats *entry)
+{
+	if (entry->cellular_attempts < CONFIG_LOCATION_MODULE_METHOD_SELECTION_ATTEMPTS_MIN) {
+		return true;
+	}
+
+	return (entry->cellular_successes * 100 / entry->cellular_attempts) >=
+	       CONFIG_LOCATION_MODULE_METHOD_SELECTION_SUCCESS_RATE_MIN;
+}
+
+/* Returns true if GNSS should be attempted in the current cell. */
+static bool method_selection_gnss_use(struct method_stats *entry)
+{
+	uint32_t success_rate;
+	uint32_t charge_per_fix;
+
+	if (entry->gnss_attempts < CONFIG_LOCATION_MODULE_METHOD_SELECTION_ATTEMPTS_MIN) {
+		return true;
+	}
+
+	/* Cellular is the only fallback, GNSS is kept where cellular rarely works either. */
+	if (!method_selection_cellular_reliable(entry)) {
+		return true;
+	}
+
+	success_rate = entry->gnss_successes * 100 / entry->gnss_attempts;
+	charge_per_fix = (entry->gnss_successes > 0) ?
+			 entry->gnss_charge / entry->gnss_successes : UINT32_MAX;
+
+	if ((success_rate >= CONFIG_LOCATION_MODULE_METHOD_SELECTION_SUCCESS_RATE_MIN) &&
+	    ((GNSS_CHARGE_PER_FIX_MAX == 0) || (charge_per_fix <= GNSS_CHARGE_PER_FIX_MAX))) {
+		return true;
+	}
+
+	/* Try GNSS now and then, conditions in the cell may have changed. */
+	if (entry->gnss_skipped >= CONFIG_LOCATION_MODULE_METHOD_SELECTION_GNSS_RETRY_INTERVAL) {
+		return true;
+	}
+
+	LOG_DBG("Skipping GNSS in cell %d, success rate %d%%, %d mC spent per fix",
+		entry->cell_id, success_rate, charge_per_fix);
+
+	entry->gnss_skipped++;
+	return false;
+}
+
+/* GNSS timeout in seconds, about twice the time to fix that is usually seen in the cell. */
+static int method_selection_gnss_timeout(const struct method_stats *entry)
+{
+	uint32_t timeout;
+
+	if (entry->gnss_successes == 0) {
+		return DATA_FETCH_TIMEOUT_GNSS_SEARCH;
+	}
+
+	timeout = 2 * entry->gnss_ttf_avg / MSEC_PER_SEC;
+
+	timeout = MAX(timeout, CONFIG_LOCATION_MODULE_METHOD_SELECTION_GNSS_TIMEOUT_MIN);
+
+	return MIN(timeout, DATA_FETCH_TIMEOUT_GNSS_SEARCH);
+}
+
+static void method_selection_gnss_result(bool success, uint32_t search_time)
+{
+	struct method_stats *entry = method_stats_active;
+
+	if ((entry == NULL) || !method_gnss_pending) {
+		return;
+	}
+
+	method_gnss_pending = false;
+
+	if (entry->gnss_attempts >= METHOD_STATS_DECAY_LIMIT) {
+		entry->gnss_attempts /= 2;
+		entry->gnss_successes /= 2;
+		entry->gnss_charge /= 2;
+	}
+
+	entry->gnss_attempts++;
+	entry->gnss_skipped = 0;
+	entry->gnss_charge += search_time * GNSS_CURRENT_MA / MSEC_PER_SEC;
+
+	if (success) {
+		entry->gnss_successes++;
+		entry->gnss_ttf_avg = (entry->gnss_successes == 1) ? search_time :
+				      (3 * entry->gnss_ttf_avg + search_time) / 4;
+	}
+
+	LOG_DBG("GNSS in cell %d: %d/%d successful, average time to fix %d ms, %d mC spent",
+		entry->cell_id, entry->gnss_successes, entry->gnss_attempts,
+		entry->gnss_ttf_avg, entry->gnss_charge);
+}
+
+/* Cellular is the last method of a location request, so the request is finished. */
+static void method_selection_cellular_result(bool success)
+{
+	struct method_stats *entry = method_stats_active;
+
+	if (entry == NULL) {
+		return;
+	}
+
+	/* Cellular is only used after GNSS has failed, if GNSS was attempted. */
+	method_selection_gnss_result(false, (uint32_t)(k_uptime_get() - stats.start_uptime));
+
+	method_stats_active = NULL;
+
+	if (entry->cellular_attempts >= METHOD_STATS_DECAY_LIMIT) {
+		entry->cellular_attempts /= 2;
+		entry->cellular_successes /= 2;
+	}
+
+	entry->cellular_attempts++;
+
+	if (success) {
+		entry->cellular_successes++;
+	}
+
+	LOG_DBG("Cellular in cell %d: %d/%d successful", entry->cell_id,
+		entry->cellular_successes, entry->cellular_attempts);
+}
+#endif /* CONFIG_LOCATION_MODULE_METHOD_SELECTION */
+
 static void search_start(void)
 {
 	int err;
@@ -235,6 +446,27 @@ static void search_start(void)
 	int methods_count = 0;
 	int methods_index_gnss = -1;
 	int methods_index_cellular = -1;
+	bool gnss_use = !copy_cfg.no_data.gnss;
+	int gnss_timeout = DATA_FETCH_TIMEOUT_GNSS_SEARCH;
+
+#if defined(CONFIG_LOCATION_MODULE_METHOD_SELECTION)
+	method_stats_active = NULL;
+	method_gnss_pending = false;
+
+	if (current_cell_id != UINT32_MAX) {
+		method_stats_active = method_stats_get(current_cell_id);
+
+		/* Only skip GNSS when there is another method to fall back on. */
+		if (gnss_use && !copy_cfg.no_data.neighbor_cell) {
+			gnss_use = method_selection_gnss_use(method_stats_active);
+			if (gnss_use) {
+				gnss_timeout = method_selection_gnss_timeout(method_stats_active);
+			}
+		}
+
+		method_gnss_pending = gnss_use;
+	}
+#endif
 
 	if (copy_cfg.no_data.neighbor_cell && copy_cfg.no_data.gnss) {
 		SEND_EVENT(location, LOCATION_MODULE_EVT_DATA_NOT_READY);
@@ -242,7 +474,7 @@ static void search_start(void)
 		return;
 	}
 
-	if (!copy_cfg.no_data.gnss) {
+	if (gnss_use) {
 		methods[methods_count] = LOCATION_METHOD_GNSS;
 		methods_index_gnss = methods_count;
 		methods_count++;
@@ -259,8 +491,7 @@ static void search_start(void)
 	config.timeout = copy_cfg.location_timeout * MSEC_PER_SEC;
 
 	if (methods_index_gnss != -1) {
-		config.methods[methods_index_gnss].gnss.timeout =
-			DATA_FETCH_TIMEOUT_GNSS_SEARCH * MSEC_PER_SEC;
+		config.methods[methods_index_gnss].gnss.timeout = gnss_timeout * MSEC_PER_SEC;
 	}
 
 	if (methods_index_cellular != -1) {
@@ -274,6 +505,9 @@ static void search_start(void)
 	if (err) {
 		SEND_EVENT(location, LOCATION_MODULE_EVT_DATA_NOT_READY);
 		LOG_ERR("Location request failed: %d", err);
+#if defined(CONFIG_LOCATION_MODULE_METHOD_SELECTION)
+		method_stats_active = NULL;
+#endif
 		return;
 	}
 
@@ -321,6 +555,85 @@ static inline int adjust_rsrq(int input)
 	return input;
 }
 
+#if defined(CONFIG_LOCATION_MODULE_NEIGHBOR_CELLS_CACHE)
+static inline uint32_t rsrp_quantize(int rsrp)
+{
+	return (uint32_t)rsrp / CONFIG_LOCATION_MODULE_NEIGHBOR_CELLS_CACHE_RSRP_STEP;
+}
+
+/* Compute a fingerprint from the RSRP indexes reported by the modem, before any conversion. */
+static uint32_t neighbor_cells_fingerprint(const struct lte_lc_cells_info *cell_info)
+{
+	const struct lte_lc_cell *cell = &cell_info->current_cell;
+	uint32_t fingerprint;
+	uint32_t cell_key[] = {
+		cell->mcc, cell->mnc, cell->id, cell->tac, cell->earfcn,
+		rsrp_quantize(cell->rsrp)
+	};
+
+	fingerprint = crc32_ieee((uint8_t *)cell_key, sizeof(cell_key));
+
+	/* Neighbor cells are summed so that the fingerprint does not depend on the order in
+	 * which the modem reports them.
+	 */
+	for (size_t i = 0; i < cell_info->ncells_count; i++) {
+		const struct lte_lc_ncell *ncell = &cell_info->neighbor_cells[i];
+		uint32_t ncell_key[] = {
+			ncell->earfcn, ncell->phys_cell_id, rsrp_quantize(ncell->rsrp)
+		};
+
+		fingerprint += crc32_ieee((uint8_t *)ncell_key, sizeof(ncell_key));
+	}
+
+	return fingerprint;
+}
+
+static bool neighbor_cells_cache_entry_fresh(const struct neighbor_cells_cache_entry *entry)
+{
+	return entry->valid &&
+	       (k_uptime_get() - entry->uptime) <
+	       (CONFIG_LOCATION_MODULE_NEIGHBOR_CELLS_CACHE_MAX_AGE_SEC * MSEC_PER_SEC);
+}
+
+/* Look up the cell set in the cache. Returns true if the cell set has been reported recently,
+ * in which case LOCATION_MODULE_EVT_NEIGHBOR_CELLS_DATA_UNCHANGED has been sent instead of the
+ * measurements.
+ */
+static bool neighbor_cells_cache_handle(const struct lte_lc_cells_info *cell_info)
+{
+	uint32_t fingerprint = neighbor_cells_fingerprint(cell_info);
+	struct neighbor_cells_cache_entry *entry = NULL;
+
+	for (size_t i = 0; i < ARRAY_SIZE(neighbor_cells_cache); i++) {
+		if (neighbor_cells_cache[i].valid &&
+		    neighbor_cells_cache[i].fingerprint == fingerprint) {
+			entry = &neighbor_cells_cache[i];
+			break;
+		}
+	}
+
+	if (entry && neighbor_cells_cache_entry_fresh(entry)) {
+		LOG_DBG("Cell set 0x%08x unchanged, measurements not forwarded", fingerprint);
+		SEND_EVENT(location, LOCATION_MODULE_EVT_NEIGHBOR_CELLS_DATA_UNCHANGED);
+		return true;
+	}
+
+	if (!entry) {
+		entry = &neighbor_cells_cache[neighbor_cells_cache_next];
+		neighbor_cells_cache_next = (neighbor_cells_cache_next + 1) %
+					    ARRAY_SIZE(neighbor_cells_cache);
+	}
+
+	entry->fingerprint = fingerprint;
+	entry->uptime = k_uptime_get();
+	entry->valid = true;
+
+	LOG_DBG("New cell set 0x%08x", fingerprint);
+
+	return false;
+}
+#endif /* CONFIG_LOCATION_MODULE_NEIGHBOR_CELLS_CACHE */
+
 static void send_neighbor_cell_update(struct lte_lc_cells_info *cell_info)
 {
 	struct location_module_event *evt = new_location_module_event();
@@ -397,7 +710,15 @@ void location_event_handler(const struct location_event_data *event_data)
 				time_set();
 			}
 			data_send_pvt();
+#if defined(CONFIG_LOCATION_MODULE_METHOD_SELECTION)
+			method_selection_gnss_result(true, stats.search_time);
+#endif
+		}
+#if defined(CONFIG_LOCATION_MODULE_METHOD_SELECTION)
+		if (event_data->method == LOCATION_METHOD_CELLULAR) {
+			method_selection_cellular_result(true);
 		}
+#endif
 		LOG_DBG("  Google maps URL: https://maps.google.com/?q=%.06f,%.06f",
 			event_data->location.latitude, event_data->location.longitude);
 
@@ -424,7 +745,15 @@ void location_event_handler(const struct location_event_data *event_data)
 			stats.satellites_tracked =
 				event_data->error.details.gnss.satellites_tracked;
 			LOG_DBG("  satellites tracked: %d", stats.satellites_tracked);
+#if defined(CONFIG_LOCATION_MODULE_METHOD_SELECTION)
+			method_selection_gnss_result(false, stats.search_time);
+#endif
 		}
+#if defined(CONFIG_LOCATION_MODULE_METHOD_SELECTION)
+		if (event_data->method == LOCATION_METHOD_CELLULAR) {
+			method_selection_cellular_result(false);
+		}
+#endif
 
 		timeout_send();
 		inactive_send();
@@ -432,6 +761,13 @@ void location_event_handler(const struct location_event_data *event_data)
 
 	case LOCATION_EVT_ERROR:
 		LOG_WRN("Getting location failed");
+#if defined(CONFIG_LOCATION_MODULE_METHOD_SELECTION)
+		if (event_data->method == LOCATION_METHOD_CELLULAR) {
+			method_selection_cellular_result(false);
+		}
+
+		method_stats_active = NULL;
+#endif
 		SEND_EVENT(location, LOCATION_MODULE_EVT_DATA_NOT_READY);
 		inactive_send();
 		break;
@@ -463,6 +799,17 @@ void location_event_handler(const struct location_event_data *event_data)
 #if defined(CONFIG_LOCATION_METHOD_CELLULAR_EXTERNAL)
 	case LOCATION_EVT_CELLULAR_EXT_REQUEST:
 		LOG_DBG("Getting cellular request");
+#if defined(CONFIG_LOCATION_MODULE_METHOD_SELECTION)
+		method_selection_cellular_result(event_data->cellular_request.current_cell.id !=
+						 LTE_LC_CELL_EUTRAN_ID_INVALID);
+#endif
+#if defined(CONFIG_LOCATION_MODULE_NEIGHBOR_CELLS_CACHE)
+		if (neighbor_cells_cache_handle(&event_data->cellular_request)) {
+			location_cellular_ext_result_set(LOCATION_CELLULAR_EXT_RESULT_UNKNOWN,
+							 NULL);
+			break;
+		}
+#endif
 		send_neighbor_cell_update(
 			(struct lte_lc_cells_info *)&event_data->cellular_request);
 		location_cellular_ext_result_set(LOCATION_CELLULAR_EXT_RESULT_UNKNOWN, NULL);
@@ -578,6 +925,12 @@ static void on_all_states(struct location_msg_data *msg)
 	    (IS_EVENT(msg, data, DATA_EVT_CONFIG_READY))) {
 		copy_cfg = msg->module.data.data.cfg;
 	}
+
+#if defined(CONFIG_LOCATION_MODULE_METHOD_SELECTION)
+	if (IS_EVENT(msg, modem, MODEM_EVT_LTE_CELL_UPDATE)) {
+		current_cell_id = msg->module.modem.data.cell.cell_id;
+	}
+#endif
 }
 
 static void message_handler(struct location_msg_data *msg)
@@ -7,9 +7,11 @@
 #include <zephyr/kernel.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <app_event_manager.h>
 #include <math.h>
 #include <nrf_modem.h>
+#include <nrf_modem_at.h>
 #include <modem/lte_lc.h>
 #include <modem/modem_info.h>
 #include <modem/pdn.h>
@@ -17,6 +19,8 @@
 #define MODULE modem_module
 
 #include "modules_common.h"
+#include "at_profiler.h"
+#include "boot_init.h"
 #include "events/app_module_event.h"
 #include "events/data_module_event.h"
 #include "events/modem_module_event.h"
@@ -64,14 +68,33 @@ enum sample_type {
 	BATTERY_VOLTAGE
 };
 
-/* Struct that holds data from the modem information module. */
-static struct modem_param_info modem_param;
+/* Static modem data does not change while the application runs and is only read once. */
+static struct modem_module_static_modem_data static_data;
+static bool static_data_valid;
 
-/* Value that holds the latest RSRP value. */
-static int16_t rsrp_value_latest;
+/* Dynamic modem data that is not reported through notifications and must be queried with
+ * AT commands. A bit is set in modem_state_stale when the corresponding value may have changed.
+ */
+enum modem_state_query {
+	MODEM_STATE_CELL,
+	MODEM_STATE_BAND,
+	MODEM_STATE_OPERATOR,
+	/* APN and IP address. */
+	MODEM_STATE_PDN,
+	MODEM_STATE_COUNT,
+};
 
-/* Value that holds the latest LTE network mode. */
-static enum lte_lc_lte_mode nw_mode_latest;
+/* Latest dynamic modem data. RSRP, LTE mode, cell ID and area code are updated from
+ * notifications, the rest is queried when stale before it is sampled.
+ */
+static struct modem_module_dynamic_modem_data modem_state = {
+	.rsrp = UINT8_MAX,
+	.nw_mode = LTE_LC_LTE_MODE_NONE,
+};
+
+static struct k_spinlock modem_state_lock;
+
+static atomic_t modem_state_stale = ATOMIC_INIT(BIT_MASK(MODEM_STATE_COUNT));
 
 const k_tid_t module_thread;
 
@@ -93,6 +116,7 @@ static void send_cell_update(uint32_t cell_id, uint32_t tac);
 static void send_psm_update(int tau, int active_time);
 static void send_edrx_update(float edrx, float ptw);
 static inline int adjust_rsrp(int input);
+static void modem_state_cell_set(uint32_t cell_id, uint32_t tac);
 
 /* Convenience functions used in internal state handling. */
 static char *state2str(enum state_type state)
@@ -194,6 +218,9 @@ static void lte_evt_handler(const struct lte_lc_evt *const evt)
 			LOG_DBG("Network registration status: %s",
 				evt->nw_reg_status == LTE_LC_NW_REG_REGISTERED_HOME ?
 				"Connected - home network" : "Connected - roaming");
+
+			atomic_set_bit(&modem_state_stale, MODEM_STATE_OPERATOR);
+			atomic_set_bit(&modem_state_stale, MODEM_STATE_BAND);
 		}
 
 		break;
@@ -226,10 +253,17 @@ static void lte_evt_handler(const struct lte_lc_evt *const evt)
 		LOG_DBG("LTE cell changed: Cell ID: %d, Tracking area: %d",
 			evt->cell.id, evt->cell.tac);
 		send_cell_update(evt->cell.id, evt->cell.tac);
+		modem_state_cell_set(evt->cell.id, evt->cell.tac);
 		break;
-	case LTE_LC_EVT_LTE_MODE_UPDATE:
-		nw_mode_latest = evt->lte_mode;
+	case LTE_LC_EVT_LTE_MODE_UPDATE: {
+		k_spinlock_key_t key = k_spin_lock(&modem_state_lock);
+
+		modem_state.nw_mode = evt->lte_mode;
+		k_spin_unlock(&modem_state_lock, key);
+
+		atomic_set_bit(&modem_state_stale, MODEM_STATE_BAND);
 		break;
+	}
 	case LTE_LC_EVT_MODEM_EVENT:
 		LOG_DBG("Modem domain event, type: %s",
 			evt->modem_evt == LTE_LC_MODEM_EVT_LIGHT_SEARCH_DONE ?
@@ -302,17 +336,22 @@ void pdn_event_handler(uint8_t cid, enum pdn_event event, int reason)
 		break;
 	case PDN_EVENT_ACTIVATED:
 		LOG_DBG("PDN_EVENT_ACTIVATED");
+		atomic_set_bit(&modem_state_stale, MODEM_STATE_PDN);
+		boot_stage_done(BOOT_STAGE_LTE_CONNECTED);
 		{ SEND_EVENT(modem, MODEM_EVT_LTE_CONNECTED); }
 		break;
 	case PDN_EVENT_DEACTIVATED:
 		LOG_DBG("PDN_EVENT_DEACTIVATED");
+		atomic_set_bit(&modem_state_stale, MODEM_STATE_PDN);
 		{ SEND_EVENT(modem, MODEM_EVT_LTE_DISCONNECTED); }
 		break;
 	case PDN_EVENT_IPV6_UP:
 		LOG_DBG("PDN_EVENT_IPV6_UP");
+		atomic_set_bit(&modem_state_stale, MODEM_STATE_PDN);
 		break;
 	case PDN_EVENT_IPV6_DOWN:
 		LOG_DBG("PDN_EVENT_IPV6_DOWN");
+		atomic_set_bit(&modem_state_stale, MODEM_STATE_PDN);
 		break;
 	default:
 		LOG_WRN("Unexpected PDN event!");
@@ -330,15 +369,13 @@ static void modem_rsrp_handler(char rsrp_value)
 		return;
 	}
 
-	/* Set temporary variable to hold RSRP value. RSRP callbacks and other
-	 * data from the modem info module are retrieved separately.
-	 * This temporarily saves the latest value which are sent to
-	 * the Data module upon a modem data request.
-	 */
-	rsrp_value_latest = adjust_rsrp(rsrp_value);
+	/* Keep the latest value, it is sent to the Data module upon a modem data request. */
+	k_spinlock_key_t key = k_spin_lock(&modem_state_lock);
+
+	modem_state.rsrp = adjust_rsrp(rsrp_value);
+	k_spin_unlock(&modem_state_lock, key);
 
-	LOG_DBG("Incoming RSRP status message, RSRP value is %d",
-		rsrp_value_latest);
+	LOG_DBG("Incoming RSRP status message, RSRP value is %d", adjust_rsrp(rsrp_value));
 }
 
 #ifdef CONFIG_LWM2M_CARRIER
@@ -531,65 +568,195 @@ static inline int adjust_rsrp(int input)
 	return input;
 }
 
-static int static_modem_data_get(void)
+static int static_modem_data_read(struct modem_module_static_modem_data *data)
 {
 	int err;
+	uint32_t start;
+
+	strncpy(data->app_version, CONFIG_ASSET_TRACKER_V2_APP_VERSION,
+		sizeof(data->app_version) - 1);
+	data->app_version[sizeof(data->app_version) - 1] = '\0';
+
+	strncpy(data->board_version, CONFIG_BOARD, sizeof(data->board_version) - 1);
+	data->board_version[sizeof(data->board_version) - 1] = '\0';
+
+	/* Only the values that are sent are read, one AT command each. */
+	start = at_profiler_start();
+	err = modem_info_string_get(MODEM_INFO_FW_VERSION, data->modem_fw,
+				    sizeof(data->modem_fw));
+	at_profiler_stop("AT+CGMR", start);
+	if (err < 0) {
+		LOG_ERR("Reading modem firmware version failed, error: %d", err);
+		return err;
+	}
 
-	/* Request data from modem information module. */
-	err = modem_info_params_get(&modem_param);
-	if (err) {
-		LOG_ERR("modem_info_params_get, error: %d", err);
+	start = at_profiler_start();
+	err = modem_info_string_get(MODEM_INFO_ICCID, data->iccid, sizeof(data->iccid));
+	at_profiler_stop("AT%XICCID", start);
+	if (err < 0) {
+		LOG_ERR("Reading ICCID failed, error: %d", err);
+		return err;
+	}
+
+	start = at_profiler_start();
+	err = modem_info_string_get(MODEM_INFO_IMEI, data->imei, sizeof(data->imei));
+	at_profiler_stop("AT+CGSN", start);
+	if (err < 0) {
+		LOG_ERR("Reading IMEI failed, error: %d", err);
 		return err;
 	}
 
+	return 0;
+}
+
+static int static_modem_data_get(void)
+{
+	int err;
+
+	if (!static_data_valid) {
+		err = static_modem_data_read(&static_data);
+		if (err) {
+			return err;
+		}
+
+		static_data_valid = true;
+	}
+
 	struct modem_module_event *modem_module_event = new_modem_module_event();
 
 	__ASSERT(modem_module_event, "Not enough heap left to allocate event");
 
-	strncpy(modem_module_event->data.modem_static.app_version,
-		CONFIG_ASSET_TRACKER_V2_APP_VERSION,
-		sizeof(modem_module_event->data.modem_static.app_version) - 1);
+	modem_module_event->data.modem_static = static_data;
+	modem_module_event->data.modem_static.timestamp = k_uptime_get();
+	modem_module_event->type = MODEM_EVT_MODEM_STATIC_DATA_READY;
 
-	strncpy(modem_module_event->data.modem_static.board_version,
-		modem_param.device.board,
-		sizeof(modem_module_event->data.modem_static.board_version) - 1);
+	APP_EVENT_SUBMIT(modem_module_event);
+	return 0;
+}
 
-	strncpy(modem_module_event->data.modem_static.modem_fw,
-		modem_param.device.modem_fw.value_string,
-		sizeof(modem_module_event->data.modem_static.modem_fw) - 1);
+static void modem_state_cell_set(uint32_t cell_id, uint32_t tac)
+{
+	k_spinlock_key_t key = k_spin_lock(&modem_state_lock);
 
-	strncpy(modem_module_event->data.modem_static.iccid,
-		modem_param.sim.iccid.value_string,
-		sizeof(modem_module_event->data.modem_static.iccid) - 1);
+	modem_state.cell_id = cell_id;
+	modem_state.area_code = tac;
+	k_spin_unlock(&modem_state_lock, key);
 
-	strncpy(modem_module_event->data.modem_static.imei,
-		modem_param.device.imei.value_string,
-		sizeof(modem_module_event->data.modem_static.imei) - 1);
+	/* The band and operator can change with the cell. */
+	atomic_clear_bit(&modem_state_stale, MODEM_STATE_CELL);
+	atomic_set_bit(&modem_state_stale, MODEM_STATE_BAND);
+	atomic_set_bit(&modem_state_stale, MODEM_STATE_OPERATOR);
+}
 
-	modem_module_event->data.modem_static.app_version
-		[sizeof(modem_module_event->data.modem_static.app_version) - 1] = '\0';
+static int modem_state_query(enum modem_state_query query)
+{
+	uint32_t start = at_profiler_start();
+	uint16_t value;
+	int err;
+
+	switch (query) {
+	case MODEM_STATE_CELL: {
+		uint32_t tac, cell_id;
 
-	modem_module_event->data.modem_static.board_version
-		[sizeof(modem_module_event->data.modem_static.board_version) - 1] = '\0';
+		/* Cell ID and tracking area code are read with a single command. */
+		err = nrf_modem_at_scanf("AT+CEREG?", "+CEREG: %*u,%*u,\"%x\",\"%x\"",
+					 &tac, &cell_id);
+		at_profiler_stop("AT+CEREG?", start);
+		if (err < 0) {
+			return err;
+		}
 
-	modem_module_event->data.modem_static.modem_fw
-		[sizeof(modem_module_event->data.modem_static.modem_fw) - 1] = '\0';
+		/* The tracking area code and cell ID are absent while the device is not
+		 * registered. The last known cell is kept, it is updated by the next
+		 * registration notification.
+		 */
+		if (err < 2) {
+			LOG_DBG("Not registered, cell unknown");
+			return 0;
+		}
 
-	modem_module_event->data.modem_static.iccid
-		[sizeof(modem_module_event->data.modem_static.iccid) - 1] = '\0';
+		modem_state_cell_set(cell_id, tac);
+		return 0;
+	}
+	case MODEM_STATE_BAND:
+		err = modem_info_short_get(MODEM_INFO_CUR_BAND, &value);
+		at_profiler_stop("AT%XCBAND", start);
+		if (err < 0) {
+			return err;
+		}
 
-	modem_module_event->data.modem_static.imei
-		[sizeof(modem_module_event->data.modem_static.imei) - 1] = '\0';
+		modem_state.band = value;
+		return 0;
+	case MODEM_STATE_OPERATOR: {
+		char mcc[4];
 
-	modem_module_event->data.modem_static.timestamp = k_uptime_get();
-	modem_module_event->type = MODEM_EVT_MODEM_STATIC_DATA_READY;
+		err = modem_info_string_get(MODEM_INFO_OPERATOR, modem_state.mccmnc,
+					    sizeof(modem_state.mccmnc));
+		at_profiler_stop("AT+COPS?", start);
+		if (err < 0) {
+			return err;
+		}
+
+		/* Provide MNC and MCC as separate values, the MCC is always three digits. */
+		strncpy(mcc, modem_state.mccmnc, 3);
+		mcc[3] = '\0';
+		modem_state.mcc = strtoul(mcc, NULL, 10);
+		modem_state.mnc = strtoul(&modem_state.mccmnc[3], NULL, 10);
+		return 0;
+	}
+	case MODEM_STATE_PDN: {
+		char apn[64] = "";
+		char ip_address[MODEM_IP_ADDRESS_LEN_MAX] = "";
+
+		BUILD_ASSERT(sizeof(ip_address) == 62, "Update the field width of the IP address");
+
+		/* APN and IP address of the default PDN context are read with a single command.
+		 * Empty fields end the match, the fields that were not read are reported as empty.
+		 */
+		err = nrf_modem_at_scanf("AT+CGDCONT?",
+					 "+CGDCONT: 0,\"%*[^\"]\",\"%63[^\"]\",\"%61[^\"]\"",
+					 apn, ip_address);
+		at_profiler_stop("AT+CGDCONT?", start);
+		if (err < 0) {
+			return err;
+		}
+
+		strncpy(modem_state.apn, apn, sizeof(modem_state.apn) - 1);
+		modem_state.apn[sizeof(modem_state.apn) - 1] = '\0';
+		strncpy(modem_state.ip_address, ip_address, sizeof(modem_state.ip_address) - 1);
+		modem_state.ip_address[sizeof(modem_state.ip_address) - 1] = '\0';
+		return 0;
+	}
+	default:
+		return -EINVAL;
+	}
+}
+
+/* Query the values that may have changed since they were last sampled. Values that have
+ * notifications are only queried until the first notification has been received.
+ */
+static int modem_state_refresh(void)
+{
+	int err;
+
+	for (int i = 0; i < MODEM_STATE_COUNT; i++) {
+		if (!atomic_test_and_clear_bit(&modem_state_stale, i)) {
+			continue;
+		}
+
+		err = modem_state_query(i);
+		if (err) {
+			LOG_ERR("Querying modem state %d failed, error: %d", i, err);
+			atomic_set_bit(&modem_state_stale, i);
+			return err;
+		}
+	}
 
-	APP_EVENT_SUBMIT(modem_module_event);
 	return 0;
 }
 
-static void populate_event_with_dynamic_modem_data(struct modem_module_event *event,
-						   struct modem_param_info *param)
+static void populate_event_with_dynamic_modem_data(
+	struct modem_module_event *event, const struct modem_module_dynamic_modem_data *state)
 {
 	/* If this flag is set all sampled parameter values will be included in the event regardless
 	 * if they have changed or not.
@@ -599,12 +766,6 @@ static void populate_event_with_dynamic_modem_data(struct modem_module_event *ev
 	/* Flag that checks if parameters has been added to the event. */
 	bool params_added = false;
 
-	/* Set all entries in the dynamic modem data structure to 0 to be sure that all 'fresh'
-	 * flags become false by default. This is to avoid sending garbage or old data due to a flag
-	 * being accidently set to true.
-	 */
-	memset(&event->data.modem_dynamic, 0, sizeof(struct modem_module_dynamic_modem_data));
-
 	/* Structure that holds previous sampled dynamic modem data. By default, set all members of
 	 * the structure to invalid values.
 	 */
@@ -613,106 +774,53 @@ static void populate_event_with_dynamic_modem_data(struct modem_module_event *ev
 		.nw_mode = LTE_LC_LTE_MODE_NONE,
 	};
 
-	/* Compare the latest sampled parameters with the previous. If there has been a change we
-	 * want to include the parameters in the event.
+	/* The 'fresh' flags are never set in the modem state, only the flags of the parameters
+	 * that have changed since the last sample are set below.
 	 */
-	if ((prev.rsrp != rsrp_value_latest) || include) {
-		event->data.modem_dynamic.rsrp = rsrp_value_latest;
-		prev.rsrp = rsrp_value_latest;
+	event->data.modem_dynamic = *state;
 
+	if ((prev.rsrp != state->rsrp) || include) {
 		event->data.modem_dynamic.rsrp_fresh = true;
 		params_added = true;
 	}
 
-	if ((prev.band != param->network.current_band.value) || include) {
-		event->data.modem_dynamic.band = param->network.current_band.value;
-		prev.band = param->network.current_band.value;
-
+	if ((prev.band != state->band) || include) {
 		event->data.modem_dynamic.band_fresh = true;
 		params_added = true;
 	}
 
-	if ((prev.nw_mode != nw_mode_latest) || include) {
-		event->data.modem_dynamic.nw_mode = nw_mode_latest;
-		prev.nw_mode = nw_mode_latest;
-
+	if ((prev.nw_mode != state->nw_mode) || include) {
 		event->data.modem_dynamic.nw_mode_fresh = true;
 		params_added = true;
 	}
 
-	if ((strcmp(prev.apn, param->network.apn.value_string) != 0) || include) {
-		strncpy(event->data.modem_dynamic.apn,
-			modem_param.network.apn.value_string,
-			sizeof(event->data.modem_dynamic.apn) - 1);
-
-		strncpy(prev.apn,
-			param->network.apn.value_string,
-			sizeof(prev.apn) - 1);
-
-		event->data.modem_dynamic.apn
-			[sizeof(event->data.modem_dynamic.apn) - 1] = '\0';
-
-		prev.apn[sizeof(prev.apn) - 1] = '\0';
-
+	if ((strcmp(prev.apn, state->apn) != 0) || include) {
 		event->data.modem_dynamic.apn_fresh = true;
 		params_added = true;
 	}
 
-	if ((strcmp(prev.ip_address, param->network.ip_address.value_string) != 0) || include) {
-		strncpy(event->data.modem_dynamic.ip_address,
-			modem_param.network.ip_address.value_string,
-			sizeof(event->data.modem_dynamic.ip_address) - 1);
-
-		strncpy(prev.ip_address,
-			param->network.ip_address.value_string,
-			sizeof(prev.ip_address) - 1);
-
-		event->data.modem_dynamic.ip_address
-			[sizeof(event->data.modem_dynamic.ip_address) - 1] = '\0';
-
-		prev.ip_address[sizeof(prev.ip_address) - 1] = '\0';
-
+	if ((strcmp(prev.ip_address, state->ip_address) != 0) || include) {
 		event->data.modem_dynamic.ip_address_fresh = true;
 		params_added = true;
 	}
 
-	if ((prev.cell_id != param->network.cellid_dec) || include) {
-		event->data.modem_dynamic.cell_id = param->network.cellid_dec;
-		prev.cell_id = param->network.cellid_dec;
-
+	if ((prev.cell_id != state->cell_id) || include) {
 		event->data.modem_dynamic.cell_id_fresh = true;
 		params_added = true;
 	}
 
-	if ((strcmp(prev.mccmnc, param->network.current_operator.value_string) != 0) || include) {
-		strncpy(event->data.modem_dynamic.mccmnc,
-			modem_param.network.current_operator.value_string,
-			sizeof(event->data.modem_dynamic.mccmnc));
-
-		strncpy(prev.mccmnc, param->network.current_operator.value_string,
-			sizeof(prev.mccmnc));
-
-		event->data.modem_dynamic.mccmnc
-			[sizeof(event->data.modem_dynamic.mccmnc) - 1] = '\0';
-
-		prev.mccmnc[sizeof(prev.mccmnc) - 1] = '\0';
-
-		/* Provide MNC and MCC as separate values. */
-		event->data.modem_dynamic.mcc = modem_param.network.mcc.value;
-		event->data.modem_dynamic.mnc = modem_param.network.mnc.value;
-
+	if ((strcmp(prev.mccmnc, state->mccmnc) != 0) || include) {
 		event->data.modem_dynamic.mccmnc_fresh = true;
 		params_added = true;
 	}
 
-	if ((prev.area_code != modem_param.network.area_code.value) || include) {
-		event->data.modem_dynamic.area_code = param->network.area_code.value;
-		prev.area_code = param->network.area_code.value;
-
+	if ((prev.area_code != state->area_code) || include) {
 		event->data.modem_dynamic.area_code_fresh = true;
 		params_added = true;
 	}
 
+	prev = *state;
+
 	if (params_added) {
 		event->type = MODEM_EVT_MODEM_DYNAMIC_DATA_READY;
 		event->data.modem_dynamic.timestamp = k_uptime_get();
@@ -725,19 +833,24 @@ static void populate_event_with_dynamic_modem_data(struct modem_module_event *ev
 static int dynamic_modem_data_get(void)
 {
 	int err;
+	struct modem_module_dynamic_modem_data state;
+	k_spinlock_key_t key;
 
-	/* Request data from modem information module. */
-	err = modem_info_params_get(&modem_param);
+	/* Only values without notifications that may have changed are queried from the modem. */
+	err = modem_state_refresh();
 	if (err) {
-		LOG_ERR("modem_info_params_get, error: %d", err);
 		return err;
 	}
 
+	key = k_spin_lock(&modem_state_lock);
+	state = modem_state;
+	k_spin_unlock(&modem_state_lock, key);
+
 	struct modem_module_event *modem_module_event = new_modem_module_event();
 
 	__ASSERT(modem_module_event, "Not enough heap left to allocate event");
 
-	populate_event_with_dynamic_modem_data(modem_module_event, &modem_param);
+	populate_event_with_dynamic_modem_data(modem_module_event, &state);
 
 	APP_EVENT_SUBMIT(modem_module_event);
 	return 0;
@@ -806,6 +919,8 @@ static int lte_connect(void)
 {
 	int err;
 
+	boot_stage_done(BOOT_STAGE_LTE_CONNECTING);
+
 	err = lte_lc_connect_async(lte_evt_handler);
 	if (err) {
 		LOG_ERR("lte_lc_connect_async, error: %d", err);
@@ -821,6 +936,7 @@ static int lte_connect(void)
 static int modem_data_init(void)
 {
 	int err;
+	uint32_t start;
 
 	err = modem_info_init();
 	if (err) {
@@ -828,13 +944,9 @@ static int modem_data_init(void)
 		return err;
 	}
 
-	err = modem_info_params_init(&modem_param);
-	if (err) {
-		LOG_INF("modem_info_params_init, error: %d", err);
-		return err;
-	}
-
+	start = at_profiler_start();
 	err = modem_info_rsrp_register(modem_rsrp_handler);
+	at_profiler_stop("AT%CESQ=1", start);
 	if (err) {
 		LOG_INF("modem_info_rsrp_register, error: %d", err);
 		return err;
@@ -847,6 +959,8 @@ static int setup(void)
 {
 	int err;
 
+	module_blocking_call_start(&self);
+
 	err = lte_lc_init();
 	if (err) {
 		LOG_ERR("lte_lc_init, error: %d", err);
@@ -879,6 +993,7 @@ static int setup(void)
 		return err;
 	}
 
+	boot_stage_done(BOOT_STAGE_MODEM);
 	return 0;
 }
 
@@ -927,6 +1042,8 @@ static void on_state_connecting(struct modem_msg_data *msg)
 	    (IS_EVENT(msg, cloud, CLOUD_EVT_LTE_DISCONNECT))) {
 		int err;
 
+		module_blocking_call_start(&self);
+
 		err = lte_lc_offline();
 		if (err) {
 			LOG_ERR("LTE disconnect failed, error: %d", err);
@@ -954,6 +1071,8 @@ static void on_state_connected(struct modem_msg_data *msg)
 	    (IS_EVENT(msg, cloud, CLOUD_EVT_LTE_DISCONNECT))) {
 		int err;
 
+		module_blocking_call_start(&self);
+
 		err = lte_lc_offline();
 		if (err) {
 			LOG_ERR("LTE disconnect failed, error: %d", err);
@@ -1048,6 +1167,7 @@ static void on_all_states(struct modem_msg_data *msg)
 	}
 
 	if (IS_EVENT(msg, util, UTIL_EVT_SHUTDOWN_REQUEST)) {
+		module_blocking_call_start(&self);
 		lte_lc_power_off();
 		state_set(STATE_SHUTDOWN);
 		SEND_SHUTDOWN_ACK(modem, MODEM_EVT_SHUTDOWN_READY, self.id);
@@ -8,6 +8,11 @@
 #include <zephyr/types.h>
 #include <app_event_manager.h>
 #include "modules_common.h"
+#include "boot_init.h"
+
+#if defined(CONFIG_WATCHDOG_APPLICATION)
+#include "watchdog_app.h"
+#endif /* CONFIG_WATCHDOG_APPLICATION */
 
 #include <zephyr/logging/log.h>
 
@@ -38,7 +43,18 @@ void module_purge_queue(struct module_data *module)
 
 int module_get_next_msg(struct module_data *module, void *msg)
 {
-	int err = k_msgq_get(module->msg_q, msg, K_FOREVER);
+	int err;
+
+#if defined(CONFIG_WATCHDOG_APPLICATION)
+	/* The time between two calls is the time spent on the previous message. The thread
+	 * is not supervised while it waits for the next one.
+	 */
+	watchdog_channel_pause(module->wdt_channel);
+	err = k_msgq_get(module->msg_q, msg, K_FOREVER);
+	watchdog_channel_feed(module->wdt_channel);
+#else
+	err = k_msgq_get(module->msg_q, msg, K_FOREVER);
+#endif /* CONFIG_WATCHDOG_APPLICATION */
 
 	if (err == 0 && IS_ENABLED(CONFIG_MODULES_COMMON_LOG_LEVEL_DBG)) {
 		struct event_prototype *evt_proto =
@@ -169,6 +185,18 @@ int module_start(struct module_data *module)
 	sys_slist_append(&module_list, &module->header);
 	k_mutex_unlock(&module_list_lock);
 
+	boot_module_started(module->name);
+
+	module->wdt_channel = -1;
+
+#if defined(CONFIG_WATCHDOG_APPLICATION)
+	if (module->thread_id) {
+		module->wdt_channel = watchdog_channel_add(module->name,
+							   CONFIG_WATCHDOG_TASK_TIMEOUT_SEC *
+							   MSEC_PER_SEC);
+	}
+#endif /* CONFIG_WATCHDOG_APPLICATION */
+
 	if (module->thread_id) {
 		LOG_DBG("Module \"%s\" with thread ID %p started", module->name, module->thread_id);
 	} else {
@@ -178,6 +206,16 @@ int module_start(struct module_data *module)
 	return 0;
 }
 
+void module_blocking_call_start(struct module_data *module)
+{
+#if defined(CONFIG_WATCHDOG_APPLICATION)
+	watchdog_channel_extend(module->wdt_channel,
+				CONFIG_WATCHDOG_TASK_BLOCKING_CALL_TIMEOUT_SEC * MSEC_PER_SEC);
+#else
+	ARG_UNUSED(module);
+#endif /* CONFIG_WATCHDOG_APPLICATION */
+}
+
 uint32_t module_active_count_get(void)
 {
 	return atomic_get(&modules_info.active_modules_count);
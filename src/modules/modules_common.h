@@ -86,6 +86,10 @@ struct module_data {
 	struct k_msgq *msg_q;
 	/* Flag signifying if the module supports shutdown. */
 	bool supports_shutdown;
+	/* Task watchdog channel of the module thread, negative if none. Internally assigned
+	 * when calling module_start().
+	 */
+	int wdt_channel;
 };
 
 /** @brief Purge a module's queue.
@@ -97,6 +101,9 @@ struct module_data {
 void module_purge_queue(struct module_data *module);
 
 /** @brief Get the next message in a module's queue.
+ *
+ *  If the module has a task watchdog channel, the module thread checks in on it when this
+ *  function is called. The channel is not supervised while the thread waits for a message.
  *
  *  @param[in] module Pointer to a structure containing module metadata.
  *  @param[out] msg Pointer to a message buffer that the output will be written to.
@@ -131,6 +138,14 @@ bool modules_shutdown_register(uint32_t id_reg);
  */
 int module_start(struct module_data *module);
 
+/** @brief Allow the module thread more time than the task watchdog timeout until it gets its
+ *	   next message. Called before blocking calls that are known to take long, such as
+ *	   connecting to the cloud or changing the functional mode of the modem.
+ *
+ *  @param[in] module Pointer to a structure containing module metadata.
+ */
+void module_blocking_call_start(struct module_data *module);
+
 /** @brief Get the number of active modules in the application.
  *
  *  @return Number of active modules in the application.
@@ -16,6 +16,7 @@
 #define MODULE sensor_module
 
 #include "modules_common.h"
+#include "boot_init.h"
 #include "events/app_module_event.h"
 #include "events/data_module_event.h"
 #include "events/sensor_module_event.h"
@@ -155,7 +156,11 @@ static void impact_data_send(const struct ext_sensor_evt *const evt)
 
 	__ASSERT(sensor_module_event, "Not enough heap left to allocate event");
 
-	sensor_module_event->data.impact.magnitude = evt->value;
+	sensor_module_event->data.impact.magnitude = evt->impact.magnitude;
+	sensor_module_event->data.impact.duration_us = evt->impact.duration_us;
+	sensor_module_event->data.impact.energy = evt->impact.energy;
+	sensor_module_event->data.impact.type = evt->impact.type;
+	sensor_module_event->data.impact.window_id = evt->impact.window_id;
 	sensor_module_event->data.impact.timestamp = k_uptime_get();
 	sensor_module_event->type = SENSOR_EVT_MOVEMENT_IMPACT_DETECTED;
 
@@ -174,6 +179,11 @@ static void ext_sensor_handler(const struct ext_sensor_evt *const evt)
 	case EXT_SENSOR_EVT_ACCELEROMETER_IMPACT_TRIGGER:
 		impact_data_send(evt);
 		break;
+	case EXT_SENSOR_EVT_ACCELEROMETER_BLOCK:
+		/* Block features arrive several times a second and no module subscribes to
+		 * them, so they are not forwarded as application events.
+		 */
+		break;
 	case EXT_SENSOR_EVT_ACCELEROMETER_ERROR:
 		LOG_ERR("EXT_SENSOR_EVT_ACCELEROMETER_ERROR");
 		break;
@@ -196,48 +206,52 @@ static void ext_sensor_handler(const struct ext_sensor_evt *const evt)
 #endif /* CONFIG_EXTERNAL_SENSORS */
 
 #if defined(CONFIG_EXTERNAL_SENSORS)
-static void configure_acc(const struct cloud_data_cfg *cfg)
+/* Write the accelerometer settings flagged in changed, each write is a bus transaction. */
+static void configure_acc(const struct cloud_data_cfg *cfg, uint32_t changed)
 {
-		int err;
-		double accelerometer_activity_threshold =
-			cfg->accelerometer_activity_threshold;
-		double accelerometer_inactivity_threshold =
-			cfg->accelerometer_inactivity_threshold;
-		double accelerometer_inactivity_timeout =
-			cfg->accelerometer_inactivity_timeout;
-
-		err = ext_sensors_accelerometer_threshold_set(accelerometer_activity_threshold,
+	int err;
+
+	if (changed & CLOUD_DATA_CFG_ACC_ACT_THRESHOLD) {
+		err = ext_sensors_accelerometer_threshold_set(cfg->accelerometer_activity_threshold,
 							      true);
 		if (err == -ENOTSUP) {
 			LOG_WRN("The requested act threshold value not valid");
 		} else if (err) {
 			LOG_ERR("Failed to set act threshold, error: %d", err);
 		}
-		err = ext_sensors_accelerometer_threshold_set(accelerometer_inactivity_threshold,
-							      false);
+	}
+
+	if (changed & CLOUD_DATA_CFG_ACC_INACT_THRESHOLD) {
+		err = ext_sensors_accelerometer_threshold_set(
+			cfg->accelerometer_inactivity_threshold, false);
 		if (err == -ENOTSUP) {
 			LOG_WRN("The requested inact threshold value not valid");
 		} else if (err) {
 			LOG_ERR("Failed to set inact threshold, error: %d", err);
 		}
-		err = ext_sensors_inactivity_timeout_set(accelerometer_inactivity_timeout);
+	}
+
+	if (changed & CLOUD_DATA_CFG_ACC_INACT_TIMEOUT) {
+		err = ext_sensors_inactivity_timeout_set(cfg->accelerometer_inactivity_timeout);
 		if (err == -ENOTSUP) {
 			LOG_WRN("The requested timeout value not valid");
 		} else if (err) {
 			LOG_ERR("Failed to set timeout, error: %d", err);
 		}
+	}
 }
 #endif
 
+/* Apply the configuration fields flagged in the event, all of them for DATA_EVT_CONFIG_INIT. */
 static void apply_config(struct sensor_msg_data *msg)
 {
 #if defined(CONFIG_EXTERNAL_SENSORS)
-	configure_acc(&msg->module.data.data.cfg);
+	uint32_t changed = msg->module.data.data.cfg_changed;
 
-	if (msg->module.data.data.cfg.active_mode) {
-		accelerometer_callback_set(false);
-	} else {
-		accelerometer_callback_set(true);
+	configure_acc(&msg->module.data.data.cfg, changed);
+
+	if (changed & CLOUD_DATA_CFG_ACTIVE_MODE) {
+		accelerometer_callback_set(!msg->module.data.data.cfg.active_mode);
 	}
 #endif /* CONFIG_EXTERNAL_SENSORS */
 }
@@ -247,32 +261,14 @@ static void environmental_data_get(void)
 	struct sensor_module_event *sensor_module_event;
 #if defined(CONFIG_EXTERNAL_SENSORS)
 	int err;
-	double temperature = 0, humidity = 0, pressure = 0;
-	uint16_t bsec_air_quality = UINT16_MAX;
+	struct ext_sensors_environment env = {
+		.air_quality = UINT16_MAX,
+	};
 
 	/* Request data from external sensors. */
-	err = ext_sensors_temperature_get(&temperature);
+	err = ext_sensors_environment_get(&env);
 	if (err) {
-		LOG_ERR("ext_sensors_temperature_get, error: %d", err);
-	}
-
-	err = ext_sensors_humidity_get(&humidity);
-	if (err) {
-		LOG_ERR("ext_sensors_humidity_get, error: %d", err);
-	}
-
-	err = ext_sensors_pressure_get(&pressure);
-	if (err) {
-		LOG_ERR("ext_sensors_pressure_get, error: %d", err);
-	}
-
-	err = ext_sensors_air_quality_get(&bsec_air_quality);
-	if (err && err == -ENOTSUP) {
-		/* Air quality is not available, enable the Bosch BSEC library driver.
-		 * Propagate the air quality value as -1.
-		 */
-	} else if (err) {
-		LOG_ERR("ext_sensors_bsec_air_quality_get, error: %d", err);
+		LOG_ERR("ext_sensors_environment_get, error: %d", err);
 	}
 
 	sensor_module_event = new_sensor_module_event();
@@ -280,11 +276,11 @@ static void environmental_data_get(void)
 	__ASSERT(sensor_module_event, "Not enough heap left to allocate event");
 
 	sensor_module_event->data.sensors.timestamp = k_uptime_get();
-	sensor_module_event->data.sensors.temperature = temperature;
-	sensor_module_event->data.sensors.humidity = humidity;
-	sensor_module_event->data.sensors.pressure = pressure;
+	sensor_module_event->data.sensors.temperature = env.temperature;
+	sensor_module_event->data.sensors.humidity = env.humidity;
+	sensor_module_event->data.sensors.pressure = env.pressure;
 	sensor_module_event->data.sensors.bsec_air_quality =
-					(bsec_air_quality == UINT16_MAX) ? -1 : bsec_air_quality;
+					(env.air_quality == UINT16_MAX) ? -1 : env.air_quality;
 	sensor_module_event->type = SENSOR_EVT_ENVIRONMENTAL_DATA_READY;
 #else
 
@@ -317,6 +313,13 @@ static int setup(void)
 		LOG_ERR("ext_sensors_init, error: %d", err);
 		return err;
 	}
+
+	if (IS_ENABLED(CONFIG_EXTERNAL_SENSORS_ACCEL_STREAM)) {
+		err = ext_sensors_accelerometer_stream_set(true);
+		if (err) {
+			LOG_ERR("ext_sensors_accelerometer_stream_set, error: %d", err);
+		}
+	}
 #endif
 	return 0;
 }
@@ -391,6 +394,8 @@ static void module_thread_fn(void)
 	if (err) {
 		LOG_ERR("setup, error: %d", err);
 		SEND_ERROR(sensor, SENSOR_EVT_ERROR, err);
+	} else {
+		boot_stage_done(BOOT_STAGE_SENSORS);
 	}
 
 	while (true) {
@@ -26,6 +26,23 @@
 #include <blink-led.h>
 const struct device *jayant_blink_led = DEVICE_DT_GET(DT_PATH(blink_leds));
 
+/* Double blink shown on the first blink LED while connected to cloud. The pattern is played by
+ * the timer and DPPI, so the CPU is not woken up between the steps.
+ */
+static const struct blink_led_step cloud_connected_steps[] = {
+	{ .on = true, .duration_ms = 100 },
+	{ .on = false, .duration_ms = 150 },
+	{ .on = true, .duration_ms = 100 },
+	{ .on = false, .duration_ms = 1650 },
+};
+
+static const struct blink_led_pattern cloud_connected_pattern = {
+	.steps = cloud_connected_steps,
+	.step_count = ARRAY_SIZE(cloud_connected_steps),
+	.repeat = BLINK_LED_REPEAT_FOREVER,
+	.led_mask = BIT(0),
+};
+
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(MODULE, CONFIG_UI_MODULE_LOG_LEVEL);
 
@@ -489,7 +506,16 @@ static void on_state_cloud_connecting(struct ui_msg_data *msg)
 		state_set(STATE_RUNNING);
 
         const struct blink_led_api *api = (struct blink_led_api *)(jayant_blink_led->api);
-        api->start(jayant_blink_led, 0);
+        int err = api->play(jayant_blink_led, &cloud_connected_pattern);
+
+        /* Without DPPI only plain blinking is supported. */
+        if (err == -ENOTSUP) {
+            err = api->start(jayant_blink_led, 0);
+        }
+
+        if (err) {
+            LOG_ERR("Failed to play cloud connected LED pattern, error: %d", err);
+        }
 	}
 
 	if (IS_EVENT(msg, cloud, CLOUD_EVT_USER_ASSOCIATED)) {
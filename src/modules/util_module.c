@@ -16,6 +16,7 @@
 #include "watchdog_app.h"
 #endif
 #include "modules_common.h"
+#include "boot_init.h"
 #include "events/app_module_event.h"
 #include "events/cloud_module_event.h"
 #include "events/data_module_event.h"
@@ -232,6 +233,8 @@ static int setup(const struct device *dev)
 	if (err) {
 		LOG_DBG("watchdog_init_and_start, error: %d", err);
 		send_reboot_request(REASON_GENERIC);
+	} else {
+		boot_stage_done(BOOT_STAGE_WATCHDOG);
 	}
 #endif
 
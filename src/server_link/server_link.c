@@ -0,0 +1,717 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "server_link.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(server_link, CONFIG_SERVER_LINK_LOG_LEVEL);
+
+#define FRAME_SIZE_MAX		(SERVER_LINK_FRAME_HDR_SIZE + CONFIG_SERVER_LINK_PAYLOAD_MAX)
+#define TX_BUF_COUNT		(CONFIG_SERVER_LINK_TX_WINDOW + CONFIG_SERVER_LINK_TX_QUEUE_SIZE)
+
+BUILD_ASSERT(FRAME_SIZE_MAX <= CONFIG_SERVER_LINK_MTU,
+	     "A maximum sized frame must fit in one datagram");
+
+#if defined(CONFIG_SERVER_LINK_TRANSPORT_TCP)
+#define SOCKET_TYPE	SOCK_STREAM
+#define SOCKET_PROTO	IPPROTO_TCP
+#else
+#define SOCKET_TYPE	SOCK_DGRAM
+#define SOCKET_PROTO	IPPROTO_UDP
+#endif
+
+/* Transmit buffers hold a complete frame, header included. Receive buffers hold the
+ * payload only.
+ */
+K_MEM_SLAB_DEFINE_STATIC(tx_slab, FRAME_SIZE_MAX, TX_BUF_COUNT, 4);
+K_MEM_SLAB_DEFINE_STATIC(rx_slab, CONFIG_SERVER_LINK_PAYLOAD_MAX,
+			 CONFIG_SERVER_LINK_RX_BUF_COUNT, 4);
+
+struct tx_msg {
+	uint8_t *buf;
+	uint16_t len;
+	int64_t queued_at;
+};
+
+K_MSGQ_DEFINE(tx_msgq, sizeof(struct tx_msg), CONFIG_SERVER_LINK_TX_QUEUE_SIZE, 4);
+
+/* Serializes queueing of messages with the state changes of the link, so that no message is
+ * queued after the queue has been drained on disconnect.
+ */
+static K_MUTEX_DEFINE(tx_lock);
+
+/* Unacknowledged frame. Slots are indexed by seq modulo the window size. */
+struct tx_slot {
+	uint8_t *buf;
+	uint16_t len;
+	int64_t sent_at;
+	uint8_t retries;
+};
+
+static K_THREAD_STACK_DEFINE(link_stack, CONFIG_SERVER_LINK_THREAD_STACK_SIZE);
+static struct k_thread link_thread;
+static bool link_thread_created;
+
+/* Offloaded sockets cannot be polled together with kernel objects. The receive wait thread
+ * blocks in poll() on the socket and hands the result over to the link thread, which sleeps
+ * in k_poll() until the socket is readable, a message is queued or a protocol timer expires.
+ * The wait thread does not poll again until the link thread has read the socket.
+ */
+static K_THREAD_STACK_DEFINE(rx_wait_stack, CONFIG_SERVER_LINK_RX_WAIT_THREAD_STACK_SIZE);
+static struct k_thread rx_wait_thread;
+static K_SEM_DEFINE(rx_ready, 0, 1);
+static K_SEM_DEFINE(rx_resume, 0, 1);
+static atomic_t rx_revents;
+static atomic_t closing;
+
+static server_link_evt_handler_t evt_handler;
+static int client_fd = -1;
+static atomic_t connected;
+
+/* State below is only accessed from the link thread. */
+static struct tx_slot window[CONFIG_SERVER_LINK_TX_WINDOW];
+/* Oldest unacknowledged sequence number. */
+static uint16_t tx_base;
+/* Sequence number assigned to the next new frame. */
+static uint16_t tx_next;
+/* Set the SYNC flag on the next frame sent at tx_base. */
+static bool tx_sync = true;
+
+/* Next sequence number expected from the server. */
+static uint16_t rx_next;
+static bool rx_synced;
+static bool ack_pending;
+static int64_t ack_due;
+
+static uint8_t datagram[CONFIG_SERVER_LINK_MTU] __aligned(4);
+static size_t datagram_len;
+
+static uint8_t rx_stream[CONFIG_SERVER_LINK_MTU] __aligned(4);
+static size_t rx_stream_len;
+
+static struct {
+	uint32_t tx_frames;
+	uint32_t tx_datagrams;
+	uint32_t retransmits;
+	uint32_t rx_frames;
+	uint32_t rx_dropped;
+} stats;
+
+static bool seq_before(uint16_t a, uint16_t b)
+{
+	return (int16_t)(a - b) < 0;
+}
+
+static void notify(const struct server_link_evt *evt)
+{
+	if (evt_handler != NULL) {
+		evt_handler(evt);
+	}
+}
+
+static void hdr_write(uint8_t *frame, uint8_t flags, uint16_t seq, uint16_t len)
+{
+	frame[0] = SERVER_LINK_FRAME_MAGIC;
+	frame[1] = flags;
+	sys_put_be16(seq, &frame[2]);
+	sys_put_be16(rx_next, &frame[4]);
+	sys_put_be16(len, &frame[6]);
+}
+
+static int datagram_flush(void)
+{
+	ssize_t ret;
+
+	if (datagram_len == 0) {
+		return 0;
+	}
+
+	ret = send(client_fd, datagram, datagram_len, 0);
+	if (ret < 0) {
+		LOG_ERR("send, errno: %d", errno);
+		return -errno;
+	}
+
+	stats.tx_datagrams++;
+	datagram_len = 0;
+
+	return 0;
+}
+
+/* Append a frame to the outgoing datagram, sending the datagram first if it is full.
+ * All frames carry the latest acknowledgment, so a pending standalone ACK is cleared.
+ */
+static int datagram_append(const uint8_t *frame, size_t len)
+{
+	int err;
+
+	if ((datagram_len + len) > sizeof(datagram)) {
+		err = datagram_flush();
+		if (err) {
+			return err;
+		}
+	}
+
+	memcpy(&datagram[datagram_len], frame, len);
+	datagram_len += len;
+	ack_pending = false;
+
+	return 0;
+}
+
+static int slot_send(uint16_t seq, int64_t now)
+{
+	struct tx_slot *slot = &window[seq % CONFIG_SERVER_LINK_TX_WINDOW];
+	uint8_t flags = SERVER_LINK_FLAG_DATA | SERVER_LINK_FLAG_ACK;
+
+	if ((seq == tx_base) && tx_sync) {
+		flags |= SERVER_LINK_FLAG_SYNC;
+	}
+
+	hdr_write(slot->buf, flags, seq, slot->len - SERVER_LINK_FRAME_HDR_SIZE);
+	slot->sent_at = now;
+	stats.tx_frames++;
+
+	return datagram_append(slot->buf, slot->len);
+}
+
+static void window_ack(uint16_t ack)
+{
+	/* Ignore acknowledgments outside of the window. */
+	if (seq_before(tx_next, ack) || !seq_before(tx_base, ack)) {
+		return;
+	}
+
+	while (tx_base != ack) {
+		struct tx_slot *slot = &window[tx_base % CONFIG_SERVER_LINK_TX_WINDOW];
+
+		k_mem_slab_free(&tx_slab, (void **)&slot->buf);
+		slot->buf = NULL;
+		tx_base++;
+		tx_sync = false;
+	}
+}
+
+static void retransmit_process(int64_t now)
+{
+	struct tx_slot *oldest;
+
+	if (tx_base == tx_next) {
+		return;
+	}
+
+	oldest = &window[tx_base % CONFIG_SERVER_LINK_TX_WINDOW];
+
+	if ((now - oldest->sent_at) < CONFIG_SERVER_LINK_RETRANSMIT_TIMEOUT_MS) {
+		return;
+	}
+
+	if (oldest->retries >= CONFIG_SERVER_LINK_RETRANSMIT_MAX) {
+		struct server_link_evt evt = {
+			.type = SERVER_LINK_EVT_TX_DROPPED,
+			.err = -ETIMEDOUT,
+		};
+
+		LOG_WRN("Frame %d dropped after %d retransmissions", tx_base, oldest->retries);
+
+		k_mem_slab_free(&tx_slab, (void **)&oldest->buf);
+		oldest->buf = NULL;
+		tx_base++;
+
+		/* The server has not seen the dropped frame and discards everything after it
+		 * until it is told to resynchronize.
+		 */
+		tx_sync = true;
+		notify(&evt);
+
+		if (tx_base == tx_next) {
+			return;
+		}
+	}
+
+	/* Go-back-N, resend all unacknowledged frames. */
+	for (uint16_t seq = tx_base; seq != tx_next; seq++) {
+		struct tx_slot *slot = &window[seq % CONFIG_SERVER_LINK_TX_WINDOW];
+
+		slot->retries++;
+		stats.retransmits++;
+
+		if (slot_send(seq, now)) {
+			return;
+		}
+	}
+}
+
+static void new_frames_process(int64_t now)
+{
+	struct tx_msg msg;
+
+	if (k_msgq_peek(&tx_msgq, &msg)) {
+		return;
+	}
+
+	/* Hold back new messages until the batch delay of the oldest one has expired, unless
+	 * enough is queued to fill a datagram.
+	 */
+	if (((now - msg.queued_at) < CONFIG_SERVER_LINK_BATCH_DELAY_MS) &&
+	    ((k_msgq_num_used_get(&tx_msgq) * FRAME_SIZE_MAX) < CONFIG_SERVER_LINK_MTU)) {
+		return;
+	}
+
+	while (((uint16_t)(tx_next - tx_base) < CONFIG_SERVER_LINK_TX_WINDOW) &&
+	       (k_msgq_get(&tx_msgq, &msg, K_NO_WAIT) == 0)) {
+		struct tx_slot *slot = &window[tx_next % CONFIG_SERVER_LINK_TX_WINDOW];
+
+		slot->buf = msg.buf;
+		slot->len = msg.len;
+		slot->retries = 0;
+
+		if (slot_send(tx_next++, now)) {
+			return;
+		}
+	}
+}
+
+static void ack_process(int64_t now)
+{
+	uint8_t frame[SERVER_LINK_FRAME_HDR_SIZE];
+
+	if (!ack_pending || (now < ack_due)) {
+		return;
+	}
+
+	hdr_write(frame, SERVER_LINK_FLAG_ACK, tx_next, 0);
+	(void)datagram_append(frame, sizeof(frame));
+}
+
+static void frame_handle(uint8_t flags, uint16_t seq, uint16_t ack,
+			 const uint8_t *payload, uint16_t len)
+{
+	struct server_link_evt evt = {
+		.type = SERVER_LINK_EVT_DATA_RECEIVED,
+	};
+	uint8_t *buf;
+
+	if (flags & SERVER_LINK_FLAG_ACK) {
+		window_ack(ack);
+	}
+
+	if (!(flags & SERVER_LINK_FLAG_DATA)) {
+		return;
+	}
+
+	if ((flags & SERVER_LINK_FLAG_SYNC) || !rx_synced) {
+		rx_next = seq;
+		rx_synced = true;
+	}
+
+	/* Duplicates and out of order frames are not delivered, but the current position is
+	 * acknowledged so that the server retransmits from there.
+	 */
+	if (!ack_pending) {
+		ack_pending = true;
+		ack_due = k_uptime_get() + CONFIG_SERVER_LINK_ACK_DELAY_MS;
+	}
+
+	if (seq != rx_next) {
+		LOG_DBG("Frame %d discarded, expected %d", seq, rx_next);
+		stats.rx_dropped++;
+		return;
+	}
+
+	/* Frames are not acknowledged when the pool is exhausted, making the server back off
+	 * until the application has consumed earlier payloads.
+	 */
+	if (k_mem_slab_alloc(&rx_slab, (void **)&buf, K_NO_WAIT)) {
+		LOG_WRN("No receive buffer available, frame %d dropped", seq);
+		stats.rx_dropped++;
+		return;
+	}
+
+	memcpy(buf, payload, len);
+	rx_next++;
+	stats.rx_frames++;
+
+	evt.data.buf = buf;
+	evt.data.len = len;
+	notify(&evt);
+}
+
+/* Parse all complete frames in the receive stream buffer. Returns the number of bytes
+ * consumed.
+ */
+static size_t rx_stream_parse(void)
+{
+	size_t offset = 0;
+
+	while ((rx_stream_len - offset) >= SERVER_LINK_FRAME_HDR_SIZE) {
+		const uint8_t *frame = &rx_stream[offset];
+		uint16_t len = sys_get_be16(&frame[6]);
+
+		if ((frame[0] != SERVER_LINK_FRAME_MAGIC) ||
+		    (len > CONFIG_SERVER_LINK_PAYLOAD_MAX)) {
+			LOG_WRN("Invalid frame header, discarding %d bytes",
+				rx_stream_len - offset);
+			stats.rx_dropped++;
+			return rx_stream_len;
+		}
+
+		if ((rx_stream_len - offset) < (SERVER_LINK_FRAME_HDR_SIZE + len)) {
+			break;
+		}
+
+		frame_handle(frame[1], sys_get_be16(&frame[2]), sys_get_be16(&frame[4]),
+			     &frame[SERVER_LINK_FRAME_HDR_SIZE], len);
+
+		offset += SERVER_LINK_FRAME_HDR_SIZE + len;
+	}
+
+	return offset;
+}
+
+static int rx_process(void)
+{
+	size_t consumed;
+	ssize_t len = recv(client_fd, &rx_stream[rx_stream_len],
+			   sizeof(rx_stream) - rx_stream_len, 0);
+
+	if (len < 0) {
+		LOG_ERR("recv, errno: %d", errno);
+		return -errno;
+	}
+
+	if ((len == 0) && IS_ENABLED(CONFIG_SERVER_LINK_TRANSPORT_TCP)) {
+		LOG_WRN("Connection closed by server");
+		return -ECONNRESET;
+	}
+
+	rx_stream_len += len;
+	consumed = rx_stream_parse();
+
+	if (IS_ENABLED(CONFIG_SERVER_LINK_TRANSPORT_TCP)) {
+		/* Keep a partially received frame for the next read. */
+		memmove(rx_stream, &rx_stream[consumed], rx_stream_len - consumed);
+		rx_stream_len -= consumed;
+	} else {
+		/* Frames never span datagrams. */
+		rx_stream_len = 0;
+	}
+
+	return 0;
+}
+
+/* Time until the next retransmission, delayed acknowledgment or batch of queued messages is
+ * due. Forever if none is pending, the link thread is then woken by the socket or by a new
+ * message.
+ */
+static k_timeout_t wait_timeout_get(int64_t now)
+{
+	int64_t deadline = INT64_MAX;
+	struct tx_msg msg;
+
+	if (tx_base != tx_next) {
+		struct tx_slot *oldest = &window[tx_base % CONFIG_SERVER_LINK_TX_WINDOW];
+
+		deadline = MIN(deadline,
+			       oldest->sent_at + CONFIG_SERVER_LINK_RETRANSMIT_TIMEOUT_MS);
+	}
+
+	if (ack_pending) {
+		deadline = MIN(deadline, ack_due);
+	}
+
+	/* Messages that do not fit in the window wait for an acknowledgment instead. */
+	if (((uint16_t)(tx_next - tx_base) < CONFIG_SERVER_LINK_TX_WINDOW) &&
+	    (k_msgq_peek(&tx_msgq, &msg) == 0)) {
+		if ((k_msgq_num_used_get(&tx_msgq) * FRAME_SIZE_MAX) >= CONFIG_SERVER_LINK_MTU) {
+			deadline = now;
+		} else {
+			deadline = MIN(deadline,
+				       msg.queued_at + CONFIG_SERVER_LINK_BATCH_DELAY_MS);
+		}
+	}
+
+	if (deadline == INT64_MAX) {
+		return K_FOREVER;
+	}
+
+	return K_MSEC(MAX(deadline - now, 0));
+}
+
+static void rx_wait_thread_fn(void *p1, void *p2, void *p3)
+{
+	struct pollfd fds[1] = {
+		{
+			.fd = (int)(intptr_t)p1,
+			.events = POLLIN,
+		},
+	};
+
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (!atomic_get(&closing)) {
+		int ret = poll(fds, ARRAY_SIZE(fds), -1);
+
+		if (ret < 0) {
+			LOG_DBG("poll, errno: %d", errno);
+			fds[0].revents = POLLERR;
+		}
+
+		atomic_set(&rx_revents, fds[0].revents);
+		k_sem_give(&rx_ready);
+
+		if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+			break;
+		}
+
+		k_sem_take(&rx_resume, K_FOREVER);
+	}
+}
+
+static void link_close(int err)
+{
+	struct server_link_evt evt = {
+		.type = SERVER_LINK_EVT_DISCONNECTED,
+		.err = err,
+	};
+	struct tx_msg msg;
+
+	k_mutex_lock(&tx_lock, K_FOREVER);
+
+	atomic_set(&connected, false);
+
+	while (k_msgq_get(&tx_msgq, &msg, K_NO_WAIT) == 0) {
+		k_mem_slab_free(&tx_slab, (void **)&msg.buf);
+	}
+
+	k_mutex_unlock(&tx_lock);
+
+	/* Closing the socket wakes the receive wait thread if it is blocked in poll(). */
+	atomic_set(&closing, true);
+	k_sem_give(&rx_resume);
+
+	(void)close(client_fd);
+	client_fd = -1;
+
+	(void)k_thread_join(&rx_wait_thread, K_FOREVER);
+
+	for (uint16_t seq = tx_base; seq != tx_next; seq++) {
+		k_mem_slab_free(&tx_slab,
+				(void **)&window[seq % CONFIG_SERVER_LINK_TX_WINDOW].buf);
+	}
+
+	LOG_INF("Link closed, tx frames: %d, datagrams: %d, retransmits: %d, "
+		"rx frames: %d, rx dropped: %d", stats.tx_frames, stats.tx_datagrams,
+		stats.retransmits, stats.rx_frames, stats.rx_dropped);
+
+	notify(&evt);
+}
+
+static void link_thread_fn(void *p1, void *p2, void *p3)
+{
+	struct k_poll_event events[] = {
+		K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SEM_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY,
+					 &rx_ready),
+		K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_MSGQ_DATA_AVAILABLE,
+					 K_POLL_MODE_NOTIFY_ONLY, &tx_msgq),
+	};
+	int err = 0;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	k_thread_create(&rx_wait_thread, rx_wait_stack, K_THREAD_STACK_SIZEOF(rx_wait_stack),
+			rx_wait_thread_fn, (void *)(intptr_t)client_fd, NULL, NULL,
+			K_PRIO_PREEMPT(CONFIG_SERVER_LINK_THREAD_PRIORITY), 0, K_NO_WAIT);
+	k_thread_name_set(&rx_wait_thread, "server_link_rx");
+
+	while (true) {
+		/* Queued messages are covered by the timeout, only an empty queue is waited on.
+		 * The queue is checked first, a message queued after the check is covered by
+		 * either of them.
+		 */
+		int num_events = k_msgq_num_used_get(&tx_msgq) ? 1 : ARRAY_SIZE(events);
+		int64_t now = k_uptime_get();
+		k_timeout_t timeout = wait_timeout_get(now);
+
+		for (size_t i = 0; i < ARRAY_SIZE(events); i++) {
+			events[i].state = K_POLL_STATE_NOT_READY;
+		}
+
+		(void)k_poll(events, num_events, timeout);
+
+		if (k_sem_take(&rx_ready, K_NO_WAIT) == 0) {
+			int revents = (int)atomic_get(&rx_revents);
+
+			if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+				LOG_ERR("Socket error, revents: 0x%x", revents);
+				err = -EIO;
+				break;
+			}
+
+			if (revents & POLLIN) {
+				err = rx_process();
+				if (err) {
+					break;
+				}
+			}
+
+			k_sem_give(&rx_resume);
+		}
+
+		now = k_uptime_get();
+
+		retransmit_process(now);
+		new_frames_process(now);
+		ack_process(now);
+
+		err = datagram_flush();
+		if (err) {
+			break;
+		}
+	}
+
+	link_close(err);
+}
+
+int server_link_connect(server_link_evt_handler_t handler)
+{
+	int err;
+	char port[6];
+	struct addrinfo *res;
+	struct addrinfo hints = {
+		.ai_family = AF_INET,
+		.ai_socktype = SOCKET_TYPE,
+	};
+	struct server_link_evt evt = {
+		.type = SERVER_LINK_EVT_CONNECTED,
+	};
+
+	if (atomic_get(&connected)) {
+		return -EALREADY;
+	}
+
+	/* The thread of the previous connection may still be closing the link. */
+	if (link_thread_created) {
+		(void)k_thread_join(&link_thread, K_FOREVER);
+		link_thread_created = false;
+	}
+
+	snprintf(port, sizeof(port), "%d", CONFIG_SERVER_LINK_PORT);
+
+	err = getaddrinfo(CONFIG_SERVER_LINK_HOST, port, &hints, &res);
+	if (err) {
+		LOG_ERR("getaddrinfo, error: %d", err);
+		return -EHOSTUNREACH;
+	}
+
+	client_fd = socket(res->ai_family, SOCKET_TYPE, SOCKET_PROTO);
+	if (client_fd < 0) {
+		LOG_ERR("socket, errno: %d", errno);
+		err = -errno;
+		goto exit;
+	}
+
+	err = connect(client_fd, res->ai_addr, res->ai_addrlen);
+	if (err) {
+		LOG_ERR("connect, errno: %d", errno);
+		err = -errno;
+		(void)close(client_fd);
+		client_fd = -1;
+		goto exit;
+	}
+
+	evt_handler = handler;
+	tx_base = 0;
+	tx_next = 0;
+	tx_sync = true;
+	rx_synced = false;
+	ack_pending = false;
+	datagram_len = 0;
+	rx_stream_len = 0;
+
+	atomic_set(&closing, false);
+	k_sem_reset(&rx_ready);
+	k_sem_reset(&rx_resume);
+
+	k_mutex_lock(&tx_lock, K_FOREVER);
+	atomic_set(&connected, true);
+	k_mutex_unlock(&tx_lock);
+
+	LOG_INF("Connected to %s:%d over %s", CONFIG_SERVER_LINK_HOST, CONFIG_SERVER_LINK_PORT,
+		IS_ENABLED(CONFIG_SERVER_LINK_TRANSPORT_TCP) ? "TCP" : "UDP");
+
+	k_thread_create(&link_thread, link_stack, K_THREAD_STACK_SIZEOF(link_stack),
+			link_thread_fn, NULL, NULL, NULL,
+			K_PRIO_PREEMPT(CONFIG_SERVER_LINK_THREAD_PRIORITY), 0, K_NO_WAIT);
+	k_thread_name_set(&link_thread, "server_link");
+	link_thread_created = true;
+
+	notify(&evt);
+
+exit:
+	freeaddrinfo(res);
+	return err;
+}
+
+int server_link_send(const uint8_t *data, size_t len)
+{
+	struct tx_msg msg = {
+		.len = SERVER_LINK_FRAME_HDR_SIZE + len,
+	};
+	int err;
+
+	if ((data == NULL) || (len == 0) || (len > CONFIG_SERVER_LINK_PAYLOAD_MAX)) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&tx_lock, K_FOREVER);
+
+	if (!atomic_get(&connected)) {
+		err = -ENOTCONN;
+		goto exit;
+	}
+
+	err = k_mem_slab_alloc(&tx_slab, (void **)&msg.buf, K_NO_WAIT);
+	if (err) {
+		err = -ENOMEM;
+		goto exit;
+	}
+
+	/* The header is filled in when the frame enters the transmit window. */
+	memcpy(&msg.buf[SERVER_LINK_FRAME_HDR_SIZE], data, len);
+	msg.queued_at = k_uptime_get();
+
+	err = k_msgq_put(&tx_msgq, &msg, K_NO_WAIT);
+	if (err) {
+		k_mem_slab_free(&tx_slab, (void **)&msg.buf);
+		err = -ENOMEM;
+	}
+
+exit:
+	k_mutex_unlock(&tx_lock);
+	return err;
+}
+
+bool server_link_is_connected(void)
+{
+	return atomic_get(&connected);
+}
+
+void server_link_rx_buf_free(uint8_t *buf)
+{
+	if (buf != NULL) {
+		k_mem_slab_free(&rx_slab, (void **)&buf);
+	}
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**@file
+ *
+ * @brief   Third-party server link for Asset Tracker v2
+ *
+ * Framed, sequenced and acknowledged message transport to a third-party server over a
+ * UDP or TCP socket. All socket I/O is done from a single link thread, which sleeps until
+ * the socket is readable, a message is queued or a protocol timer expires.
+ *
+ * Every frame starts with an 8 byte header, all fields in network byte order:
+ *
+ *  | magic (1) | flags (1) | seq (2) | ack (2) | len (2) | payload (len) |
+ *
+ * Several frames can be packed back to back in one datagram. Data frames are numbered by
+ * seq and must be delivered in order. ack carries the next sequence number the sender of
+ * the frame expects to receive, acknowledging all data frames before it. A frame with the
+ * SYNC flag set tells the receiver to accept its seq as the start of the stream.
+ */
+
+#ifndef SERVER_LINK_H__
+#define SERVER_LINK_H__
+
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SERVER_LINK_FRAME_MAGIC		0xA5
+#define SERVER_LINK_FRAME_HDR_SIZE	8
+
+#define SERVER_LINK_FLAG_DATA		BIT(0)
+#define SERVER_LINK_FLAG_ACK		BIT(1)
+#define SERVER_LINK_FLAG_SYNC		BIT(2)
+
+enum server_link_evt_type {
+	/** Socket connected and the link thread is running. */
+	SERVER_LINK_EVT_CONNECTED,
+	/** The link has been closed due to a socket error. */
+	SERVER_LINK_EVT_DISCONNECTED,
+	/** In-order payload received from the server. The receiver of the event takes
+	 *  ownership of the buffer and must release it with server_link_rx_buf_free().
+	 */
+	SERVER_LINK_EVT_DATA_RECEIVED,
+	/** A message was dropped after exhausting all retransmissions. */
+	SERVER_LINK_EVT_TX_DROPPED,
+};
+
+struct server_link_evt {
+	enum server_link_evt_type type;
+	union {
+		struct {
+			uint8_t *buf;
+			size_t len;
+		} data;
+		int err;
+	};
+};
+
+/** @brief Server link event handler. Called from the link thread.
+ *
+ *  @param[in] evt The event and any associated parameters.
+ */
+typedef void (*server_link_evt_handler_t)(const struct server_link_evt *evt);
+
+/** @brief Open the socket to the configured endpoint and start the link thread.
+ *
+ *  @param[in] evt_handler Event handler.
+ *
+ *  @return Zero on success, otherwise a negative error code is returned.
+ */
+int server_link_connect(server_link_evt_handler_t evt_handler);
+
+/** @brief Queue a message for transmission. The data is copied, and sent together with
+ *	   other messages queued within CONFIG_SERVER_LINK_BATCH_DELAY_MS.
+ *
+ *  @param[in] data Message payload.
+ *  @param[in] len Payload length, at most CONFIG_SERVER_LINK_PAYLOAD_MAX.
+ *
+ *  @return Zero on success, -ENOTCONN if the link is not connected, -ENOMEM if the
+ *	    transmit queue is full, otherwise a negative error code.
+ */
+int server_link_send(const uint8_t *data, size_t len);
+
+/** @brief Check whether the link is connected.
+ *
+ *  @return true if connected, otherwise false.
+ */
+bool server_link_is_connected(void);
+
+/** @brief Release a buffer delivered in a SERVER_LINK_EVT_DATA_RECEIVED event.
+ *
+ *  @param[in] buf Buffer to release.
+ */
+void server_link_rx_buf_free(uint8_t *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SERVER_LINK_H__ */
@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/nvs.h>
+#include <string.h>
+
+#include "record_store.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(record_store, CONFIG_RECORD_STORE_LOG_LEVEL);
+
+/* NVS ID layout. Each key occupies one meta entry followed by one entry per block slot. */
+#define KEY_ID_SPAN		(CONFIG_RECORD_STORE_BLOCKS_PER_KEY + 1)
+#define META_ID(_key)		(CONFIG_RECORD_STORE_NVS_ID_BASE + ((_key) * KEY_ID_SPAN))
+#define BLOCK_ID(_key, _seq)	\
+	(META_ID(_key) + 1 + ((_seq) % CONFIG_RECORD_STORE_BLOCKS_PER_KEY))
+
+#define BLOCK_PAYLOAD_SIZE	(CONFIG_RECORD_STORE_BLOCK_SIZE - sizeof(struct block_hdr))
+
+BUILD_ASSERT((CONFIG_RECORD_STORE_NVS_ID_BASE +
+	      (CONFIG_RECORD_STORE_KEY_COUNT * KEY_ID_SPAN)) <= UINT16_MAX,
+	     "Record store NVS ID range exceeds 16 bits");
+BUILD_ASSERT(CONFIG_RECORD_STORE_RECORD_SIZE_MAX <= UINT8_MAX,
+	     "Record length must fit in the one byte record header");
+
+/* Persisted per key bookkeeping. Blocks with sequence numbers in [head, tail) are valid. */
+struct key_meta {
+	uint32_t head;
+	uint32_t tail;
+	/* Index of the first record in the block at head. */
+	uint32_t first_idx;
+	/* Index of the first record that has not been written to flash. */
+	uint32_t next_idx;
+};
+
+/* Header stored in front of the record payload in every block entry. */
+struct block_hdr {
+	uint32_t first_idx;
+	uint16_t count;
+	uint16_t used;
+};
+
+struct key_state {
+	struct key_meta meta;
+	/* Pending block, laid out exactly as it is written to NVS. */
+	union {
+		struct block_hdr hdr;
+		uint8_t raw[CONFIG_RECORD_STORE_BLOCK_SIZE];
+	} pending;
+};
+
+BUILD_ASSERT(CONFIG_RECORD_STORE_RECORD_SIZE_MAX + RECORD_STORE_RECORD_HDR_SIZE <=
+	     CONFIG_RECORD_STORE_BLOCK_SIZE - sizeof(struct block_hdr),
+	     "A maximum sized record must fit in a block");
+
+static struct nvs_fs *store_fs;
+static struct key_state keys[CONFIG_RECORD_STORE_KEY_COUNT];
+
+/* Scratch buffer used when reading blocks back from flash. */
+static uint8_t block_buf[CONFIG_RECORD_STORE_BLOCK_SIZE] __aligned(4);
+
+static K_MUTEX_DEFINE(store_lock);
+
+static void flush_work_fn(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(flush_work, flush_work_fn);
+
+static int key_flush(uint8_t key)
+{
+	struct key_state *ks = &keys[key];
+	struct key_meta meta = ks->meta;
+	ssize_t len;
+
+	if (ks->pending.hdr.count == 0) {
+		return 0;
+	}
+
+	/* Ring full, the block at head shares its NVS entry with the new block. The oldest
+	 * block is dropped from the committed meta entry before its entry is overwritten.
+	 */
+	if ((meta.tail - meta.head) == CONFIG_RECORD_STORE_BLOCKS_PER_KEY) {
+		struct block_hdr oldest;
+
+		len = nvs_read(store_fs, BLOCK_ID(key, meta.head), &oldest, sizeof(oldest));
+		if (len < (ssize_t)sizeof(oldest)) {
+			LOG_ERR("Unable to read oldest block of key %d, error: %d", key, len);
+			return (len < 0) ? len : -EIO;
+		}
+
+		meta.head++;
+		meta.first_idx = oldest.first_idx + oldest.count;
+
+		len = nvs_write(store_fs, META_ID(key), &meta, sizeof(meta));
+		if (len < 0) {
+			LOG_ERR("Unable to write meta of key %d, error: %d", key, len);
+			return len;
+		}
+
+		ks->meta = meta;
+	}
+
+	if (meta.tail == meta.head) {
+		meta.first_idx = ks->pending.hdr.first_idx;
+	}
+
+	len = nvs_write(store_fs, BLOCK_ID(key, meta.tail), ks->pending.raw,
+			sizeof(struct block_hdr) + ks->pending.hdr.used);
+	if (len < 0) {
+		LOG_ERR("Unable to write block of key %d, error: %d", key, len);
+		return len;
+	}
+
+	meta.tail++;
+	meta.next_idx += ks->pending.hdr.count;
+
+	/* Block is written before the meta entry so that an interrupted flush leaves the
+	 * previously committed state intact. The entry written is never part of that state,
+	 * a reused entry has been dropped from it above.
+	 */
+	len = nvs_write(store_fs, META_ID(key), &meta, sizeof(meta));
+	if (len < 0) {
+		LOG_ERR("Unable to write meta of key %d, error: %d", key, len);
+		return len;
+	}
+
+	LOG_DBG("Key %d: flushed %d records (%d bytes), records %d..%d stored",
+		key, ks->pending.hdr.count, ks->pending.hdr.used, meta.first_idx,
+		meta.next_idx - 1);
+
+	ks->meta = meta;
+	ks->pending.hdr.first_idx = meta.next_idx;
+	ks->pending.hdr.count = 0;
+	ks->pending.hdr.used = 0;
+
+	return 0;
+}
+
+static void flush_work_fn(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	int err = record_store_flush();
+
+	if (err) {
+		LOG_ERR("record_store_flush, error: %d", err);
+	}
+}
+
+/* Copy records from a block payload into the output buffer. Returns the number of bytes
+ * written, and updates the next wanted index and the remaining record count.
+ */
+static size_t block_records_copy(const struct block_hdr *hdr, const uint8_t *payload,
+				 uint32_t *idx, uint16_t *remaining,
+				 uint8_t *buf, size_t buf_len, bool *full)
+{
+	uint32_t rec_idx = hdr->first_idx;
+	size_t offset = 0;
+	size_t written = 0;
+
+	while ((offset < hdr->used) && (*remaining > 0)) {
+		size_t rec_len = payload[offset] + RECORD_STORE_RECORD_HDR_SIZE;
+
+		if (rec_idx >= *idx) {
+			if (written + rec_len > buf_len) {
+				*full = true;
+				break;
+			}
+
+			memcpy(&buf[written], &payload[offset], rec_len);
+			written += rec_len;
+			(*idx)++;
+			(*remaining)--;
+		}
+
+		offset += rec_len;
+		rec_idx++;
+	}
+
+	return written;
+}
+
+int record_store_init(struct nvs_fs *fs)
+{
+	if (fs == NULL) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&store_lock, K_FOREVER);
+
+	store_fs = fs;
+
+	for (uint8_t key = 0; key < ARRAY_SIZE(keys); key++) {
+		struct key_state *ks = &keys[key];
+		ssize_t len = nvs_read(store_fs, META_ID(key), &ks->meta, sizeof(ks->meta));
+
+		if (len == -ENOENT) {
+			memset(&ks->meta, 0, sizeof(ks->meta));
+		} else if (len != sizeof(ks->meta)) {
+			LOG_WRN("Invalid meta entry for key %d, length: %d, resetting log",
+				key, len);
+			memset(&ks->meta, 0, sizeof(ks->meta));
+		}
+
+		ks->pending.hdr.first_idx = ks->meta.next_idx;
+		ks->pending.hdr.count = 0;
+		ks->pending.hdr.used = 0;
+
+		LOG_DBG("Key %d: %d blocks, records %d..%d", key,
+			ks->meta.tail - ks->meta.head, ks->meta.first_idx, ks->meta.next_idx);
+	}
+
+	k_mutex_unlock(&store_lock);
+
+	return 0;
+}
+
+int record_store_append(uint8_t key, const uint8_t *data, size_t len)
+{
+	struct key_state *ks;
+	int idx;
+	int err;
+
+	if ((key >= ARRAY_SIZE(keys)) || (data == NULL) || (len == 0) ||
+	    (len > CONFIG_RECORD_STORE_RECORD_SIZE_MAX)) {
+		return -EINVAL;
+	}
+
+	if (store_fs == NULL) {
+		return -EACCES;
+	}
+
+	ks = &keys[key];
+
+	k_mutex_lock(&store_lock, K_FOREVER);
+
+	if ((ks->pending.hdr.used + RECORD_STORE_RECORD_HDR_SIZE + len) > BLOCK_PAYLOAD_SIZE) {
+		err = key_flush(key);
+		if (err) {
+			k_mutex_unlock(&store_lock);
+			return err;
+		}
+	}
+
+	uint8_t *dst = &ks->pending.raw[sizeof(struct block_hdr) + ks->pending.hdr.used];
+
+	dst[0] = (uint8_t)len;
+	memcpy(&dst[RECORD_STORE_RECORD_HDR_SIZE], data, len);
+
+	idx = ks->pending.hdr.first_idx + ks->pending.hdr.count;
+	ks->pending.hdr.used += RECORD_STORE_RECORD_HDR_SIZE + len;
+	ks->pending.hdr.count++;
+
+	k_mutex_unlock(&store_lock);
+
+	/* Does not reschedule if already pending, so buffered data is written no later than
+	 * the flush timeout after the first unflushed append.
+	 */
+	k_work_schedule(&flush_work, K_SECONDS(CONFIG_RECORD_STORE_FLUSH_TIMEOUT_SEC));
+
+	return idx;
+}
+
+int record_store_read_range(uint8_t key, uint32_t start, uint16_t count,
+			    uint8_t *buf, size_t buf_len)
+{
+	struct key_state *ks;
+	size_t written = 0;
+	bool full = false;
+
+	if ((key >= ARRAY_SIZE(keys)) || ((buf == NULL) && (buf_len > 0))) {
+		return -EINVAL;
+	}
+
+	if (store_fs == NULL) {
+		return -EACCES;
+	}
+
+	ks = &keys[key];
+
+	k_mutex_lock(&store_lock, K_FOREVER);
+
+	start = MAX(start, ks->meta.first_idx);
+
+	for (uint32_t seq = ks->meta.head;
+	     (seq != ks->meta.tail) && (count > 0) && !full; seq++) {
+		struct block_hdr *hdr = (struct block_hdr *)block_buf;
+		ssize_t len = nvs_read(store_fs, BLOCK_ID(key, seq), block_buf,
+				       sizeof(block_buf));
+
+		if ((len < (ssize_t)sizeof(*hdr)) ||
+		    (len < (ssize_t)(sizeof(*hdr) + hdr->used))) {
+			LOG_ERR("Unable to read block %d of key %d, error: %d", seq, key, len);
+			k_mutex_unlock(&store_lock);
+			return (len < 0) ? len : -EIO;
+		}
+
+		if (start >= (hdr->first_idx + hdr->count)) {
+			continue;
+		}
+
+		written += block_records_copy(hdr, &block_buf[sizeof(*hdr)], &start, &count,
+					      &buf[written], buf_len - written, &full);
+	}
+
+	if ((count > 0) && !full) {
+		written += block_records_copy(&ks->pending.hdr,
+					      &ks->pending.raw[sizeof(struct block_hdr)],
+					      &start, &count, &buf[written], buf_len - written,
+					      &full);
+	}
+
+	k_mutex_unlock(&store_lock);
+
+	return written;
+}
+
+int record_store_range_get(uint8_t key, uint32_t *first, uint32_t *next)
+{
+	if ((key >= ARRAY_SIZE(keys)) || (first == NULL) || (next == NULL)) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&store_lock, K_FOREVER);
+
+	*first = (keys[key].meta.tail == keys[key].meta.head) ?
+		 keys[key].pending.hdr.first_idx : keys[key].meta.first_idx;
+	*next = keys[key].pending.hdr.first_idx + keys[key].pending.hdr.count;
+
+	k_mutex_unlock(&store_lock);
+
+	return 0;
+}
+
+int record_store_flush(void)
+{
+	int err = 0;
+
+	if (store_fs == NULL) {
+		return -EACCES;
+	}
+
+	k_mutex_lock(&store_lock, K_FOREVER);
+
+	for (uint8_t key = 0; key < ARRAY_SIZE(keys); key++) {
+		int ret = key_flush(key);
+
+		if (ret) {
+			err = ret;
+		}
+	}
+
+	k_mutex_unlock(&store_lock);
+
+	return err;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**@file
+ *
+ * @brief   Keyed record store for Asset Tracker v2
+ *
+ * Append-only logs of small records, one log per key, kept on the application NVS partition.
+ * Appended records are coalesced in RAM and written to NVS as a single block entry once the
+ * block is full, the flush timeout expires or a flush is explicitly requested. Each key keeps a
+ * ring of CONFIG_RECORD_STORE_BLOCKS_PER_KEY blocks; the oldest block is dropped when the ring
+ * is full.
+ */
+
+#ifndef RECORD_STORE_H__
+#define RECORD_STORE_H__
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/nvs.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Size of the per record header (record length) stored in front of each record. */
+#define RECORD_STORE_RECORD_HDR_SIZE 1
+
+/** @brief Initialize the record store on an already mounted NVS file system.
+ *
+ *  @param[in] fs Pointer to a mounted NVS file system. Must be valid for the lifetime of
+ *		  the store.
+ *
+ *  @return Zero on success, otherwise a negative error code is returned.
+ */
+int record_store_init(struct nvs_fs *fs);
+
+/** @brief Append a record to the log of a key. The record is buffered in RAM and written
+ *	   to flash together with other records appended to the same key.
+ *
+ *  @param[in] key Log key, must be less than CONFIG_RECORD_STORE_KEY_COUNT.
+ *  @param[in] data Record data.
+ *  @param[in] len Record length, must be between 1 and CONFIG_RECORD_STORE_RECORD_SIZE_MAX.
+ *
+ *  @return Index of the appended record on success, otherwise a negative error code.
+ */
+int record_store_append(uint8_t key, const uint8_t *data, size_t len);
+
+/** @brief Read a range of records from the log of a key. Records that have not yet been
+ *	   flushed are included. Each record is written to the output buffer as a one byte
+ *	   length followed by the record data.
+ *
+ *  @param[in] key Log key.
+ *  @param[in] start Index of the first record to read. Records older than the oldest
+ *		     stored record are skipped.
+ *  @param[in] count Maximum number of records to read.
+ *  @param[out] buf Output buffer.
+ *  @param[in] buf_len Size of the output buffer. Reading stops at the first record that
+ *		       does not fit.
+ *
+ *  @return Number of bytes written to @p buf, otherwise a negative error code.
+ */
+int record_store_read_range(uint8_t key, uint32_t start, uint16_t count,
+			    uint8_t *buf, size_t buf_len);
+
+/** @brief Get the index range of the records stored for a key.
+ *
+ *  @param[in] key Log key.
+ *  @param[out] first Index of the oldest stored record.
+ *  @param[out] next Index that will be assigned to the next appended record.
+ *
+ *  @return Zero on success, otherwise a negative error code.
+ */
+int record_store_range_get(uint8_t key, uint32_t *first, uint32_t *next);
+
+/** @brief Write all buffered records to flash.
+ *
+ *  @return Zero on success, otherwise a negative error code.
+ */
+int record_store_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RECORD_STORE_H__ */
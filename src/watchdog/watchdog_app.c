@@ -8,6 +8,10 @@
 #include <zephyr/device.h>
 #include <zephyr/drivers/watchdog.h>
 
+#if defined(CONFIG_SHELL)
+#include <zephyr/shell/shell.h>
+#endif
+
 #include "watchdog_app.h"
 
 #include <zephyr/logging/log.h>
@@ -18,6 +22,11 @@ LOG_MODULE_REGISTER(watchdog, CONFIG_WATCHDOG_LOG_LEVEL);
 #define WATCHDOG_TIMEOUT_MSEC						\
 	(CONFIG_WATCHDOG_APPLICATION_TIMEOUT_SEC * 1000)
 
+/* Feed worker period while a task channel is stalled, so that feeding resumes quickly if the
+ * channel recovers before the hardware watchdog expires.
+ */
+#define WDT_FEED_WORKER_STALLED_DELAY_MS	1000
+
 struct wdt_config_storage {
 	const struct device *wdt;
 };
@@ -47,12 +56,82 @@ static const struct wdt_config_storage wdt_config = {
 
 static struct wdt_data_storage wdt_data;
 
+/* Task channels. Times are in milliseconds of 32-bit uptime, differences are wrap-safe. */
+struct task_channel {
+	/* NULL if the channel is free. */
+	const char *name;
+	uint32_t timeout;
+	/* Time allowed until the next check-in, the timeout unless it has been extended. */
+	uint32_t deadline;
+	uint32_t last_feed;
+	uint32_t max_latency;
+	/* The thread is waiting for work and is not supervised. */
+	bool paused;
+	bool stalled;
+};
+
+static struct task_channel task_channels[CONFIG_WATCHDOG_TASK_CHANNELS_MAX];
+static struct k_spinlock task_channels_lock;
+
+/* Returns true if every task channel has checked in within its timeout. A stall is reported
+ * once, when it is first detected.
+ */
+static bool task_channels_healthy(void)
+{
+	uint32_t now = k_uptime_get_32();
+	bool healthy = true;
+
+	for (size_t i = 0; i < ARRAY_SIZE(task_channels); i++) {
+		struct task_channel *channel = &task_channels[i];
+		k_spinlock_key_t key = k_spin_lock(&task_channels_lock);
+		const char *name = channel->name;
+		uint32_t since_last = now - channel->last_feed;
+		uint32_t max_latency = channel->max_latency;
+		bool stalled = (name != NULL) && !channel->paused &&
+			       (since_last > channel->deadline);
+		bool report = stalled && !channel->stalled;
+
+		if (stalled) {
+			channel->stalled = true;
+		}
+
+		k_spin_unlock(&task_channels_lock, key);
+
+		if (!stalled) {
+			continue;
+		}
+
+		healthy = false;
+
+		if (report) {
+			struct watchdog_evt evt = {
+				.type = WATCHDOG_EVT_TASK_STALLED,
+				.timeout = since_last,
+				.channel = name,
+			};
+
+			LOG_ERR("Task %s has not checked in for %d ms, max latency %d ms",
+				name, since_last, max_latency);
+			watchdog_notify_event(&evt);
+		}
+	}
+
+	return healthy;
+}
+
 static void primary_feed_worker(struct k_work *work_desc)
 {
 	struct watchdog_evt evt = {
 		.type = WATCHDOG_EVT_FEED,
 	};
 
+	if (!task_channels_healthy()) {
+		LOG_WRN("Task channel stalled, watchdog not fed");
+		k_work_reschedule(&wdt_data.system_workqueue_work,
+				  K_MSEC(WDT_FEED_WORKER_STALLED_DELAY_MS));
+		return;
+	}
+
 	int err = wdt_feed(wdt_config.wdt, wdt_data.wdt_channel_id);
 
 	LOG_DBG("Feeding watchdog");
@@ -224,3 +303,146 @@ void watchdog_register_handler(watchdog_evt_handler_t evt_handler)
 		watchdog_notify_event(&evt);
 	}
 }
+
+int watchdog_channel_add(const char *name, uint32_t timeout_ms)
+{
+	int channel_id = -ENOMEM;
+	k_spinlock_key_t key;
+
+	if ((name == NULL) || (timeout_ms == 0)) {
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&task_channels_lock);
+
+	for (size_t i = 0; i < ARRAY_SIZE(task_channels); i++) {
+		if (task_channels[i].name == NULL) {
+			task_channels[i] = (struct task_channel) {
+				.name = name,
+				.timeout = timeout_ms,
+				.deadline = timeout_ms,
+				.last_feed = k_uptime_get_32(),
+			};
+			channel_id = i;
+			break;
+		}
+	}
+
+	k_spin_unlock(&task_channels_lock, key);
+
+	if (channel_id < 0) {
+		LOG_ERR("No free task channel for %s", name);
+	} else {
+		LOG_DBG("Task channel %d added for %s, timeout: %d ms", channel_id, name,
+			timeout_ms);
+	}
+
+	return channel_id;
+}
+
+/* Check in on a channel. The time spent paused is not latency. */
+static void channel_check_in(int channel_id, uint32_t deadline, bool pause)
+{
+	uint32_t now = k_uptime_get_32();
+	struct task_channel *channel;
+	k_spinlock_key_t key;
+	bool recovered;
+
+	if ((channel_id < 0) || (channel_id >= ARRAY_SIZE(task_channels))) {
+		return;
+	}
+
+	channel = &task_channels[channel_id];
+	key = k_spin_lock(&task_channels_lock);
+
+	if (!channel->paused) {
+		channel->max_latency = MAX(channel->max_latency, now - channel->last_feed);
+	}
+
+	channel->last_feed = now;
+	channel->deadline = (deadline != 0) ? deadline : channel->timeout;
+	channel->paused = pause;
+	recovered = channel->stalled;
+	channel->stalled = false;
+
+	k_spin_unlock(&task_channels_lock, key);
+
+	if (recovered && channel->name) {
+		LOG_WRN("Task %s checked in again", channel->name);
+	}
+}
+
+void watchdog_channel_feed(int channel_id)
+{
+	channel_check_in(channel_id, 0, false);
+}
+
+void watchdog_channel_extend(int channel_id, uint32_t timeout_ms)
+{
+	channel_check_in(channel_id, timeout_ms, false);
+}
+
+void watchdog_channel_pause(int channel_id)
+{
+	channel_check_in(channel_id, 0, true);
+}
+
+void watchdog_channel_delete(int channel_id)
+{
+	k_spinlock_key_t key;
+
+	if ((channel_id < 0) || (channel_id >= ARRAY_SIZE(task_channels))) {
+		return;
+	}
+
+	key = k_spin_lock(&task_channels_lock);
+	task_channels[channel_id].name = NULL;
+	k_spin_unlock(&task_channels_lock, key);
+}
+
+int watchdog_channel_stats_get(int channel_id, struct watchdog_channel_stats *stats)
+{
+	uint32_t now = k_uptime_get_32();
+	k_spinlock_key_t key;
+	int err = 0;
+
+	if ((channel_id < 0) || (channel_id >= ARRAY_SIZE(task_channels))) {
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&task_channels_lock);
+
+	if (task_channels[channel_id].name == NULL) {
+		err = -EINVAL;
+	} else {
+		stats->name = task_channels[channel_id].name;
+		stats->timeout = task_channels[channel_id].timeout;
+		stats->max_latency = task_channels[channel_id].max_latency;
+		stats->since_last = now - task_channels[channel_id].last_feed;
+	}
+
+	k_spin_unlock(&task_channels_lock, key);
+	return err;
+}
+
+#if defined(CONFIG_SHELL)
+static int cmd_watchdog_channels(const struct shell *shell, size_t argc, char **argv)
+{
+	struct watchdog_channel_stats stats;
+
+	shell_print(shell, "%-12s %10s %14s %12s", "channel", "timeout", "max latency",
+		    "last");
+
+	for (int i = 0; i < ARRAY_SIZE(task_channels); i++) {
+		if (watchdog_channel_stats_get(i, &stats) == 0) {
+			shell_print(shell, "%-12s %7u ms %11u ms %9u ms", stats.name,
+				    stats.timeout, stats.max_latency, stats.since_last);
+		}
+	}
+
+	return 0;
+}
+
+SHELL_CMD_REGISTER(watchdog_channels, NULL, "Print the check-in latency of the task channels",
+		   cmd_watchdog_channels);
+#endif /* CONFIG_SHELL */
@@ -21,12 +21,30 @@ extern "C" {
 enum watchdog_evt_type {
 	WATCHDOG_EVT_START,
 	WATCHDOG_EVT_TIMEOUT_INSTALLED,
-	WATCHDOG_EVT_FEED
+	WATCHDOG_EVT_FEED,
+	/** A task channel has not checked in within its timeout. The hardware watchdog is not
+	 *  fed until the channel checks in again. The name of the channel is in channel, and
+	 *  the time since its last check-in in timeout.
+	 */
+	WATCHDOG_EVT_TASK_STALLED
 };
 
 struct watchdog_evt {
 	enum watchdog_evt_type type;
 	uint32_t timeout;
+	const char *channel;
+};
+
+/** Check-in statistics of a task channel. */
+struct watchdog_channel_stats {
+	/** Name of the channel. */
+	const char *name;
+	/** Timeout of the channel in milliseconds. */
+	uint32_t timeout;
+	/** Longest time between two check-ins in milliseconds. */
+	uint32_t max_latency;
+	/** Time since the last check-in in milliseconds. */
+	uint32_t since_last;
 };
 
 /** @brief Watchdog library event handler.
@@ -51,6 +69,53 @@ int watchdog_init_and_start(void);
  */
 void watchdog_register_handler(watchdog_evt_handler_t evt_handler);
 
+/** @brief Add a task channel. The hardware watchdog is only fed while every channel has
+ *	   checked in within its timeout.
+ *
+ *  @param name Name of the channel, used when a stall is reported. Must remain valid.
+ *  @param timeout_ms Maximum time between two check-ins in milliseconds.
+ *
+ *  @return Channel ID if successful, otherwise a negative error code.
+ */
+int watchdog_channel_add(const char *name, uint32_t timeout_ms);
+
+/** @brief Check in on a task channel.
+ *
+ *  @param channel_id Channel ID returned by watchdog_channel_add().
+ */
+void watchdog_channel_feed(int channel_id);
+
+/** @brief Check in on a task channel and allow a longer time until the next check-in, for
+ *	   blocking calls that are known to exceed the timeout of the channel. The timeout of
+ *	   the channel applies again from the next check-in.
+ *
+ *  @param channel_id Channel ID returned by watchdog_channel_add().
+ *  @param timeout_ms Maximum time until the next check-in in milliseconds.
+ */
+void watchdog_channel_extend(int channel_id, uint32_t timeout_ms);
+
+/** @brief Check in on a task channel and stop supervising it until the next check-in, while
+ *	   its thread waits for work.
+ *
+ *  @param channel_id Channel ID returned by watchdog_channel_add().
+ */
+void watchdog_channel_pause(int channel_id);
+
+/** @brief Remove a task channel, for instance when its thread has shut down.
+ *
+ *  @param channel_id Channel ID returned by watchdog_channel_add().
+ */
+void watchdog_channel_delete(int channel_id);
+
+/** @brief Get the check-in statistics of a task channel.
+ *
+ *  @param channel_id Channel ID returned by watchdog_channel_add().
+ *  @param[out] stats Statistics of the channel.
+ *
+ *  @return 0 if successful, -EINVAL if the channel does not exist.
+ */
+int watchdog_channel_stats_get(int channel_id, struct watchdog_channel_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+
+#include "battery_estimator.h"
+
+#define HOUR_MS		(3600LL * MSEC_PER_SEC)
+#define MINUTE_MS	(60LL * MSEC_PER_SEC)
+
+/* Readings, in millivolts under load, that map to a known state of charge in per mille. */
+#define MV_SOC_1000	4150
+#define MV_SOC_991	4144
+#define MV_SOC_974	4132
+#define MV_SOC_970	4130
+#define MV_SOC_900	4081
+#define MV_SOC_800	4010
+#define MV_SOC_500	3790
+#define MV_SOC_8	3000
+#define MV_SOC_0	2950
+
+/* The estimator keeps its state between readings, uptime only moves forward. */
+static int64_t now;
+
+static struct battery_estimate update(uint16_t vdd_mv, int64_t elapsed_ms)
+{
+	struct battery_estimate estimate;
+
+	now += elapsed_ms;
+	battery_estimator_update(vdd_mv, now, &estimate);
+
+	return estimate;
+}
+
+/* Bring the estimator to a fully charged battery with an unknown discharge rate. The battery
+ * is discharged and then charged over full windows, which resets the rate, and the maximum
+ * publication interval has passed, so that the full battery is published.
+ */
+static void test_setup(void)
+{
+	struct battery_estimate estimate;
+
+	(void)update(MV_SOC_8, 25 * HOUR_MS);
+	estimate = update(MV_SOC_1000, 25 * HOUR_MS);
+
+	zassert_equal(estimate.soc, 100, "Unexpected state of charge");
+	zassert_equal(estimate.remaining_h, 0, "Discharge rate not reset");
+	zassert_true(estimate.publish, "Full battery not published");
+}
+
+static void test_teardown(void)
+{
+}
+
+static void test_soc_mapping(void)
+{
+	zassert_equal(update(MV_SOC_1000, MINUTE_MS).soc, 100, "Unexpected state of charge");
+	zassert_equal(update(4200, MINUTE_MS).soc, 100, "Unexpected state of charge");
+	zassert_equal(update(MV_SOC_900, MINUTE_MS).soc, 90, "Unexpected state of charge");
+	zassert_equal(update(MV_SOC_500, MINUTE_MS).soc, 50, "Unexpected state of charge");
+	zassert_equal(update(MV_SOC_8, MINUTE_MS).soc, 1, "Unexpected state of charge");
+	zassert_equal(update(MV_SOC_0, MINUTE_MS).soc, 0, "Unexpected state of charge");
+}
+
+static void test_rate_smoothing(void)
+{
+	struct battery_estimate estimate;
+
+	/* 10 % over 10 hours gives 100 h for the remaining 90 %. */
+	estimate = update(MV_SOC_900, 10 * HOUR_MS);
+	zassert_equal(estimate.remaining_h, 90, "Unexpected remaining life");
+
+	/* 10 % over 5 hours is smoothed with the previous rate to 12.5 % over 10 hours. */
+	estimate = update(MV_SOC_800, 5 * HOUR_MS);
+	zassert_equal(estimate.remaining_h, 64, "Unexpected remaining life");
+}
+
+static void test_rate_unknown_when_flat(void)
+{
+	struct battery_estimate estimate;
+
+	/* No drop over a full window is not a rate, the remaining life stays unknown. */
+	estimate = update(MV_SOC_1000, 2 * HOUR_MS);
+	zassert_equal(estimate.remaining_h, 0, "Remaining life reported without a drop");
+
+	estimate = update(MV_SOC_1000, 4 * HOUR_MS);
+	zassert_equal(estimate.remaining_h, 0, "Remaining life reported without a drop");
+
+	/* The window is kept open until the drop is large enough, 3 % over 12 hours. */
+	estimate = update(MV_SOC_970, 6 * HOUR_MS);
+	zassert_equal(estimate.remaining_h, 388, "Unexpected remaining life");
+}
+
+static void test_publish_gating(void)
+{
+	struct battery_estimate estimate;
+
+	estimate = update(MV_SOC_1000, MINUTE_MS);
+	zassert_false(estimate.publish, "Unchanged estimate published");
+
+	estimate = update(MV_SOC_991, MINUTE_MS);
+	zassert_equal(estimate.soc, 99, "Unexpected state of charge");
+	zassert_false(estimate.publish, "Change below the threshold published");
+
+	estimate = update(MV_SOC_974, MINUTE_MS);
+	zassert_equal(estimate.soc, 97, "Unexpected state of charge");
+	zassert_true(estimate.publish, "Change above the threshold not published");
+
+	estimate = update(MV_SOC_974, MINUTE_MS);
+	zassert_false(estimate.publish, "Unchanged estimate published");
+
+	estimate = update(MV_SOC_974, 24 * HOUR_MS);
+	zassert_true(estimate.publish, "Estimate not published after the maximum interval");
+}
+
+static void test_interval_factor(void)
+{
+	zassert_equal(battery_estimator_interval_factor(100), 1, "Unexpected factor");
+	zassert_equal(battery_estimator_interval_factor(21), 1, "Unexpected factor");
+	zassert_equal(battery_estimator_interval_factor(20), 2, "Unexpected factor");
+	zassert_equal(battery_estimator_interval_factor(6), 2, "Unexpected factor");
+	zassert_equal(battery_estimator_interval_factor(5), 4, "Unexpected factor");
+	zassert_equal(battery_estimator_interval_factor(0), 4, "Unexpected factor");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(battery_estimator,
+		ztest_unit_test_setup_teardown(test_soc_mapping,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_rate_smoothing,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_rate_unknown_when_flat,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_publish_gating,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test(test_interval_factor)
+	);
+
+	ztest_run_test_suite(battery_estimator);
+}
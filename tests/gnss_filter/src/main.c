@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/ztest.h>
+#include <zephyr/kernel.h>
+#include <math.h>
+
+#include "gnss_filter.h"
+
+#define ORIGIN_LAT	63.43
+#define ORIGIN_LONGI	10.39
+
+#define EARTH_RADIUS_M	6371000.0
+#define DEG_TO_RAD	(M_PI / 180.0)
+
+#define ACC_GOOD_M	5.0f
+#define ACC_POOR_M	100.0f
+
+/* Fix timestamps are in uptime and only move forward, the filter keeps its state between
+ * fixes.
+ */
+static int64_t now;
+
+/* Fix at a position given in meters east and north of the origin. */
+static struct cloud_data_gnss fix_get(double east_m, double north_m, float acc,
+				      int64_t elapsed_ms)
+{
+	struct cloud_data_gnss fix = {
+		.pvt = {
+			.acc = acc,
+		},
+	};
+
+	now += elapsed_ms;
+
+	fix.gnss_ts = now;
+	fix.pvt.lat = ORIGIN_LAT + north_m / (EARTH_RADIUS_M * DEG_TO_RAD);
+	fix.pvt.longi = ORIGIN_LONGI +
+			east_m / (EARTH_RADIUS_M * DEG_TO_RAD * cos(ORIGIN_LAT * DEG_TO_RAD));
+
+	return fix;
+}
+
+/* Distance in meters between a fix and a position given in meters east and north of the
+ * origin.
+ */
+static double error_get(const struct cloud_data_gnss *fix, double east_m, double north_m)
+{
+	double x = (fix->pvt.longi - ORIGIN_LONGI) * DEG_TO_RAD * EARTH_RADIUS_M *
+		   cos(ORIGIN_LAT * DEG_TO_RAD);
+	double y = (fix->pvt.lat - ORIGIN_LAT) * DEG_TO_RAD * EARTH_RADIUS_M;
+
+	return hypot(x - east_m, y - north_m);
+}
+
+/* Restart the filter with a fix at the origin, after the reset timeout has passed. */
+static void test_setup(void)
+{
+	struct cloud_data_gnss fix = fix_get(0, 0, ACC_GOOD_M,
+					     (CONFIG_DATA_GNSS_FILTER_RESET_TIMEOUT_SEC + 1) *
+					     MSEC_PER_SEC);
+
+	zassert_true(gnss_filter_process(&fix), "First fix after a reset not reported");
+	zassert_true(error_get(&fix, 0, 0) < 0.01, "First fix after a reset modified");
+}
+
+static void test_teardown(void)
+{
+}
+
+static void test_outlier_rejected(void)
+{
+	struct cloud_data_gnss fix = fix_get(500, 0, ACC_POOR_M, MSEC_PER_SEC);
+
+	zassert_false(gnss_filter_process(&fix), "Fix with poor accuracy reported");
+
+	/* The outlier has not moved the filter, a fix at the origin is not a movement. */
+	fix = fix_get(0, 0, ACC_GOOD_M, MSEC_PER_SEC);
+	zassert_false(gnss_filter_process(&fix), "Outlier was taken into the filter");
+}
+
+static void test_reset_on_time_not_advancing(void)
+{
+	struct cloud_data_gnss fix = fix_get(1000, 0, ACC_GOOD_M, 0);
+
+	zassert_true(gnss_filter_process(&fix), "Fix with the same timestamp not reported");
+	zassert_true(error_get(&fix, 1000, 0) < 0.01, "Fix after a reset modified");
+
+	fix = fix_get(2000, 0, ACC_GOOD_M, -MSEC_PER_SEC);
+	zassert_true(gnss_filter_process(&fix), "Fix with an earlier timestamp not reported");
+	zassert_true(error_get(&fix, 2000, 0) < 0.01, "Fix after a reset modified");
+}
+
+static void test_reset_on_timeout(void)
+{
+	struct cloud_data_gnss fix = fix_get(1000, 1000, ACC_GOOD_M,
+					     (CONFIG_DATA_GNSS_FILTER_RESET_TIMEOUT_SEC + 1) *
+					     MSEC_PER_SEC);
+
+	zassert_true(gnss_filter_process(&fix), "Fix after the reset timeout not reported");
+	zassert_true(error_get(&fix, 1000, 1000) < 0.01, "Fix after a reset modified");
+}
+
+static void test_sparse_fix_not_smoothed(void)
+{
+	struct cloud_data_gnss fix = fix_get(100, 0, ACC_GOOD_M, 120 * MSEC_PER_SEC);
+
+	zassert_true(gnss_filter_process(&fix), "Sparse fix not reported");
+	zassert_true(error_get(&fix, 100, 0) < 0.01, "Sparse fix smoothed");
+}
+
+static void test_stationary_noise_suppressed(void)
+{
+	for (int i = 0; i < 20; i++) {
+		double north = (i % 2) ? 15.0 : -15.0;
+		struct cloud_data_gnss fix = fix_get(0, north, ACC_GOOD_M, MSEC_PER_SEC);
+
+		zassert_false(gnss_filter_process(&fix), "Noise reported as movement");
+	}
+}
+
+static void test_convergence(void)
+{
+	struct cloud_data_gnss last = { 0 };
+	double last_east = 0;
+	double speed = 10.0;
+	int reported = 0;
+
+	/* Constant velocity east, the filter starts from zero velocity and lags behind. */
+	for (int i = 1; i <= 40; i++) {
+		struct cloud_data_gnss fix = fix_get(speed * i, 0, ACC_GOOD_M, MSEC_PER_SEC);
+
+		if (gnss_filter_process(&fix)) {
+			if (reported == 0) {
+				zassert_true(error_get(&fix, speed * i, 0) > 1.0,
+					     "First smoothed fix does not lag");
+			}
+
+			last = fix;
+			last_east = speed * i;
+			reported++;
+		}
+	}
+
+	zassert_true(reported >= 10, "Moving device not reported often enough");
+	zassert_true(error_get(&last, last_east, 0) < 1.0, "Filter has not converged");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(gnss_filter,
+		ztest_unit_test_setup_teardown(test_outlier_rejected,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_reset_on_time_not_advancing,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_reset_on_timeout,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_sparse_fix_not_smoothed,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_stationary_noise_suppressed,
+					       test_setup,
+					       test_teardown),
+		ztest_unit_test_setup_teardown(test_convergence,
+					       test_setup,
+					       test_teardown)
+	);
+
+	ztest_run_test_suite(gnss_filter);
+}
@@ -98,6 +98,18 @@
 					"}"							\
 				"}"
 
+#define TEST_VALIDATE_IMPACT_CAPTURE_JSON_SCHEMA						\
+				"{"								\
+					"\"impact\":{"						\
+						"\"v\":12.3,"					\
+						"\"ts\":1563968747123,"			\
+						"\"dur\":4500,"					\
+						"\"en\":310,"					\
+						"\"type\":2,"					\
+						"\"wid\":7"					\
+					"}"							\
+				"}"
+
 #define TEST_VALIDATE_NEIGHBOR_CELLS_JSON_SCHEMA						\
 				"{"								\
 					"\"mcc\":242,"						\
@@ -590,6 +590,31 @@ static void test_encode_impact_data_object(void)
 	zassert_equal(-EINVAL, ret, "Return value %d is wrong.", ret);
 }
 
+static void test_encode_impact_capture_data_object(void)
+{
+	int ret;
+	struct cloud_data_impact data = {
+		.magnitude = 12.3,
+		.duration_us = 4500,
+		.energy = 310,
+		.type = 2,
+		.window_id = 7,
+		.ts = 1000,
+		.queued = true
+	};
+
+	ret = json_common_impact_data_add(dummy.root_obj,
+				      &data,
+				      JSON_COMMON_ADD_DATA_TO_OBJECT,
+				      DATA_IMPACT,
+				      NULL);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+
+	ret = encoded_output_check(dummy.root_obj, TEST_VALIDATE_IMPACT_CAPTURE_JSON_SCHEMA,
+				   data.queued);
+	zassert_equal(0, ret, "Return value %d is wrong", ret);
+}
+
 /* Neighbor cell */
 
 static void test_encode_neighbor_cells_data_object(void)
@@ -1265,6 +1290,9 @@ void test_main(void)
 		ztest_unit_test_setup_teardown(test_encode_impact_data_array,
 					       test_setup_array,
 					       test_teardown_array),
+		ztest_unit_test_setup_teardown(test_encode_impact_capture_data_object,
+					       test_setup_object,
+					       test_teardown_object),
 
 		/* Neighbor cell */
 		ztest_unit_test_setup_teardown(test_encode_neighbor_cells_data_object,
@@ -18,6 +18,8 @@
 #include "data_module_event.h"
 #include "modem_module_event.h"
 
+#include "src/vars_internal.h"
+
 extern struct event_listener __event_listener_location_module;
 
 /* The addresses of the following structures will be returned when the app_event_manager_alloc()
@@ -35,7 +37,7 @@ static struct data_module_event data_module_event_memory;
  */
 extern void location_event_handler(const struct location_event_data *event_data);
 
-#define LOCATION_MODULE_MAX_EVENTS 5
+#define LOCATION_MODULE_MAX_EVENTS 12
 
 /* Counter for received location module events. */
 static uint32_t location_module_event_count;
@@ -44,7 +46,7 @@ static uint32_t expected_location_module_event_count;
 /* Array for expected location module events. */
 static struct location_module_event expected_location_module_events[LOCATION_MODULE_MAX_EVENTS];
 /* Semaphore for waiting for events to be received. */
-static K_SEM_DEFINE(location_module_event_sem, 0, 5);
+static K_SEM_DEFINE(location_module_event_sem, 0, LOCATION_MODULE_MAX_EVENTS);
 
 /* Dummy functions and objects. */
 
@@ -95,6 +97,10 @@ void setUp(void)
 	location_module_event_count = 0;
 	expected_location_module_event_count = 0;
 	memset(&expected_location_module_events, 0, sizeof(expected_location_module_events));
+
+	/* Forget the cell sets reported by earlier tests. */
+	memset(neighbor_cells_cache, 0, sizeof(neighbor_cells_cache));
+	neighbor_cells_cache_next = 0;
 }
 
 void tearDown(void)
@@ -233,6 +239,7 @@ static void validate_location_module_evt(struct app_event_header *aeh, int no_of
 		break;
 
 	case LOCATION_MODULE_EVT_DATA_NOT_READY:
+	case LOCATION_MODULE_EVT_NEIGHBOR_CELLS_DATA_UNCHANGED:
 	case LOCATION_MODULE_EVT_TIMEOUT:
 	case LOCATION_MODULE_EVT_ACTIVE:
 	case LOCATION_MODULE_EVT_INACTIVE:
@@ -485,6 +492,74 @@ void test_location_cellular(void)
 	location_event_handler(&event_data_undefined);
 }
 
+/* Test that the location module does not forward neighbor cell measurements when the
+ * cell set matches one reported before, even if the neighbor cells are reported in a
+ * different order and RSRP has changed slightly.
+ */
+void test_location_cellular_unchanged(void)
+{
+	struct lte_lc_ncell neighbor_cells[2] = {
+		{2300, 0, 8, 60, 29},
+		{2400, 184, 11, 55, 26}
+	};
+	struct lte_lc_ncell neighbor_cells_reordered[2] = {
+		{2400, 184, 11, 56, 26},
+		{2300, 0, 8, 61, 29}
+	};
+
+	struct lte_lc_cells_info lte_cells = {
+		.current_cell = {
+			262, 95, 0x00011B07, 0x00B7, 2300, 10512, 9034,
+			150344527, 7, 63, 31 },
+		.ncells_count = 2,
+		.neighbor_cells = neighbor_cells
+	};
+	struct lte_lc_cells_info lte_cells_unchanged = {
+		.current_cell = {
+			262, 95, 0x00011B07, 0x00B7, 2300, 10512, 9034,
+			150344527, 7, 64, 31 },
+		.ncells_count = 2,
+		.neighbor_cells = neighbor_cells_reordered
+	};
+
+	/* Set expected location module events. */
+	expected_location_module_event_count = 4;
+	expected_location_module_events[0].type = LOCATION_MODULE_EVT_ACTIVE;
+
+	expected_location_module_events[1].type = LOCATION_MODULE_EVT_NEIGHBOR_CELLS_DATA_READY;
+	expected_location_module_events[1].data.neighbor_cells.cell_data = lte_cells;
+	expected_location_module_events[1].data.neighbor_cells.neighbor_cells[0] =
+		neighbor_cells[0];
+	expected_location_module_events[1].data.neighbor_cells.neighbor_cells[1] =
+		neighbor_cells[1];
+	expected_location_module_events[1].data.neighbor_cells.timestamp = 123456789;
+
+	expected_location_module_events[2].type =
+		LOCATION_MODULE_EVT_NEIGHBOR_CELLS_DATA_UNCHANGED;
+	expected_location_module_events[3].type = LOCATION_MODULE_EVT_INACTIVE;
+
+	/* Set location module into state where location_request() has been called. */
+	setup_location_module_in_active_state();
+
+	__cmock_location_cellular_ext_result_set_Expect(LOCATION_CELLULAR_EXT_RESULT_UNKNOWN, NULL);
+	__cmock_location_cellular_ext_result_set_Expect(LOCATION_CELLULAR_EXT_RESULT_UNKNOWN, NULL);
+
+	/* The first measurement of the cell set is forwarded, the second is not. */
+	struct location_event_data event_data_cellular = {
+		.id = LOCATION_EVT_CELLULAR_EXT_REQUEST,
+		.cellular_request = lte_cells
+	};
+	location_event_handler(&event_data_cellular);
+
+	event_data_cellular.cellular_request = lte_cells_unchanged;
+	location_event_handler(&event_data_cellular);
+
+	struct location_event_data event_data_undefined = {
+		.id = LOCATION_EVT_RESULT_UNKNOWN,
+	};
+	location_event_handler(&event_data_undefined);
+}
+
 /* Test timeout for location request.
  */
 void test_location_fail_timeout(void)
@@ -551,6 +626,178 @@ void test_location_fail_init(void)
 	TEST_ASSERT_EQUAL(0, ret);
 }
 
+/* Configuration of the last location request. */
+static struct location_config location_request_config;
+
+static void location_config_defaults_set_stub(struct location_config *config,
+					      uint8_t methods_count,
+					      enum location_method *method_types,
+					      int num_calls)
+{
+	memset(config, 0, sizeof(*config));
+	config->methods_count = methods_count;
+
+	for (int i = 0; i < methods_count; i++) {
+		config->methods[i].method = method_types[i];
+	}
+}
+
+static int location_request_stub(const struct location_config *config, int num_calls)
+{
+	location_request_config = *config;
+
+	return 0;
+}
+
+static void *event_alloc_stub(size_t size, int num_calls)
+{
+	return malloc(size);
+}
+
+static void event_free_stub(void *addr, int num_calls)
+{
+	free(addr);
+}
+
+/* Set location module into running state in the given cell, with location requests
+ * captured in location_request_config.
+ */
+static void setup_location_module_in_cell(uint32_t cell_id)
+{
+	setup_location_module_in_running_state();
+
+	__cmock_app_event_manager_alloc_Stub(&event_alloc_stub);
+	__cmock_app_event_manager_free_Stub(&event_free_stub);
+	__cmock__event_submit_Stub(&validate_location_module_evt);
+	__cmock_location_config_defaults_set_Stub(&location_config_defaults_set_stub);
+	__cmock_location_request_Stub(&location_request_stub);
+
+	/* Send MODEM_EVT_LTE_CELL_UPDATE. */
+	struct modem_module_event *modem_module_event = new_modem_module_event();
+
+	modem_module_event->type = MODEM_EVT_LTE_CELL_UPDATE;
+	modem_module_event->data.cell.cell_id = cell_id;
+
+	bool ret = LOCATION_MODULE_EVT_HANDLER((struct app_event_header *)modem_module_event);
+
+	app_event_manager_free(modem_module_event);
+
+	TEST_ASSERT_EQUAL(0, ret);
+}
+
+/* Send APP_EVT_DATA_GET with APP_DATA_LOCATION and expect LOCATION_MODULE_EVT_ACTIVE. */
+static void location_request_send(void)
+{
+	struct app_module_event *app_module_event = new_app_module_event();
+
+	expected_location_module_events[expected_location_module_event_count++].type =
+		LOCATION_MODULE_EVT_ACTIVE;
+
+	app_module_event->type = APP_EVT_DATA_GET;
+	app_module_event->count = 1;
+	app_module_event->data_list[0] = APP_DATA_LOCATION;
+
+	bool ret = LOCATION_MODULE_EVT_HANDLER((struct app_event_header *)app_module_event);
+
+	app_event_manager_free(app_module_event);
+
+	TEST_ASSERT_EQUAL(0, ret);
+}
+
+static void location_event_send(enum location_event_id id, enum location_method method)
+{
+	struct location_event_data event_data = {
+		.id = id,
+		.method = method,
+	};
+
+	location_event_handler(&event_data);
+}
+
+/* Test that GNSS is skipped in a cell where it keeps failing, once it has been attempted
+ * often enough.
+ */
+void test_location_method_selection_gnss_skipped(void)
+{
+	setup_location_module_in_cell(0x00022C01);
+
+	for (int i = 0; i < CONFIG_LOCATION_MODULE_METHOD_SELECTION_ATTEMPTS_MIN; i++) {
+		location_request_send();
+		TEST_ASSERT_EQUAL(2, location_request_config.methods_count);
+		TEST_ASSERT_EQUAL(LOCATION_METHOD_GNSS,
+				  location_request_config.methods[0].method);
+
+		expected_location_module_events[expected_location_module_event_count++].type =
+			LOCATION_MODULE_EVT_TIMEOUT;
+		expected_location_module_events[expected_location_module_event_count++].type =
+			LOCATION_MODULE_EVT_INACTIVE;
+		location_event_send(LOCATION_EVT_TIMEOUT, LOCATION_METHOD_GNSS);
+	}
+
+	location_request_send();
+	TEST_ASSERT_EQUAL(1, location_request_config.methods_count);
+	TEST_ASSERT_EQUAL(LOCATION_METHOD_CELLULAR, location_request_config.methods[0].method);
+
+	expected_location_module_events[expected_location_module_event_count++].type =
+		LOCATION_MODULE_EVT_INACTIVE;
+	location_event_send(LOCATION_EVT_RESULT_UNKNOWN, LOCATION_METHOD_CELLULAR);
+}
+
+/* Test that GNSS is not skipped in a cell where cellular keeps failing as well. */
+void test_location_method_selection_cellular_failing(void)
+{
+	setup_location_module_in_cell(0x00022C02);
+
+	for (int i = 0; i < CONFIG_LOCATION_MODULE_METHOD_SELECTION_ATTEMPTS_MIN; i++) {
+		location_request_send();
+
+		/* GNSS has failed when the request times out in cellular. */
+		expected_location_module_events[expected_location_module_event_count++].type =
+			LOCATION_MODULE_EVT_TIMEOUT;
+		expected_location_module_events[expected_location_module_event_count++].type =
+			LOCATION_MODULE_EVT_INACTIVE;
+		location_event_send(LOCATION_EVT_TIMEOUT, LOCATION_METHOD_CELLULAR);
+	}
+
+	location_request_send();
+	TEST_ASSERT_EQUAL(2, location_request_config.methods_count);
+	TEST_ASSERT_EQUAL(LOCATION_METHOD_GNSS, location_request_config.methods[0].method);
+
+	expected_location_module_events[expected_location_module_event_count++].type =
+		LOCATION_MODULE_EVT_INACTIVE;
+	location_event_send(LOCATION_EVT_RESULT_UNKNOWN, LOCATION_METHOD_CELLULAR);
+}
+
+/* Test that GNSS is skipped in a cell where it gets fixes, but each fix costs more charge
+ * than CONFIG_LOCATION_MODULE_METHOD_SELECTION_GNSS_CHARGE_PER_FIX_MAX.
+ */
+void test_location_method_selection_gnss_expensive(void)
+{
+	setup_location_module_in_cell(0x00022C03);
+
+	for (int i = 0; i < CONFIG_LOCATION_MODULE_METHOD_SELECTION_ATTEMPTS_MIN; i++) {
+		location_request_send();
+		TEST_ASSERT_EQUAL(2, location_request_config.methods_count);
+
+		/* 100 ms at 40 mA is 4 mC per fix. */
+		k_sleep(K_MSEC(100));
+
+		expected_location_module_events[expected_location_module_event_count++].type =
+			LOCATION_MODULE_EVT_GNSS_DATA_READY;
+		expected_location_module_events[expected_location_module_event_count++].type =
+			LOCATION_MODULE_EVT_INACTIVE;
+		location_event_send(LOCATION_EVT_LOCATION, LOCATION_METHOD_GNSS);
+	}
+
+	location_request_send();
+	TEST_ASSERT_EQUAL(1, location_request_config.methods_count);
+	TEST_ASSERT_EQUAL(LOCATION_METHOD_CELLULAR, location_request_config.methods[0].method);
+
+	expected_location_module_events[expected_location_module_event_count++].type =
+		LOCATION_MODULE_EVT_INACTIVE;
+	location_event_send(LOCATION_EVT_RESULT_UNKNOWN, LOCATION_METHOD_CELLULAR);
+}
+
 void main(void)
 {
 	(void)unity_main();
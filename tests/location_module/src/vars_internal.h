@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "location_module_event.h"
+
+/* Expose internal variables in location module for testing purposes. */
+extern struct neighbor_cells_cache_entry {
+	/* Fingerprint of the cell set, see neighbor_cells_fingerprint(). */
+	uint32_t fingerprint;
+	/* Uptime when the cell set was last reported. */
+	int64_t uptime;
+	bool valid;
+} neighbor_cells_cache[CONFIG_LOCATION_MODULE_NEIGHBOR_CELLS_CACHE_SIZE];
+
+extern size_t neighbor_cells_cache_next;
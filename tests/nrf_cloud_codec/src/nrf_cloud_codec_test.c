@@ -98,6 +98,28 @@ const static struct cloud_data_battery bat_data_example = {
 	.queued = true,
 };
 
+#define BAT_ESTIMATE_BATCH_EXAMPLE \
+"[{"\
+	"\"appId\":\"BATTERY\","\
+	"\"messageType\":\"DATA\","\
+	"\"ts\":1563968747123,"\
+	"\"data\":\"87\""\
+"},{"\
+	"\"appId\":\"BAT_LIFE\","\
+	"\"messageType\":\"DATA\","\
+	"\"ts\":1563968747123,"\
+	"\"data\":\"1250\""\
+"}]"
+
+const static struct cloud_data_battery bat_estimate_data_example = {
+	.bat = 4080,
+	.bat_ts = 1563968747123,
+	.soc = 87,
+	.rem_h = 1250,
+	.est = true,
+	.queued = true,
+};
+
 #define GNSS_BATCH_EXAMPLE \
 "[{"\
 	"\"appId\":\"GNSS\","\
@@ -510,6 +532,32 @@ void test_enc_batch_data_single_battery(void)
 	TEST_ASSERT_FALSE(bat_buf.queued);
 }
 
+/* tests batch encoding battery data with a state of charge estimate */
+void test_enc_batch_data_single_battery_estimate(void)
+{
+	struct cloud_data_gnss gnss_buf = {0};
+	struct cloud_data_sensors sensor_buf = {0};
+	struct cloud_data_modem_static modem_stat_buf = {0};
+	struct cloud_data_modem_dynamic modem_dyn_buf = {0};
+	struct cloud_data_ui ui_buf = {0};
+	struct cloud_data_impact impact_buf = {0};
+	struct cloud_data_battery bat_buf = bat_estimate_data_example;
+
+	ret = cloud_codec_encode_batch_data(&codec,
+				&gnss_buf,
+				&sensor_buf,
+				&modem_stat_buf,
+				&modem_dyn_buf,
+				&ui_buf,
+				&impact_buf,
+				&bat_buf,
+				1, 1, 1, 1, 1, 1, 1);
+	TEST_ASSERT_EQUAL(EXIT_SUCCESS, ret);
+	TEST_ASSERT_EQUAL(0, strncmp(BAT_ESTIMATE_BATCH_EXAMPLE, codec.buf,
+				     strlen(BAT_ESTIMATE_BATCH_EXAMPLE)));
+	TEST_ASSERT_FALSE(bat_buf.queued);
+}
+
 /* tests batch encoding battery data with a too large value */
 void test_enc_batch_data_single_battery_too_big(void)
 {